@@ -0,0 +1,28 @@
+// @file:     bench_main.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Main function of the pinrouter_bench benchmark harness.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include "bench/bench_runner.h"
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  app.setApplicationName("Pin Routing Benchmark");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Route the sample problems and generated "
+      "problems with every routing algorithm and key router settings, and "
+      "report timings, search counters, peak memory and routing quality.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("in_files", "Additional problem files to "
+      "benchmark (optional).");
+  bench::BenchRunner::addOptions(parser);
+  parser.process(app);
+
+  return bench::BenchRunner::exec(parser);
+}
@@ -0,0 +1,358 @@
+// @file:     bench_runner.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the BenchRunner class.
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <cstdio>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+#include "bench_runner.h"
+#include "router/problem_generator.h"
+
+using namespace bench;
+
+namespace {
+
+  //! Message handler that drops debug output, the router is rather chatty.
+  void quietMessageHandler(QtMsgType type, const QMessageLogContext &,
+      const QString &msg)
+  {
+    if (type != QtDebugMsg) {
+      fprintf(stderr, "%s\n", qPrintable(msg));
+    }
+  }
+
+  //! Quote a CSV field if it contains separators or quotes.
+  QString csvField(const QString &field)
+  {
+    if (!field.contains(',') && !field.contains('"') && !field.contains('\n')) {
+      return field;
+    }
+    return QString("\"%1\"").arg(QString(field).replace("\"", "\"\""));
+  }
+
+}
+
+// BenchResult implementations
+
+QJsonObject BenchResult::toJson() const
+{
+  QJsonObject obj;
+  obj["problem"] = problem;
+  obj["config"] = config;
+  if (!error.isEmpty()) {
+    obj["error"] = error;
+    return obj;
+  }
+  obj["dim_x"] = dim_x;
+  obj["dim_y"] = dim_y;
+  obj["pin_sets"] = pin_sets;
+  obj["repeats"] = repeats;
+  obj["time_ms"] = (double)time_ms;
+  obj["min_time_ms"] = (double)min_time_ms;
+  obj["searches"] = (double)searches;
+  obj["expansions"] = (double)expansions;
+  obj["peak_rss_kb"] = (double)peak_rss_kb;
+  obj["success"] = success;
+  obj["budget_exhausted"] = budget_exhausted;
+  obj["segments"] = segments;
+  obj["routed_cells"] = routed_cells;
+  obj["wirelength"] = (double)wirelength;
+  if (!instrumentation.isEmpty()) {
+    obj["counters"] = instrumentation.total().toJson();
+  }
+  return obj;
+}
+
+QString BenchResult::csvHeader()
+{
+  return "problem,config,error,dim_x,dim_y,pin_sets,repeats,time_ms,min_time_ms,"
+    "searches,expansions,peak_rss_kb,success,budget_exhausted,segments,"
+    "routed_cells,wirelength";
+}
+
+QString BenchResult::csvRow() const
+{
+  QStringList fields;
+  fields << csvField(problem) << csvField(config) << csvField(error)
+    << QString::number(dim_x) << QString::number(dim_y)
+    << QString::number(pin_sets) << QString::number(repeats)
+    << QString::number(time_ms) << QString::number(min_time_ms)
+    << QString::number(searches) << QString::number(expansions)
+    << QString::number(peak_rss_kb) << QString::number(success)
+    << QString::number(budget_exhausted) << QString::number(segments)
+    << QString::number(routed_cells) << QString::number(wirelength);
+  return fields.join(',');
+}
+
+// BenchRunner implementations
+
+BenchRunner::BenchRunner(int repeats)
+  : repeats(qMax(1, repeats))
+{}
+
+QList<BenchConfig> BenchRunner::configurations()
+{
+  QList<BenchConfig> configs;
+  QList<QPair<rt::AvailAlg, QString>> algs = {
+    {rt::AStar, "astar"},
+    {rt::LeeMoore, "lee-moore"},
+  };
+  for (const auto &alg : algs) {
+    BenchConfig config;
+    config.settings.use_alg = alg.first;
+    config.settings.log_level = rt::LogNone;
+    config.settings.gui_update_level = rt::VisualizeNone;
+
+    config.name = alg.second;
+    configs.append(config);
+
+    BenchConfig lower_cost = config;
+    lower_cost.name = alg.second + "-lower-cost";
+    lower_cost.settings.routed_cells_lower_cost = true;
+    configs.append(lower_cost);
+
+    BenchConfig no_rip = config;
+    no_rip.name = alg.second + "-no-rip";
+    no_rip.settings.rip_and_reroute = false;
+    configs.append(no_rip);
+
+    BenchConfig no_reorder = config;
+    no_reorder.name = alg.second + "-no-reorder";
+    no_reorder.settings.net_reordering = false;
+    configs.append(no_reorder);
+  }
+  return configs;
+}
+
+QStringList BenchRunner::sampleProblems()
+{
+  QDir dir(":/sample_problems");
+  QStringList paths;
+  for (const QString &name : dir.entryList(QDir::Files, QDir::Name)) {
+    paths.append(dir.filePath(name));
+  }
+  return paths;
+}
+
+QString BenchRunner::syntheticProblem(int size, quint32 seed)
+{
+  if (!gen_dir.isValid()) {
+    return QString();
+  }
+
+  // about one pin per 512 cells with the default obstructions and spans
+  rt::GeneratorSettings settings;
+  settings.dim_x = size;
+  settings.dim_y = size;
+  settings.net_count = qMax(2, size*size / 1536);
+  settings.seed = seed;
+  QString path = QDir(gen_dir.path()).filePath(
+      QString("synthetic_%1_s%2.pbin").arg(size).arg(seed));
+  QString error;
+  if (!rt::ProblemGenerator::generateFile(settings, path, &error)) {
+    qCritical() << error;
+    return QString();
+  }
+  return path;
+}
+
+BenchResult BenchRunner::run(const QString &in_path, const BenchConfig &config) const
+{
+  BenchResult result;
+  result.problem = QFileInfo(in_path).completeBaseName();
+  result.config = config.name;
+  rt::Problem problem;
+  if (!rt::loadProblem(in_path, &problem, &result.error)) {
+    return result;
+  }
+  result.dim_x = problem.dimensions().x;
+  result.dim_y = problem.dimensions().y;
+  result.pin_sets = problem.pinSets().size();
+  result.repeats = repeats;
+
+  // routing is deterministic, so the counters and quality are taken from the
+  // first run while the timings of all runs are kept
+  QVector<qint64> times;
+  for (int i=0; i<repeats; i++) {
+    resetPeakRss();
+    rt::RouteOutput output = rt::routeProblem(problem, config.settings);
+    times.append(output.stats.time_ms);
+    result.peak_rss_kb = qMax(result.peak_rss_kb, peakRssKb());
+    if (i == 0) {
+      result.searches = output.stats.searches;
+      result.expansions = output.stats.expansions;
+      result.success = output.stats.success;
+      result.budget_exhausted = output.stats.budget_exhausted;
+      result.segments = output.stats.segments;
+      result.routed_cells = output.stats.routed_cells;
+      result.wirelength = output.grid->wirelength();
+      result.instrumentation = output.stats.instrumentation;
+    }
+  }
+  std::sort(times.begin(), times.end());
+  result.time_ms = times[times.size()/2];
+  result.min_time_ms = times.first();
+  return result;
+}
+
+qint64 BenchRunner::peakRssKb()
+{
+#ifdef Q_OS_LINUX
+  // VmHWM can be reset by resetPeakRss, unlike ru_maxrss
+  QFile status("/proc/self/status");
+  if (status.open(QFile::ReadOnly | QFile::Text)) {
+    for (const QByteArray &line : status.readAll().split('\n')) {
+      if (line.startsWith("VmHWM:")) {
+        return line.mid(6).trimmed().split(' ').first().toLongLong();
+      }
+    }
+  }
+#endif
+#ifdef Q_OS_UNIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MAC
+    return usage.ru_maxrss / 1024;  // reported in bytes
+#else
+    return usage.ru_maxrss;         // reported in KB
+#endif
+  }
+#endif
+  return -1;
+}
+
+bool BenchRunner::resetPeakRss()
+{
+#ifdef Q_OS_LINUX
+  QFile clear_refs("/proc/self/clear_refs");
+  if (clear_refs.open(QFile::WriteOnly)) {
+    return clear_refs.write("5") == 1;
+  }
+#endif
+  return false;
+}
+
+void BenchRunner::addOptions(QCommandLineParser &parser)
+{
+  parser.addOptions({
+      {"csv", "Write the report as CSV to this file (defaults to stdout if "
+        "no JSON report is requested either).", "path"},
+      {"json", "Write the report as JSON to this file.", "path"},
+      {"synthetic", "Comma separated sizes of the generated square problems, "
+        "or none (defaults to 128,512).", "sizes"},
+      {"seed", "Seed of the generated problems (defaults to 1).", "seed"},
+      {"no-samples", "Leave out the bundled sample problems."},
+      {"filter", "Only run problems and configurations whose names contain "
+        "this text, e.g. a problem name or astar.", "text"},
+      {"repeat", "Number of timed runs per problem and configuration, the "
+        "median time is reported (defaults to 1).", "count"},
+      {"time-budget", "Wall-clock routing budget per run in ms.", "ms"},
+      {"verbose", "Show router debug output."},
+  });
+}
+
+int BenchRunner::exec(const QCommandLineParser &parser)
+{
+  if (!parser.isSet("verbose")) {
+    qInstallMessageHandler(quietMessageHandler);
+  }
+
+  BenchRunner runner(parser.isSet("repeat") ? parser.value("repeat").toInt() : 1);
+
+  // collect the problems
+  QStringList in_paths;
+  if (!parser.isSet("no-samples")) {
+    in_paths += sampleProblems();
+  }
+  QString sizes = parser.isSet("synthetic") ? parser.value("synthetic") : "128,512";
+  quint32 seed = parser.isSet("seed") ? parser.value("seed").toUInt() : 1;
+  if (sizes.toLower() != "none") {
+    for (const QString &size_str : sizes.split(',', QString::SkipEmptyParts)) {
+      int size = size_str.trimmed().toInt();
+      QString path = runner.syntheticProblem(size, seed);
+      if (path.isEmpty()) {
+        qCritical() << QObject::tr("Unable to generate a problem of size %1.")
+          .arg(size_str);
+        return 1;
+      }
+      in_paths.append(path);
+    }
+  }
+  in_paths += parser.positionalArguments();
+
+  QList<BenchConfig> configs = configurations();
+  if (parser.isSet("time-budget")) {
+    for (BenchConfig &config : configs) {
+      config.settings.time_budget_ms = parser.value("time-budget").toLongLong();
+    }
+  }
+  QString filter = parser.value("filter");
+
+  // open the reports before spending any time on routing
+  QFile csv_file, json_file;
+  if (parser.isSet("csv")) {
+    csv_file.setFileName(parser.value("csv"));
+    if (!csv_file.open(QFile::WriteOnly | QFile::Text)) {
+      qCritical() << QObject::tr("Unable to open %1 for writing.").arg(parser.value("csv"));
+      return 1;
+    }
+  } else if (!parser.isSet("json")) {
+    csv_file.open(stdout, QFile::WriteOnly | QFile::Text);
+  }
+  if (parser.isSet("json")) {
+    json_file.setFileName(parser.value("json"));
+    if (!json_file.open(QFile::WriteOnly | QFile::Text)) {
+      qCritical() << QObject::tr("Unable to open %1 for writing.").arg(parser.value("json"));
+      return 1;
+    }
+  }
+  QTextStream csv(&csv_file);
+  if (csv_file.isOpen()) {
+    csv << BenchResult::csvHeader() << "\n";
+  }
+
+  // run every combination, writing CSV rows as they complete
+  QJsonArray json_results;
+  bool all_loaded = true;
+  for (const QString &in_path : in_paths) {
+    QString problem_name = QFileInfo(in_path).completeBaseName();
+    for (const BenchConfig &config : configs) {
+      if (!filter.isEmpty() && !problem_name.contains(filter)
+          && !config.name.contains(filter)) {
+        continue;
+      }
+      fprintf(stderr, "%s / %s\n", qPrintable(problem_name), qPrintable(config.name));
+      BenchResult result = runner.run(in_path, config);
+      all_loaded &= result.error.isEmpty();
+      if (csv_file.isOpen()) {
+        csv << result.csvRow() << "\n";
+        csv.flush();
+      }
+      json_results.append(result.toJson());
+    }
+  }
+
+  if (json_file.isOpen()) {
+    QJsonObject report;
+    report["api_version"] = PINROUTER_CORE_API_VERSION;
+    report["qt_version"] = QString(qVersion());
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["seed"] = (double)seed;
+    report["results"] = json_results;
+    json_file.write(QJsonDocument(report).toJson());
+  }
+  return all_loaded ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// @file:     bench_runner.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Benchmark harness that routes sample and synthetic problems
+//            under a matrix of router settings.
+
+#ifndef _BENCH_BENCH_RUNNER_H_
+#define _BENCH_BENCH_RUNNER_H_
+
+#include <QCommandLineParser>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include "router/route_api.h"
+
+namespace bench {
+
+  //! A named router configuration that every benchmark problem is routed with.
+  struct BenchConfig
+  {
+    QString name;                 //!< Configuration name used in reports.
+    rt::RouterSettings settings;  //!< Router settings of the configuration.
+  };
+
+  //! Measurements of routing one problem with one configuration.
+  struct BenchResult
+  {
+    //! Return the result as a JSON object.
+    QJsonObject toJson() const;
+
+    //! Return the column names of the CSV report.
+    static QString csvHeader();
+
+    //! Return the result as a line of the CSV report.
+    QString csvRow() const;
+
+    QString problem;        //!< Problem name.
+    QString config;         //!< Configuration name.
+    QString error;          //!< Why the problem couldn't be loaded, if it couldn't.
+    int dim_x=0;            //!< x size of the problem.
+    int dim_y=0;            //!< y size of the problem.
+    int pin_sets=0;         //!< Number of nets.
+    int repeats=0;          //!< Number of timed runs.
+    qint64 time_ms=0;       //!< Median wall-clock routing time.
+    qint64 min_time_ms=0;   //!< Fastest wall-clock routing time.
+    qint64 searches=0;      //!< Pin pair searches run.
+    qint64 expansions=0;    //!< Cells expanded by the searches.
+    qint64 peak_rss_kb=-1;  //!< Peak resident set size, -1 if unavailable.
+    bool success=false;     //!< Whether all pins were routed.
+    bool budget_exhausted=false;  //!< Whether routing was cut short by the budget.
+    int segments=0;         //!< Routed segments in the final grid.
+    int routed_cells=0;     //!< Routed cells in the final grid.
+    qint64 wirelength=0;    //!< Wire length of all nets in the final grid.
+    rt::RouteInstrumentation instrumentation; //!< Counters and timers of the first run.
+  };
+
+  //! Route every benchmark problem with every configuration, one run at a
+  //! time so that timings and memory measurements don't interfere. The
+  //! problems are the bundled sample problems, synthetic problems generated
+  //! on the fly and any problem files provided on the command line.
+  class BenchRunner
+  {
+  public:
+
+    //! Constructor taking the number of timed runs per problem and
+    //! configuration (at least one).
+    BenchRunner(int repeats=1);
+
+    //! Return the configurations that problems are routed with: every
+    //! algorithm with the default settings and with each of the key settings
+    //! flipped.
+    static QList<BenchConfig> configurations();
+
+    //! Return the paths of the bundled sample problems.
+    static QStringList sampleProblems();
+
+    //! Generate a random size by size problem with the provided seed (see
+    //! rt::ProblemGenerator) and return its path, which stays valid for the
+    //! lifetime of this runner. Return an empty string if the problem can't
+    //! be generated or written.
+    QString syntheticProblem(int size, quint32 seed);
+
+    //! Route the problem at the provided path with the provided configuration
+    //! and return the measurements.
+    BenchResult run(const QString &in_path, const BenchConfig &config) const;
+
+    //! Return the peak resident set size of the process in KB, or -1 if it
+    //! can't be determined on this platform.
+    static qint64 peakRssKb();
+
+    //! Reset the peak resident set size so that the next reading covers only
+    //! what follows. Return false if the platform doesn't support it, in
+    //! which case peakRssKb() reports the peak of the whole process.
+    static bool resetPeakRss();
+
+    //! Register the benchmark command line options.
+    static void addOptions(QCommandLineParser &parser);
+
+    //! Run the benchmark as specified by an already processed parser. Returns
+    //! the process exit code.
+    static int exec(const QCommandLineParser &parser);
+
+  private:
+
+    // Private variables
+    int repeats;            //!< Number of timed runs per problem and configuration.
+    QTemporaryDir gen_dir;  //!< Directory that synthetic problems are written to.
+  };
+
+}
+
+#endif
@@ -0,0 +1,120 @@
+// @file:     gen_main.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Main function of the pinrouter_gen problem generator.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <cstdio>
+
+#include "router/problem_generator.h"
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+  app.setApplicationName("Pin Routing Problem Generator");
+
+  rt::GeneratorSettings defaults;
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Generate a random routing problem. Paths "
+      "ending with .pbin are written in the binary problem format, others in "
+      "the text format.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("out_file", "Path to write the problem to.");
+  parser.addOptions({
+      {"size", QString("Grid size as <x>x<y> or a single side (defaults to "
+        "%1x%2).").arg(defaults.dim_x).arg(defaults.dim_y), "size"},
+      {"density", QString("Fraction of obstructed cells (defaults to %1).")
+        .arg(defaults.obs_density), "fraction"},
+      {"clustering", "Obstruction clustering between 0 (single cells) and 1 "
+        "(blocks of up to --cluster-size cells a side), defaults to 0.", "amount"},
+      {"cluster-size", QString("Largest side of an obstruction block (defaults "
+        "to %1).").arg(defaults.max_cluster_size), "cells"},
+      {"nets", QString("Number of nets (defaults to %1).").arg(defaults.net_count),
+        "count"},
+      {"min-pins", QString("Fewest pins per net (defaults to %1).")
+        .arg(defaults.min_pins), "count"},
+      {"max-pins", QString("Most pins per net (defaults to %1).")
+        .arg(defaults.max_pins), "count"},
+      {"min-span", QString("Smallest side of the window that a net's pins are "
+        "placed in (defaults to %1).").arg(defaults.min_span), "cells"},
+      {"max-span", "Largest side of a net's window (defaults to the grid size).",
+        "cells"},
+      {"span-dist", "Distribution of net spans: log (default, short nets are "
+        "more common) or uniform.", "dist"},
+      {"seed", QString("Random seed (defaults to %1).").arg(defaults.seed), "seed"},
+  });
+  parser.process(app);
+
+  if (parser.positionalArguments().size() != 1) {
+    qCritical() << "Exactly one output file is required.";
+    return 1;
+  }
+
+  // read the generator settings
+  rt::GeneratorSettings settings;
+  if (parser.isSet("size")) {
+    QStringList dims = parser.value("size").toLower().split('x');
+    settings.dim_x = dims.first().toInt();
+    settings.dim_y = dims.last().toInt();
+  }
+  if (parser.isSet("density")) {
+    settings.obs_density = parser.value("density").toDouble();
+  }
+  if (parser.isSet("clustering")) {
+    settings.obs_clustering = parser.value("clustering").toDouble();
+  }
+  if (parser.isSet("cluster-size")) {
+    settings.max_cluster_size = parser.value("cluster-size").toInt();
+  }
+  if (parser.isSet("nets")) {
+    settings.net_count = parser.value("nets").toInt();
+  }
+  if (parser.isSet("min-pins")) {
+    settings.min_pins = parser.value("min-pins").toInt();
+  }
+  if (parser.isSet("max-pins")) {
+    settings.max_pins = parser.value("max-pins").toInt();
+  }
+  if (parser.isSet("min-span")) {
+    settings.min_span = parser.value("min-span").toInt();
+  }
+  if (parser.isSet("max-span")) {
+    settings.max_span = parser.value("max-span").toInt();
+  }
+  QString span_dist = parser.value("span-dist").toLower();
+  if (span_dist.isEmpty() || span_dist == "log") {
+    settings.span_dist = rt::GeneratorSettings::LogUniformSpan;
+  } else if (span_dist == "uniform") {
+    settings.span_dist = rt::GeneratorSettings::UniformSpan;
+  } else {
+    qCritical() << QObject::tr("Unknown span distribution %1.").arg(span_dist);
+    return 1;
+  }
+  if (parser.isSet("seed")) {
+    settings.seed = parser.value("seed").toUInt();
+  }
+
+  // generate and write the problem
+  QString out_path = parser.positionalArguments().first();
+  rt::Problem problem;
+  QString error;
+  if (!rt::ProblemGenerator::generate(settings, &problem, &error)) {
+    qCritical() << error;
+    return 1;
+  }
+  if (!problem.writeProblem(out_path, rt::Problem::formatForPath(out_path))) {
+    qCritical() << QObject::tr("Unable to write %1.").arg(out_path);
+    return 1;
+  }
+  int pin_count = 0;
+  for (const sp::PinSet &pin_set : problem.pinSets()) {
+    pin_count += pin_set.size();
+  }
+  fprintf(stderr, "%s: %dx%d grid, %d nets, %d pins\n", qPrintable(out_path),
+      problem.dimensions().x, problem.dimensions().y, problem.pinSets().size(),
+      pin_count);
+  return 0;
+}
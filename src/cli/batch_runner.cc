@@ -0,0 +1,317 @@
+// @file:     batch_runner.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the BatchRunner class.
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QJsonDocument>
+#include <QDebug>
+#include <algorithm>
+#include <cstdio>
+#include "batch_runner.h"
+#include "router/solution_io.h"
+
+using namespace cli;
+
+namespace {
+
+  //! Route one problem file on a pool thread and report the result.
+  class BatchTask : public QRunnable
+  {
+  public:
+    BatchTask(const QString &in_path, const rt::RouterSettings &settings,
+        const QString &solution_dir, const QString &prior_dir,
+        const QString &step_log_dir, const QString &trace_dir,
+        BatchResult *result, QTextStream *out, QMutex *out_mutex)
+      : in_path(in_path), settings(settings), solution_dir(solution_dir),
+        prior_dir(prior_dir), step_log_dir(step_log_dir), trace_dir(trace_dir),
+        result(result), out(out), out_mutex(out_mutex) {};
+
+    void run() override
+    {
+      *result = BatchRunner::routeFile(in_path, settings, solution_dir,
+          prior_dir, step_log_dir, trace_dir);
+      QByteArray line = QJsonDocument(result->toJson()).toJson(QJsonDocument::Compact);
+      QMutexLocker locker(out_mutex);
+      (*out) << line << "\n";
+      out->flush();
+    }
+
+  private:
+    QString in_path;
+    rt::RouterSettings settings;
+    QString solution_dir;
+    QString prior_dir;
+    QString step_log_dir;
+    QString trace_dir;
+    BatchResult *result;
+    QTextStream *out;
+    QMutex *out_mutex;
+  };
+
+  //! Message handler that drops debug output, the router is rather chatty.
+  void quietMessageHandler(QtMsgType type, const QMessageLogContext &,
+      const QString &msg)
+  {
+    if (type != QtDebugMsg) {
+      fprintf(stderr, "%s\n", qPrintable(msg));
+    }
+  }
+
+}
+
+QJsonObject BatchResult::toJson() const
+{
+  QJsonObject obj;
+  obj["in_path"] = in_path;
+  obj["loaded"] = loaded;
+  obj["valid"] = valid;
+  if (!error.isEmpty()) {
+    obj["error"] = error;
+  }
+  obj["success"] = success;
+  obj["segments"] = segments;
+  obj["routed_cells"] = routed_cells;
+  obj["time_ms"] = (double)time_ms;
+  obj["expansions"] = (double)expansions;
+  obj["budget_exhausted"] = budget_exhausted;
+  if (!solution_path.isEmpty()) {
+    obj["solution_path"] = solution_path;
+  }
+  if (!step_log_path.isEmpty()) {
+    obj["step_log_path"] = step_log_path;
+  }
+  if (!trace_path.isEmpty()) {
+    obj["trace_path"] = trace_path;
+  }
+  if (incremental) {
+    obj["kept_connections"] = kept_connections;
+    obj["invalidated_connections"] = invalidated_connections;
+  }
+  if (!instrumentation.isEmpty()) {
+    obj["counters"] = instrumentation.toJson();
+  }
+  return obj;
+}
+
+BatchRunner::BatchRunner(const rt::RouterSettings &settings, int thread_count,
+    const QString &solution_dir, const QString &prior_dir,
+    const QString &step_log_dir, const QString &trace_dir)
+  : settings(settings), thread_count(thread_count), solution_dir(solution_dir),
+    prior_dir(prior_dir), step_log_dir(step_log_dir), trace_dir(trace_dir)
+{
+  // step logging and real time updates are of no use without a GUI, unless
+  // steps are logged to disk
+  if (step_log_dir.isEmpty()) {
+    this->settings.log_level = rt::LogNone;
+  }
+  this->settings.gui_update_level = rt::VisualizeNone;
+  if (this->thread_count < 1) {
+    this->thread_count = QThread::idealThreadCount();
+  }
+}
+
+QList<BatchResult> BatchRunner::run(const QStringList &in_paths, QTextStream &out)
+{
+  QVector<BatchResult> results(in_paths.size());
+  QMutex out_mutex;
+  QThreadPool pool;
+  pool.setMaxThreadCount(thread_count);
+  for (int i=0; i<in_paths.size(); i++) {
+    // each task writes to its own result slot
+    pool.start(new BatchTask(in_paths[i], settings, solution_dir, prior_dir,
+          step_log_dir, trace_dir, &results[i], &out, &out_mutex));
+  }
+  pool.waitForDone();
+  return results.toList();
+}
+
+BatchResult BatchRunner::routeFile(const QString &in_path,
+    const rt::RouterSettings &settings, const QString &solution_dir,
+    const QString &prior_dir, const QString &step_log_dir,
+    const QString &trace_dir)
+{
+  BatchResult result;
+  result.in_path = in_path;
+
+  rt::Problem problem;
+  result.loaded = problem.readProblem(in_path);
+  result.valid = result.loaded && problem.isValid();
+  if (!result.valid) {
+    result.error = result.loaded ? problem.validationError() : problem.lastError();
+    return result;
+  }
+
+  QString base_name = QFileInfo(in_path).completeBaseName();
+  rt::RouterSettings run_settings = settings;
+  if (!step_log_dir.isEmpty()) {
+    run_settings.step_log_path = QDir(step_log_dir).filePath(base_name + ".rlog");
+    result.step_log_path = run_settings.step_log_path;
+  }
+  if (!trace_dir.isEmpty()) {
+    run_settings.trace_path = QDir(trace_dir).filePath(base_name + ".json");
+    result.trace_path = run_settings.trace_path;
+  }
+  rt::RouteOutput output;
+  rt::SolutionFile prior;
+  if (!prior_dir.isEmpty() && prior.load(QDir(prior_dir).filePath(base_name + ".rsol"))) {
+    result.incremental = true;
+    output = rt::rerouteProblem(problem, prior.connections(), run_settings);
+    result.kept_connections = output.stats.kept_connections;
+    result.invalidated_connections = output.stats.invalidated_connections;
+  } else {
+    output = rt::routeProblem(problem, run_settings);
+  }
+  result.success = output.stats.success;
+  result.time_ms = output.stats.time_ms;
+  result.segments = output.stats.segments;
+  result.routed_cells = output.stats.routed_cells;
+  result.expansions = output.stats.expansions;
+  result.budget_exhausted = output.stats.budget_exhausted;
+  result.instrumentation = output.stats.instrumentation;
+
+  if (!solution_dir.isEmpty()) {
+    rt::SolutionInfo info;
+    info.dim_x = problem.dimensions().x;
+    info.dim_y = problem.dimensions().y;
+    info.pin_sets = problem.pinSets();
+    info.alg = settings.use_alg;
+    info.stats = output.stats;
+    QString sol_path = QDir(solution_dir).filePath(base_name + ".rsol");
+    if (rt::SolutionWriter::writeGrid(sol_path, info, output.grid.data())) {
+      result.solution_path = sol_path;
+    }
+  }
+  return result;
+}
+
+int BatchRunner::exitCode(const QList<BatchResult> &results)
+{
+  bool all_valid = std::all_of(results.begin(), results.end(),
+      [](const BatchResult &result){return result.valid;});
+  return all_valid ? 0 : 1;
+}
+
+void BatchRunner::addOptions(QCommandLineParser &parser)
+{
+  parser.addOptions({
+      {"batch", "Route the provided problem files without the GUI, writing "
+        "one JSON line per problem."},
+      {"threads", "Number of worker threads in batch mode (defaults to the "
+        "number of cores).", "count"},
+      {"output", "Write batch results to this file instead of stdout.", "path"},
+      {"verbose", "Show router debug output in batch mode."},
+      {"alg", "Routing algorithm: astar or lee-moore (defaults to astar).", "alg"},
+      {"routed-cells-lower-cost", "Existing routes have lower traverse cost."},
+      {"no-net-reordering", "Disable net reordering."},
+      {"no-rip-and-reroute", "Disable rip and reroute."},
+      {"max-reruns", "Maximum global reroute count.", "count"},
+      {"rip-count", "Maximum rip and reroute attempts per route.", "count"},
+      {"time-budget", "Wall-clock routing budget per problem in ms.", "ms"},
+      {"expansion-budget", "Maximum cell expansions per problem.", "count"},
+      {"solution-dir", "Write a solution file per problem to this directory.",
+        "dir"},
+      {"prior-dir", "Reroute each problem incrementally on top of the solution "
+        "file of the same name in this directory, if there is one.", "dir"},
+      {"step-log", "Write a step log per problem to this directory, which can "
+        "be opened in the GUI.", "dir"},
+      {"step-log-detail", "Detail of step logs: all (including the working "
+        "values of every search step), coarse (default) or results.", "level"},
+      {"trace", "Write a Chrome trace-event timeline of router phases per "
+        "problem to this directory.", "dir"},
+  });
+}
+
+int BatchRunner::exec(const QCommandLineParser &parser)
+{
+  if (!parser.isSet("verbose")) {
+    qInstallMessageHandler(quietMessageHandler);
+  }
+
+  const QStringList in_paths = parser.positionalArguments();
+  if (in_paths.isEmpty()) {
+    qCritical() << "Batch mode requires at least one input file.";
+    return 1;
+  }
+
+  // read router settings
+  rt::RouterSettings settings;
+  QString alg = parser.value("alg").toLower();
+  if (alg == "lee-moore") {
+    settings.use_alg = rt::LeeMoore;
+  } else if (alg.isEmpty() || alg == "astar") {
+    settings.use_alg = rt::AStar;
+  } else {
+    qCritical() << QObject::tr("Unknown routing algorithm %1.").arg(alg);
+    return 1;
+  }
+  settings.routed_cells_lower_cost = parser.isSet("routed-cells-lower-cost");
+  settings.net_reordering = !parser.isSet("no-net-reordering");
+  settings.rip_and_reroute = !parser.isSet("no-rip-and-reroute");
+  if (parser.isSet("max-reruns")) {
+    settings.max_rerun_count = parser.value("max-reruns").toInt();
+  }
+  if (parser.isSet("rip-count")) {
+    settings.rip_and_rerout_count = parser.value("rip-count").toInt();
+  }
+  if (parser.isSet("time-budget")) {
+    settings.time_budget_ms = parser.value("time-budget").toLongLong();
+  }
+  if (parser.isSet("expansion-budget")) {
+    settings.expansion_budget = parser.value("expansion-budget").toLongLong();
+  }
+  QString log_detail = parser.value("step-log-detail").toLower();
+  if (log_detail == "all") {
+    settings.log_level = rt::LogAllIntermediate;
+  } else if (log_detail.isEmpty() || log_detail == "coarse") {
+    settings.log_level = rt::LogCoarseIntermediate;
+  } else if (log_detail == "results") {
+    settings.log_level = rt::LogResultsOnly;
+  } else {
+    qCritical() << QObject::tr("Unknown step log detail %1.").arg(log_detail);
+    return 1;
+  }
+  int thread_count = parser.value("threads").toInt();
+
+  // prepare output
+  QFile out_file;
+  if (parser.isSet("output")) {
+    out_file.setFileName(parser.value("output"));
+    if (!out_file.open(QFile::WriteOnly | QFile::Text)) {
+      qCritical() << QObject::tr("Unable to open %1 for writing.")
+        .arg(parser.value("output"));
+      return 1;
+    }
+  } else {
+    out_file.open(stdout, QFile::WriteOnly | QFile::Text);
+  }
+  QTextStream out(&out_file);
+
+  // route
+  QString solution_dir = parser.value("solution-dir");
+  if (!solution_dir.isEmpty() && !QDir().mkpath(solution_dir)) {
+    qCritical() << QObject::tr("Unable to create %1.").arg(solution_dir);
+    return 1;
+  }
+  QString step_log_dir = parser.value("step-log");
+  if (!step_log_dir.isEmpty() && !QDir().mkpath(step_log_dir)) {
+    qCritical() << QObject::tr("Unable to create %1.").arg(step_log_dir);
+    return 1;
+  }
+  QString trace_dir = parser.value("trace");
+  if (!trace_dir.isEmpty() && !QDir().mkpath(trace_dir)) {
+    qCritical() << QObject::tr("Unable to create %1.").arg(trace_dir);
+    return 1;
+  }
+  BatchRunner runner(settings, thread_count, solution_dir,
+      parser.value("prior-dir"), step_log_dir, trace_dir);
+  return exitCode(runner.run(in_paths, out));
+}
@@ -0,0 +1,101 @@
+// @file:     batch_runner.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Headless batch routing of problem files from the command line.
+
+#ifndef _CLI_BATCH_RUNNER_H_
+#define _CLI_BATCH_RUNNER_H_
+
+#include <QCommandLineParser>
+#include <QJsonObject>
+#include <QTextStream>
+#include "router/route_api.h"
+
+namespace cli {
+
+  //! Outcome of routing a single problem file in batch mode.
+  struct BatchResult
+  {
+    //! Return the result as a JSON object.
+    QJsonObject toJson() const;
+
+    QString in_path;        //!< Path of the problem file.
+    bool loaded=false;      //!< Whether the file could be read.
+    bool valid=false;       //!< Whether the problem is valid.
+    QString error;          //!< Why the problem couldn't be loaded or is invalid.
+    bool success=false;     //!< Whether all pins were routed.
+    int segments=0;         //!< Routed segments in the final grid.
+    int routed_cells=0;     //!< Routed cells in the final grid.
+    qint64 time_ms=0;       //!< Wall-clock routing time.
+    qint64 expansions=0;    //!< Cells expanded by the searches.
+    bool budget_exhausted=false;  //!< Whether routing was cut short by the budget.
+    QString solution_path;  //!< Where the solution was written, if anywhere.
+    QString step_log_path;  //!< Where the step log was written, if anywhere.
+    QString trace_path;     //!< Where the trace was written, if anywhere.
+    bool incremental=false; //!< Whether a prior solution was rerouted.
+    int kept_connections=0;         //!< Prior connections reused.
+    int invalidated_connections=0;  //!< Prior connections ripped.
+    rt::RouteInstrumentation instrumentation; //!< Counters and timers of the run.
+  };
+
+  //! Route problem files without any GUI objects or step logging, spreading
+  //! the files across a pool of worker threads.
+  class BatchRunner
+  {
+  public:
+
+    //! Constructor taking the router settings applied to every problem, the
+    //! number of worker threads (values below 1 use the ideal count), the
+    //! directory that solution files are written to, the directory that
+    //! prior solutions are read from, the directory that step logs are 
+    //! written to and the directory that traces are written to (none if
+    //! empty).
+    BatchRunner(const rt::RouterSettings &settings, int thread_count,
+        const QString &solution_dir=QString(), const QString &prior_dir=QString(),
+        const QString &step_log_dir=QString(), const QString &trace_dir=QString());
+
+    //! Route all of the provided problem files. A JSON line is written to out
+    //! as soon as each problem completes. Results are returned in the order
+    //! of the provided paths.
+    QList<BatchResult> run(const QStringList &in_paths, QTextStream &out);
+
+    //! Route a single problem file with the provided settings. If a solution
+    //! directory is provided, the solution is written to <basename>.rsol in
+    //! there. If a prior directory is provided and contains <basename>.rsol,
+    //! the problem is rerouted incrementally on top of that solution. If a
+    //! step log directory is provided, steps are logged to <basename>.rlog in
+    //! there at the log level of the settings. If a trace directory is
+    //! provided, a trace-event timeline is written to <basename>.json in there.
+    static BatchResult routeFile(const QString &in_path,
+        const rt::RouterSettings &settings,
+        const QString &solution_dir=QString(), const QString &prior_dir=QString(),
+        const QString &step_log_dir=QString(), const QString &trace_dir=QString());
+
+    //! Return the process exit code for the provided results: 1 if any
+    //! problem couldn't be loaded or is invalid, 0 otherwise. Problems that
+    //! were routed but not completely don't count as errors.
+    static int exitCode(const QList<BatchResult> &results);
+
+    //! Register the batch mode and router settings command line options.
+    static void addOptions(QCommandLineParser &parser);
+
+    //! Run batch mode as specified by an already processed parser. Returns
+    //! the process exit code.
+    static int exec(const QCommandLineParser &parser);
+
+  private:
+
+    // Private variables
+    rt::RouterSettings settings;  //!< Settings for every routing run.
+    int thread_count;             //!< Number of worker threads.
+    QString solution_dir;         //!< Directory that solutions are written to.
+    QString prior_dir;            //!< Directory that prior solutions are read from.
+    QString step_log_dir;         //!< Directory that step logs are written to.
+    QString trace_dir;            //!< Directory that traces are written to.
+  };
+
+}
+
+#endif
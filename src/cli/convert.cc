@@ -0,0 +1,25 @@
+// @file:     convert.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of problem file conversion.
+
+#include <QDebug>
+#include "convert.h"
+#include "router/problem.h"
+
+int cli::convertProblem(const QString &in_path, const QString &out_path)
+{
+  rt::Problem problem;
+  if (!problem.readProblem(in_path)) {
+    qCritical() << QObject::tr("Unable to read %1. %2").arg(in_path)
+      .arg(problem.lastError());
+    return 1;
+  }
+  if (!problem.writeProblem(out_path, rt::Problem::formatForPath(out_path))) {
+    qCritical() << QObject::tr("Unable to write %1.").arg(out_path);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,22 @@
+// @file:     convert.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Conversion of problem files between the text and binary formats.
+
+#ifndef _CLI_CONVERT_H_
+#define _CLI_CONVERT_H_
+
+#include <QString>
+
+namespace cli {
+
+  //! Read the problem file at in_path (in either format) and write it to 
+  //! out_path, in the binary format if out_path ends with .pbin and in the
+  //! text format otherwise. Returns the process exit code.
+  int convertProblem(const QString &in_path, const QString &out_path);
+
+}
+
+#endif
@@ -6,6 +6,7 @@
 // @desc:     Implementation of the Invoker class.
 
 #include "invoker.h"
+#include "router/solution_io.h"
 
 using namespace gui;
 
@@ -22,29 +23,129 @@ Invoker::Invoker(Viewer *viewer, RouteInspector *inspector, QWidget *parent)
   initInvoker();
 }
 
+Invoker::~Invoker()
+{
+  // other widgets may already be gone, so only stop the thread here
+  if (isRouting()) {
+    run_id++;
+    soft_halt.cancel();
+    route_thread->quit();
+    route_thread->wait();
+  }
+}
+
 void Invoker::setProblem(const rt::Problem &p)
 {
   problem = p;
+  last_result.reset();
   setEnabled(problem.isValid());  // disable widget if problem is invalid
 }
 
 void Invoker::runRoute()
 {
-  soft_halt=false;
+  if (isRouting()) {
+    return;
+  }
+  soft_halt.reset();
   readRouterSettings();
   inspector->clearCollections();
-  if (problem.isValid()) {
-    rt::Problem problem_cp(problem);
-    rt::Router router(problem_cp, settings);
-    rt::RoutingRecords *record_keeper = router.recordKeeper();
-    connect(record_keeper, &rt::RoutingRecords::routerStep,
-        [this](sp::Grid *grid){viewer->updateCellGrid(grid); qApp->processEvents();});
-    router.routeSuite(problem_cp.pinSets(), problem_cp.cellGrid(), 
-        &soft_halt, inspector->solveCollection());
-    inspector->updateCollections();
-  } else {
+  if (!problem.isValid()) {
     qDebug() << "Current problem is invalid, not routing.";
+    return;
+  }
+
+  // the worker routes on its own thread and only talks back through queued
+  // signals and the snapshot mailbox
+  int id = ++run_id;
+  mailbox.clear();
+  last_snapshot.reset();
+  last_result.reset();
+  last_stats = rt::RouteStats();
+  route_thread = new QThread(this);
+  RouteWorker *worker = new RouteWorker(problem, settings,
+      inspector->solveCollection(), &last_stats, &soft_halt, &mailbox,
+      settings::Settings::max_fps);
+  worker->moveToThread(route_thread);
+  connect(route_thread, &QThread::started, worker, &RouteWorker::run);
+  connect(worker, &RouteWorker::snapshotReady, this,
+      [this, id](){if (id == run_id) showSnapshot();});
+  connect(worker, &RouteWorker::finished, this,
+      [this, id](){if (id == run_id) routeFinished();});
+  connect(worker, &RouteWorker::finished, route_thread, &QThread::quit);
+  connect(route_thread, &QThread::finished, worker, &QObject::deleteLater);
+  connect(route_thread, &QThread::finished, route_thread, &QObject::deleteLater);
+  setRoutingState(true);
+  route_thread->start();
+}
+
+void Invoker::haltRouting()
+{
+  if (!isRouting()) {
+    return;
+  }
+  // invalidate signals from this run that may still be queued
+  run_id++;
+  soft_halt.cancel();
+  route_thread->quit();
+  route_thread->wait();
+  route_thread = nullptr;
+  mailbox.clear();
+  setRoutingState(false);
+}
+
+void Invoker::showSnapshot()
+{
+  sp::ChangedCells changed;
+  QSharedPointer<sp::Grid> snapshot = mailbox.take(&changed);
+  if (!snapshot.isNull()) {
+    if (changed.all) {
+      viewer->updateCellGrid(snapshot.data());
+    } else {
+      viewer->updateCells(snapshot.data(), changed.coords);
+    }
+    last_snapshot = snapshot;
+  }
+}
+
+void Invoker::routeFinished()
+{
+  // the thread deletes itself once its event loop exits
+  route_thread = nullptr;
+  showSnapshot();
+  last_result = last_snapshot;
+  setRoutingState(false);
+  inspector->setInstrumentation(last_stats.instrumentation);
+  inspector->updateCollections();
+}
+
+void Invoker::setRoutingState(bool routing)
+{
+  pb_run->setEnabled(!routing);
+  pb_soft_halt->setEnabled(routing);
+  cbb_route_alg->setEnabled(!routing);
+  cbb_log_vb->setEnabled(!routing);
+  cbb_gui_vb->setEnabled(!routing);
+  cb_routed_cells_lower_cost->setEnabled(!routing);
+  cb_net_reordering->setEnabled(!routing);
+  cb_rip_and_reroute->setEnabled(!routing);
+  sb_time_budget->setEnabled(!routing);
+  sb_step_memory->setEnabled(!routing);
+  // the solve collection is written by the worker while routing
+  inspector->setEnabled(!routing);
+}
+
+bool Invoker::saveSolution(const QString &path) const
+{
+  if (last_result.isNull()) {
+    return false;
   }
+  rt::SolutionInfo info;
+  info.dim_x = problem.dimensions().x;
+  info.dim_y = problem.dimensions().y;
+  info.pin_sets = problem.pinSets();
+  info.alg = settings.use_alg;
+  info.stats = last_stats;
+  return rt::SolutionWriter::writeGrid(path, info, last_result.data());
 }
 
 void Invoker::initEnumNameMaps()
@@ -76,8 +177,11 @@ void Invoker::initInvoker()
   cb_routed_cells_lower_cost = new QCheckBox();
   cb_net_reordering = new QCheckBox();
   cb_rip_and_reroute = new QCheckBox();
-  QPushButton *pb_run = new QPushButton("Route");
-  QPushButton *pb_soft_halt = new QPushButton("Soft Halt");
+  sb_time_budget = new QSpinBox();
+  sb_step_memory = new QSpinBox();
+  pb_run = new QPushButton("Route");
+  pb_soft_halt = new QPushButton("Soft Halt");
+  pb_soft_halt->setEnabled(false);
   cbb_route_alg->addItems(avail_alg_str.keys());
   cbb_log_vb->addItems(log_vb_str.keys());
   cbb_gui_vb->addItems(gui_vb_str.keys());
@@ -89,10 +193,18 @@ void Invoker::initInvoker()
   cb_routed_cells_lower_cost->setChecked(true);
   cb_net_reordering->setChecked(true);
   cb_rip_and_reroute->setChecked(true);
+  sb_time_budget->setRange(0, 86400);
+  sb_time_budget->setSuffix(" s");
+  sb_time_budget->setSpecialValueText("Unlimited");
+  sb_time_budget->setValue(0);
+  sb_step_memory->setRange(0, 65536);
+  sb_step_memory->setSuffix(" MB");
+  sb_step_memory->setSpecialValueText("Unlimited");
+  sb_step_memory->setValue(rt::RouterSettings().step_memory_budget_mb);
 
   // connect signals
   connect(pb_run, &QPushButton::released, [this](){runRoute();});
-  connect(pb_soft_halt, &QPushButton::released, [this](){soft_halt=true;});
+  connect(pb_soft_halt, &QPushButton::released, [this](){soft_halt.cancel();});
 
   // add everything to widget layout
   QFormLayout *fl_settings = new QFormLayout();
@@ -102,6 +214,8 @@ void Invoker::initInvoker()
   fl_settings->addRow("Routed cells lower cost", cb_routed_cells_lower_cost);
   fl_settings->addRow("Net reordering", cb_net_reordering);
   fl_settings->addRow("Rip and reroute", cb_rip_and_reroute);
+  fl_settings->addRow("Time budget", sb_time_budget);
+  fl_settings->addRow("Step log memory", sb_step_memory);
   QVBoxLayout *vl_main = new QVBoxLayout();
   vl_main->addLayout(fl_settings);
   vl_main->addWidget(pb_run);
@@ -117,4 +231,7 @@ void Invoker::readRouterSettings()
   settings.routed_cells_lower_cost = cb_routed_cells_lower_cost->isChecked();
   settings.net_reordering = cb_net_reordering->isChecked();
   settings.rip_and_reroute = cb_rip_and_reroute->isChecked();
+  settings.time_budget_ms = (sb_time_budget->value() > 0) 
+    ? 1000 * (qint64)sb_time_budget->value() : -1;
+  settings.step_memory_budget_mb = sb_step_memory->value();
 }
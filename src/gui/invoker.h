@@ -13,6 +13,7 @@
 #include "router/problem.h"
 #include "router/router.h"
 #include "route_inspector.h"
+#include "route_worker.h"
 
 namespace gui{
 
@@ -25,17 +26,39 @@ namespace gui{
     //! Constructor taking a pointer to the inspector for direct manipulation.
     Invoker(Viewer *viewer, RouteInspector *inspector, QWidget *parent=nullptr);
 
-    //! Destructor.
-    ~Invoker() {};
+    //! Destructor, stops any routing in progress.
+    ~Invoker();
 
     //! Set problem.
     void setProblem(const rt::Problem &p);
 
-    //! Create a router and route the problem.
+    //! Create a router and route the problem on a worker thread.
     void runRoute();
 
+    //! Return whether routing is in progress.
+    bool isRouting() const {return route_thread != nullptr;}
+
+    //! Stop any routing in progress and block until the worker thread exits.
+    //! Results of the halted run are discarded.
+    void haltRouting();
+
+    //! Return whether a routing result is available for saving.
+    bool hasResult() const {return !last_result.isNull();}
+
+    //! Save the last routing result to a solution file at the provided path.
+    bool saveSolution(const QString &path) const;
+
   private:
 
+    //! Show the latest snapshot posted by the worker.
+    void showSnapshot();
+
+    //! Wrap up after the worker finishes routing.
+    void routeFinished();
+
+    //! Enable or disable GUI elements according to the routing state.
+    void setRoutingState(bool routing);
+
     //! Initialize maps.
     static void initEnumNameMaps();
 
@@ -50,7 +73,13 @@ namespace gui{
     RouteInspector *inspector;      //!< Route inspector for direct calling.
     rt::Problem problem;            //!< Current problem.
     rt::RouterSettings settings;    //!< Runtime settings to be sent to router.
-    bool soft_halt;                 //!< Tell router to stop.
+    rt::CancelToken soft_halt;      //!< Tell router to stop.
+    SnapshotMailbox mailbox;        //!< Snapshots handed over by the worker.
+    QThread *route_thread=nullptr;  //!< Thread running the router.
+    int run_id=0;                   //!< Incremented per run to discard stale signals.
+    QSharedPointer<sp::Grid> last_snapshot; //!< Last snapshot shown in the viewer.
+    QSharedPointer<sp::Grid> last_result;   //!< Final grid of the last complete run.
+    rt::RouteStats last_stats;      //!< Statistics of the last run.
 
     // GUI variables
     QComboBox *cbb_route_alg;
@@ -59,6 +88,10 @@ namespace gui{
     QCheckBox *cb_routed_cells_lower_cost;
     QCheckBox *cb_net_reordering;
     QCheckBox *cb_rip_and_reroute;
+    QSpinBox *sb_time_budget;
+    QSpinBox *sb_step_memory;
+    QPushButton *pb_run;
+    QPushButton *pb_soft_halt;
 
     static QMap<QString, rt::AvailAlg> avail_alg_str;
     static QMap<QString, rt::LogVerbosity> log_vb_str;
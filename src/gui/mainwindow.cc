@@ -8,6 +8,7 @@
 #include <QSvgGenerator>
 #include "mainwindow.h"
 #include "router/router.h"
+#include "router/solution_io.h"
 
 using namespace gui;
 
@@ -39,9 +40,21 @@ void MainWindow::resizeEvent(QResizeEvent *e)
 
 void MainWindow::readAndShowProblem(const QString &in_path)
 {
+  rt::Problem new_problem;
+  if (!new_problem.readProblem(in_path)) {
+    QMessageBox::warning(this, tr("Open Problem"), tr("Unable to read %1.\n%2")
+        .arg(in_path).arg(new_problem.lastError()));
+    return;
+  }
+  if (!new_problem.isValid()) {
+    QMessageBox::warning(this, tr("Open Problem"), tr("%1 is not a valid "
+          "problem.\n%2").arg(in_path).arg(new_problem.validationError()));
+    return;
+  }
   setWindowTitle(tr("%1 - %2").arg(QCoreApplication::applicationName())
       .arg(QFileInfo(in_path).fileName()));
-  problem = rt::Problem(in_path);
+  invoker->haltRouting();
+  problem = new_problem;
   inspector->clearCollections();
   viewer->showProblem(problem);
   invoker->setProblem(problem);
@@ -68,6 +81,56 @@ void MainWindow::takeScreenshot() const
   painter.end();
 }
 
+void MainWindow::saveSolution()
+{
+  if (!invoker->hasResult()) {
+    QMessageBox::information(this, tr("Save Solution"),
+        tr("Route the problem before saving a solution."));
+    return;
+  }
+  QString sol_path = QFileDialog::getSaveFileName(this, tr("Save solution to..."),
+      open_dir_path, tr("Solution Files (*.rsol);;All files (*.*)"));
+  if (sol_path.isEmpty()) {
+    return;
+  }
+  if (!invoker->saveSolution(sol_path)) {
+    QMessageBox::warning(this, tr("Save Solution"),
+        tr("Unable to write the solution to %1.").arg(sol_path));
+  }
+}
+
+void MainWindow::openSolution(const QString &sol_path)
+{
+  rt::SolutionFile sol;
+  QString error;
+  if (!sol.load(sol_path, &error)) {
+    QMessageBox::warning(this, tr("Open Solution"), error);
+    return;
+  }
+  if (sol.info().pin_sets != problem.pinSets()) {
+    QMessageBox::warning(this, tr("Open Solution"),
+        tr("The solution does not belong to the current problem."));
+    return;
+  }
+  invoker->haltRouting();
+  sp::Grid *grid = new sp::Grid(problem.cellGrid());
+  if (!sol.applyToGrid(grid, &error)) {
+    delete grid;
+    QMessageBox::warning(this, tr("Open Solution"), error);
+    return;
+  }
+  inspector->addSolvedGrid(grid);
+}
+
+void MainWindow::openStepLog(const QString &log_path)
+{
+  invoker->haltRouting();
+  QString error;
+  if (!inspector->openStepLog(log_path, problem, &error)) {
+    QMessageBox::warning(this, tr("Open Step Log"), error);
+  }
+}
+
 void MainWindow::initGui()
 {
   initMenuBar();
@@ -98,6 +161,9 @@ void MainWindow::initMenuBar()
 
   // file menu actions
   QAction *open_problem = new QAction(tr("&Open..."), this);
+  QAction *open_solution = new QAction(tr("Open So&lution..."), this);
+  QAction *save_solution = new QAction(tr("&Save Solution..."), this);
+  QAction *open_step_log = new QAction(tr("Open Step &Log..."), this);
   QAction *quit = new QAction(tr("&Quit"), this);
   QMenu *open_sample_problem = new QMenu(tr("Open Sample Problem"), this);
 
@@ -132,11 +198,28 @@ void MainWindow::initMenuBar()
         QFileDialog fd;
         fd.setDefaultSuffix("infile");
         QString open_path = fd.getOpenFileName(this, tr("Open File"),
-              open_dir_path, tr("In Files (*.infile);;All files (*.*)"));
+              open_dir_path, tr("Problem Files (*.infile *.pbin);;All files (*.*)"));
         if (!open_path.isNull()) {
           readAndShowProblem(open_path);
         }
       });
+  connect(open_solution, &QAction::triggered,
+      [this](){
+        QString sol_path = QFileDialog::getOpenFileName(this, tr("Open Solution"),
+              open_dir_path, tr("Solution Files (*.rsol);;All files (*.*)"));
+        if (!sol_path.isNull()) {
+          openSolution(sol_path);
+        }
+      });
+  connect(save_solution, &QAction::triggered, this, &MainWindow::saveSolution);
+  connect(open_step_log, &QAction::triggered,
+      [this](){
+        QString log_path = QFileDialog::getOpenFileName(this, tr("Open Step Log"),
+              open_dir_path, tr("Step Logs (*.rlog);;All files (*.*)"));
+        if (!log_path.isNull()) {
+          openStepLog(log_path);
+        }
+      });
   connect(quit, &QAction::triggered, this, &QWidget::close);
   connect(screenshot, &QAction::triggered, this, &MainWindow::takeScreenshot);
   connect(about, &QAction::triggered, this, &MainWindow::aboutDialog);
@@ -145,6 +228,10 @@ void MainWindow::initMenuBar()
   file->addAction(open_problem);
   file->addMenu(open_sample_problem);
   file->addSeparator();
+  file->addAction(open_solution);
+  file->addAction(save_solution);
+  file->addAction(open_step_log);
+  file->addSeparator();
   file->addAction(quit);
   tools->addAction(screenshot);
   help->addAction(about);
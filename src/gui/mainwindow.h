@@ -28,8 +28,9 @@ namespace gui {
     //! routed.
     explicit MainWindow(const QString &in_path, QWidget *parent=nullptr);
 
-    //! Destructor (contained widgets are automatically destroyed by Qt).
-    ~MainWindow() {};
+    //! Destructor (contained widgets are automatically destroyed by Qt, but
+    //! routing in progress has to be stopped first).
+    ~MainWindow() {invoker->haltRouting();};
 
     //! Show the About dialog.
     void aboutDialog();
@@ -44,6 +45,16 @@ namespace gui {
     //! Take a screenshot of the viewer and output to SVG.
     void takeScreenshot() const;
 
+    //! Save the last routing result to a solution file chosen by the user.
+    void saveSolution();
+
+    //! Open a solution file of the current problem and show it.
+    void openSolution(const QString &sol_path);
+
+    //! Open the step log at the provided path in the route inspector. It must
+    //! have been logged for the current problem.
+    void openStepLog(const QString &log_path);
+
   private:
 
     //! Initialize the GUI.
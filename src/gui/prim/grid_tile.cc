@@ -0,0 +1,200 @@
+// @file:     grid_tile.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the GridTile graphics element class.
+
+#include "grid_tile.h"
+
+using namespace gui;
+using namespace settings;
+
+int GridTile::num_pin_sets = -1;
+
+GridTile::GridTile(const sp::Coord &origin, const sp::Coord &size)
+  : tile_origin(origin), tile_size(size)
+{
+  // blank cells without working values are white, which matches the default
+  // cell states
+  states.resize(tile_size.x * tile_size.y);
+  img = QImage(tile_size.x, tile_size.y, QImage::Format_RGB32);
+  img.fill(cellColor(sp::BlankCell, -1));
+  setPos(tile_origin.x*Settings::sf, tile_origin.y*Settings::sf);
+  // needed for the exposed rectangle to be provided when painting
+  setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+bool GridTile::updateFromGrid(const sp::Grid *grid)
+{
+  const QVector<sp::Cell> &cells = grid->cellStorage();
+  // the grid only allocates working values once a search has set one
+  const QVector<int> &working_vals = grid->workingValueStorage();
+  int dim_y = grid->dimensions().y;
+  bool changed = false;
+  for (int x=0; x<tile_size.x; x++) {
+    int col_start = (tile_origin.x + x)*dim_y + tile_origin.y;
+    const sp::Cell *col = cells.constData() + col_start;
+    for (int y=0; y<tile_size.y; y++) {
+      int working_val = working_vals.isEmpty() ? -1 : working_vals[col_start + y];
+      changed |= refreshCell(col[y], working_val, x, y);
+    }
+  }
+  if (changed) {
+    update();
+  }
+  return changed;
+}
+
+bool GridTile::updateCell(const sp::Grid *grid, const sp::Coord &coord)
+{
+  int x = coord.x - tile_origin.x;
+  int y = coord.y - tile_origin.y;
+  if (x < 0 || y < 0 || x >= tile_size.x || y >= tile_size.y) {
+    return false;
+  }
+  int dim_y = grid->dimensions().y;
+  if (!refreshCell(grid->cellStorage()[coord.x*dim_y + coord.y],
+        grid->workingValue(coord), x, y)) {
+    return false;
+  }
+  qreal sf = Settings::sf;
+  update(QRectF(x*sf, y*sf, sf, sf));
+  return true;
+}
+
+bool GridTile::refreshCell(const sp::Cell &cell, int working_val, int x, int y)
+{
+  CellState &state = states[stateIndex(x, y)];
+  if (state.type == cell.getType() && state.pin_set_id == cell.pinSetId()
+      && state.working_val == working_val) {
+    return false;
+  }
+  if (state.type != cell.getType() || state.pin_set_id != cell.pinSetId()) {
+    img.setPixel(x, y, cellColor(cell.getType(), cell.pinSetId()).rgb());
+    agg_imgs.clear();
+  }
+  state.type = cell.getType();
+  state.pin_set_id = cell.pinSetId();
+  state.working_val = working_val;
+  return true;
+}
+
+int GridTile::aggregationLevel(qreal pixels_per_cell)
+{
+  int level = 0;
+  while (pixels_per_cell < 1 && (1 << level) < tile_cells) {
+    pixels_per_cell *= 2;
+    level++;
+  }
+  return level;
+}
+
+const QImage &GridTile::aggregatedImage(int level)
+{
+  if (level <= 0) {
+    return img;
+  }
+  if (level >= agg_imgs.size()) {
+    agg_imgs.resize(level+1);
+  }
+  QImage &agg = agg_imgs[level];
+  if (agg.isNull()) {
+    // smooth downscaling averages the colors of the aggregated cells
+    int scale = 1 << level;
+    agg = img.scaled((tile_size.x + scale - 1) / scale,
+        (tile_size.y + scale - 1) / scale, Qt::IgnoreAspectRatio,
+        Qt::SmoothTransformation);
+  }
+  return agg;
+}
+
+QColor GridTile::cellColor(sp::CellType type, int pin_set_id)
+{
+  switch(type) {
+    case sp::PinCell:
+    case sp::RoutedCell:
+      return Settings::colorGenerator(pin_set_id, num_pin_sets-1);
+    case sp::ObsCell:
+      return QColor("#0000FF");
+    case sp::BlankCell:
+    default:
+      return QColor("#FFFFFF");
+  }
+}
+
+QRectF GridTile::boundingRect() const
+{
+  return QRectF(0, 0, tile_size.x*Settings::sf, tile_size.y*Settings::sf);
+}
+
+void GridTile::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+  // find the range of exposed cells
+  qreal sf = Settings::sf;
+  QRectF exposed = option->exposedRect.intersected(boundingRect());
+  int x0 = qMax(0, qFloor(exposed.left()/sf));
+  int y0 = qMax(0, qFloor(exposed.top()/sf));
+  int x1 = qMin(tile_size.x, qCeil(exposed.right()/sf));
+  int y1 = qMin(tile_size.y, qCeil(exposed.bottom()/sf));
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+
+  // cells that are smaller than a pixel are painted from an aggregated image
+  // in which each pixel averages 2^level by 2^level cells
+  qreal ppc = sf * QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+      painter->worldTransform());
+  painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+  int level = aggregationLevel(ppc);
+  if (level > 0) {
+    const QImage &agg = aggregatedImage(level);
+    qreal fx = (qreal)agg.width() / tile_size.x;
+    qreal fy = (qreal)agg.height() / tile_size.y;
+    QRectF source(x0*fx, y0*fy, (x1-x0)*fx, (y1-y0)*fy);
+    QRectF target(x0*sf, y0*sf, (x1-x0)*sf, (y1-y0)*sf);
+    painter->drawImage(target, agg, source);
+    return;
+  }
+
+  // scale up the cell colors without smoothing so that cells stay crisp
+  QRect source(x0, y0, x1-x0, y1-y0);
+  QRectF target(x0*sf, y0*sf, source.width()*sf, source.height()*sf);
+  painter->drawImage(target, img, source);
+
+  // outlines and text are skipped when they would be too small to make out
+  if (ppc < Settings::lod_outline_ppc) {
+    return;
+  }
+
+  // draw cell outlines
+  painter->setPen(QColor("#000000"));
+  QVector<QLineF> lines;
+  lines.reserve(source.width() + source.height() + 2);
+  for (int x=x0; x<=x1; x++) {
+    lines.append(QLineF(x*sf, y0*sf, x*sf, y1*sf));
+  }
+  for (int y=y0; y<=y1; y++) {
+    lines.append(QLineF(x0*sf, y*sf, x1*sf, y*sf));
+  }
+  painter->drawLines(lines);
+
+  // draw set IDs of pins and working values
+  if (ppc < Settings::lod_text_ppc) {
+    return;
+  }
+  for (int x=x0; x<x1; x++) {
+    for (int y=y0; y<y1; y++) {
+      const CellState &state = states[stateIndex(x, y)];
+      QRectF cell_rect(x*sf, y*sf, sf, sf);
+      if (state.type == sp::PinCell) {
+        painter->drawText(cell_rect, Qt::AlignLeft | Qt::AlignTop,
+            QObject::tr("S%1").arg(state.pin_set_id));
+      }
+      if (state.working_val > 0) {
+        painter->drawText(cell_rect, Qt::AlignCenter,
+            QObject::tr("%1").arg(state.working_val));
+      }
+    }
+  }
+}
@@ -0,0 +1,105 @@
+// @file:     grid_tile.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     The GridTile class is a graphical element that displays a
+//            rectangular block of the problem grid from a cached image.
+
+#ifndef _GUI_GRID_TILE_H_
+#define _GUI_GRID_TILE_H_
+
+#include <QtWidgets>
+#include "router/problem.h"
+#include "gui/settings.h"
+
+namespace gui {
+
+  //! A graphical element that displays a block of up to tile_cells by
+  //! tile_cells grid cells. Cell colors are rasterized into an image with one
+  //! pixel per cell, which is scaled up when painting; pin labels, working
+  //! values and cell outlines are drawn on top for the exposed cells only.
+  //! When zoomed out, outlines and text are left out below the thresholds in
+  //! Settings and cells smaller than a pixel are painted from cached images
+  //! that average blocks of cells.
+  //! The state of the covered cells is cached so that only changed cells are
+  //! re-rasterized when the tile is updated.
+  class GridTile : public QGraphicsItem
+  {
+  public:
+
+    //! Number of cells along each side of a full tile.
+    static const int tile_cells = 256;
+
+    //! Constructor taking the grid coordinate of the tile's top left cell and
+    //! the number of cells covered in each direction.
+    GridTile(const sp::Coord &origin, const sp::Coord &size);
+
+    //! Copy the state of the covered cells from the provided grid and
+    //! re-rasterize the ones that changed. Return whether any cell changed.
+    bool updateFromGrid(const sp::Grid *grid);
+
+    //! Copy the state of a single covered cell from the provided grid and
+    //! re-rasterize and repaint it if it changed. Return whether it changed.
+    bool updateCell(const sp::Grid *grid, const sp::Coord &coord);
+
+    //! Return the grid coordinate of the tile's top left cell.
+    sp::Coord origin() const {return tile_origin;}
+
+    //! Return the number of cells covered in each direction.
+    sp::Coord size() const {return tile_size;}
+
+    //! Return the rasterized cell colors, one pixel per cell.
+    const QImage &image() const {return img;}
+
+    //! Return the image in which each pixel averages the colors of 2^level by
+    //! 2^level cells. Level 0 returns image(). Aggregated images are cached
+    //! until a cell color changes.
+    const QImage &aggregatedImage(int level);
+
+    //! Return the aggregation level used for painting at the provided number
+    //! of screen pixels per cell, i.e. the smallest level at which a block
+    //! of cells covers at least a pixel.
+    static int aggregationLevel(qreal pixels_per_cell);
+
+    //! Return the color that a cell of the provided type and pin set is
+    //! painted in.
+    static QColor cellColor(sp::CellType type, int pin_set_id);
+
+    //! Overriden method to return the bounding rectangle of this tile.
+    virtual QRectF boundingRect() const override;
+
+    //! Overriden method to paint the exposed part of this tile on scene.
+    virtual void paint(QPainter *, const QStyleOptionGraphicsItem *, QWidget *) override;
+
+    //! Static number of sets of pins of the problem currently displayed.
+    static int num_pin_sets;
+
+  private:
+
+    //! Cached state of a covered cell.
+    struct CellState
+    {
+      sp::CellType type=sp::BlankCell;  //!< Cell type.
+      int pin_set_id=-1;                //!< Pin set ID, -1 if none.
+      int working_val=-1;               //!< Working value, shown if positive.
+    };
+
+    //! Copy the state of the provided cell and its working value to the
+    //! tile-local coordinate and re-rasterize it if needed. Return whether it
+    //! changed.
+    bool refreshCell(const sp::Cell &cell, int working_val, int x, int y);
+
+    //! Return the index of the provided tile-local coordinate in states.
+    int stateIndex(int x, int y) const {return x*tile_size.y + y;}
+
+    // Private variables
+    sp::Coord tile_origin;      //!< Grid coordinate of the top left cell.
+    sp::Coord tile_size;        //!< Number of covered cells in each direction.
+    QVector<CellState> states;  //!< Cached state of the covered cells.
+    QImage img;                 //!< Rasterized cell colors.
+    QVector<QImage> agg_imgs;   //!< Cached aggregated images by level.
+  };
+}
+
+#endif
@@ -25,21 +25,54 @@ RouteInspector::~RouteInspector()
 void RouteInspector::clearCollections(bool update_viewer)
 {
   solve_col.clear();
+  step_log.reset();
+  log_grid.reset();
+  log_metrics.clear();
+  instr.reset();
   updateCollections();
   if (update_viewer)
     viewer->updateCellGrid();
 }
 
+void RouteInspector::addSolvedGrid(sp::Grid *grid)
+{
+  step_log.reset();
+  log_grid.reset();
+  log_metrics.clear();
+  solve_col.appendStep(solve_col.newSolveSteps(), QSharedPointer<sp::Grid>(grid));
+  updateCollections();
+}
+
+bool RouteInspector::openStepLog(const QString &path, rt::Problem &problem,
+    QString *error)
+{
+  QScopedPointer<rt::StepLogFile> log(new rt::StepLogFile());
+  if (!log->load(path, error)) {
+    return false;
+  }
+  if (log->dimensions() != problem.dimensions() || log->pinSets() != problem.pinSets()) {
+    *error = tr("The step log does not belong to the current problem.");
+    return false;
+  }
+  solve_col.clear();
+  step_log.swap(log);
+  log_grid.reset(new sp::Grid(problem.cellGrid()));
+  log_metrics.clear();
+  instr.reset();
+  updateCollections();
+  return true;
+}
+
 void RouteInspector::updateCollections()
 {
   int last_col;
-  if (solve_col.solve_steps.size() < 1) {
+  if (collectionCount() < 1) {
     // nothing in collection
     last_col = 0;
     g_collection->setEnabled(false);
     pb_show_best->setEnabled(false);
   } else {
-    last_col = solve_col.solve_steps.size()-1;
+    last_col = collectionCount()-1;
     g_collection->setEnabled(true);
     pb_show_best->setEnabled(true);
   }
@@ -53,13 +86,13 @@ void RouteInspector::showBestCollection()
   int col_ind = -1;
   int segments = -1;
   int routed_cells = -1;
-  for (int i=0; i<solve_col.solve_steps.size(); i++) {
-    if (solve_col.solve_steps[i].step_grids.isEmpty()) {
+  for (int i=0; i<collectionCount(); i++) {
+    if (stepCount(i) == 0) {
       continue;
     }
-    sp::Grid *last_grid = solve_col.solve_steps[i].step_grids.last();
-    int t_segments = last_grid->countSegments();
-    int t_routed_cells = last_grid->countCells({sp::RoutedCell});
+    rt::StepMetrics metrics = stepMetrics(i, stepCount(i)-1);
+    int t_segments = metrics.segments;
+    int t_routed_cells = metrics.routed_cells;
     if (col_ind == -1 || t_segments > segments || 
         (t_segments == segments && t_routed_cells < routed_cells)) {
       col_ind = i;
@@ -73,15 +106,32 @@ void RouteInspector::showBestCollection()
 void RouteInspector::showSolveStep(int col, int step)
 {
   if (col < 0) {
-    col = solve_col.solve_steps.size()-1;
+    col = collectionCount()-1;
   }
   if (step < 0) {
-    step = solve_col.solve_steps[col].step_grids.size()-1;
+    step = stepCount(col)-1;
+  }
+  sp::Grid *grid = stepGrid(col, step);
+  if (grid == nullptr) {
+    return;
+  }
+  int step_index = step_log ? step : solve_col.solve_steps[col].stepIndex(step);
+  int logged_count = step_log ? stepCount(col) : solve_col.solve_steps[col].loggedCount();
+  viewer->updateCellGrid(grid);
+  rt::StepMetrics metrics = stepMetrics(col, step);
+  QString status = QString("Segments: %1; routed cells: %2; wirelength: %3; "
+        "step %4 of %5; step memory: %6")
+      .arg(metrics.segments)
+      .arg(metrics.routed_cells)
+      .arg(metrics.wirelength)
+      .arg(step_index+1)
+      .arg(logged_count)
+      .arg(memoryString());
+  rt::RouteCounters counters = instr.attempt(col);
+  if (!counters.isEmpty()) {
+    status += "; " + counters.summary();
   }
-  viewer->updateCellGrid(solve_col[col][step]);
-  segments->setText(QString("Segments: %1; routed cells: %2")
-      .arg(solve_col[col][step]->countSegments())
-      .arg(solve_col[col][step]->countCells({sp::RoutedCell})));
+  segments->setText(status);
   s_collection->setValue(col);
   s_step->setValue(step);
 }
@@ -168,13 +218,13 @@ void RouteInspector::updateSteps()
 {
   int curr_col = s_collection->value();
   int orig_val = s_step->value();
-  if (!g_collection->isEnabled() || solve_col[curr_col].step_grids.size() == 0) {
+  if (!g_collection->isEnabled() || stepCount(curr_col) == 0) {
     g_step->setEnabled(false);
     s_step->setValue(0);
     segments->setText(QString("Segments: 0; routed cells: 0"));
     return;
   }
-  int last_step = solve_col[curr_col].step_grids.size() - 1;
+  int last_step = stepCount(curr_col) - 1;
   g_step->setEnabled(true);
   s_step->setRange(0, last_step);
   s_step->setValue(last_step);
@@ -184,3 +234,53 @@ void RouteInspector::updateSteps()
     showSolveStep();
   }
 }
+
+QString RouteInspector::memoryString() const
+{
+  if (step_log) {
+    return QString("%1 MB mapped from disk")
+      .arg(QString::number(step_log->fileSize() / (1024. * 1024.), 'f', 1));
+  }
+  QString used = QString::number(solve_col.memoryUsed() / (1024. * 1024.), 'f', 1);
+  if (solve_col.memoryBudget() <= 0) {
+    return QString("%1 MB").arg(used);
+  }
+  return QString("%1 / %2 MB").arg(used).arg(solve_col.memoryBudget() >> 20);
+}
+
+int RouteInspector::collectionCount() const
+{
+  return step_log ? step_log->attemptCount() : solve_col.solve_steps.size();
+}
+
+int RouteInspector::stepCount(int col) const
+{
+  return step_log ? step_log->stepCount(col) : solve_col[col].size();
+}
+
+sp::Grid *RouteInspector::stepGrid(int col, int step)
+{
+  if (step_log) {
+    return step_log->readStep(col, step, log_grid.data()) ? log_grid.data() : nullptr;
+  }
+  return solve_col[col][step];
+}
+
+rt::StepMetrics RouteInspector::stepMetrics(int col, int step)
+{
+  if (!step_log) {
+    return solve_col[col].metrics(step);
+  }
+  QPair<int,int> key(col, step);
+  auto it = log_metrics.constFind(key);
+  if (it != log_metrics.constEnd()) {
+    return it.value();
+  }
+  rt::StepMetrics metrics;
+  sp::Grid *grid = stepGrid(col, step);
+  if (grid != nullptr) {
+    metrics = rt::StepMetrics::measure(grid);
+    log_metrics.insert(key, metrics);
+  }
+  return metrics;
+}
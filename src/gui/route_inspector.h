@@ -10,6 +10,7 @@
 
 #include <QtWidgets>
 #include "router/router.h"
+#include "router/step_log.h"
 #include "viewer.h"
 
 namespace gui {
@@ -33,10 +34,25 @@ namespace gui {
     //! Clear the existing collection.
     void clearCollections(bool update_viewer=true);
 
+    //! Add a solved grid (e.g. loaded from a solution file) as a collection of
+    //! its own and show it. The inspector takes ownership of the grid.
+    void addSolvedGrid(sp::Grid *grid);
+
+    //! Replace the collections with the attempts and steps of the step log at
+    //! the provided path, which must have been logged for the provided 
+    //! problem. Steps are decoded from the memory-mapped log on demand. 
+    //! Return false if the log can't be used, in which case error says why.
+    bool openStepLog(const QString &path, rt::Problem &problem, QString *error);
+
     //! Update the inspector GUI, needs to called for the GUI elements to update
     //! in response to changes in the SolveCollection.
     void updateCollections();
 
+    //! Set the counters and timers of the routing run that filled the
+    //! collection, whose attempts are shown along with the collection of the
+    //! same index. They are cleared along with the collections.
+    void setInstrumentation(const rt::RouteInstrumentation &t_instr) {instr = t_instr;}
+
     //! Show the "best" collection, here defined as the collection with most
     //! routed segments (first priority) and least routed cells (second 
     //! priority). If multiple candidates are tied, selects the one with lower
@@ -57,9 +73,30 @@ namespace gui {
     //! Update the steps slider in response to changes in collection selection.
     void updateSteps();
 
+    //! Return the memory used by recorded steps (and the budget) as text.
+    QString memoryString() const;
+
+    //! Return the number of collections, from the step log if one is open.
+    int collectionCount() const;
+
+    //! Return the number of steps in the provided collection.
+    int stepCount(int col) const;
+
+    //! Return the grid of the provided step (nullptr if there's none). Grids
+    //! decoded from a step log are only valid until the next call.
+    sp::Grid *stepGrid(int col, int step);
+
+    //! Return the metrics of the provided step. Steps in the collection carry
+    //! their metrics, step log steps are measured once and then cached.
+    rt::StepMetrics stepMetrics(int col, int step);
+
     // Private variables
     Viewer *viewer;                   //!< Pointer to the main viewer.
     rt::SolveCollection solve_col;    //!< Record of steps taken to solve the problem.
+    QScopedPointer<rt::StepLogFile> step_log; //!< Step log shown instead of solve_col.
+    QScopedPointer<sp::Grid> log_grid;//!< Grid that step log steps are decoded into.
+    QHash<QPair<int,int>,rt::StepMetrics> log_metrics; //!< Measured step log steps.
+    rt::RouteInstrumentation instr;   //!< Counters of the run that filled solve_col.
 
     // Private GUI variables
     QLabel *segments=nullptr;         //!< Label to show segment count.
@@ -0,0 +1,85 @@
+// @file:     route_worker.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the RouteWorker and SnapshotMailbox classes.
+
+#include "route_worker.h"
+
+using namespace gui;
+
+bool SnapshotMailbox::post(const QSharedPointer<sp::Grid> &snapshot,
+    const sp::ChangedCells &changed)
+{
+  QMutexLocker locker(&mutex);
+  bool was_empty = pending.isNull();
+  pending = snapshot;
+  // the changes of a replaced snapshot haven't been shown yet
+  if (was_empty) {
+    pending_changes = changed;
+  } else {
+    pending_changes.merge(changed);
+  }
+  return was_empty;
+}
+
+QSharedPointer<sp::Grid> SnapshotMailbox::take(sp::ChangedCells *changed)
+{
+  QMutexLocker locker(&mutex);
+  QSharedPointer<sp::Grid> snapshot = pending;
+  pending.reset();
+  if (changed != nullptr) {
+    *changed = pending_changes;
+  }
+  pending_changes = sp::ChangedCells();
+  return snapshot;
+}
+
+RouteWorker::RouteWorker(const rt::Problem &problem,
+    const rt::RouterSettings &settings, rt::SolveCollection *solve_col,
+    rt::RouteStats *stats, rt::CancelToken *soft_halt, SnapshotMailbox *mailbox,
+    int max_fps, QObject *parent)
+  : QObject(parent), problem(problem), settings(settings), solve_col(solve_col),
+    stats(stats), soft_halt(soft_halt), mailbox(mailbox)
+{
+  frame_interval_ms = (max_fps > 0) ? 1000 / max_fps : 0;
+}
+
+void RouteWorker::run()
+{
+  rt::Router router(problem, settings);
+  // router steps are emitted from this thread, the connection is direct
+  connect(router.recordKeeper(), &rt::RoutingRecords::routerStep,
+      this, [this](sp::Grid *grid){offerSnapshot(grid, false);});
+  problem.cellGrid()->setChangeTracking(true);
+  frame_timer.start();
+  QElapsedTimer run_timer;
+  run_timer.start();
+  bool success = router.routeSuite(problem.pinSets(), problem.cellGrid(),
+      soft_halt, solve_col);
+  stats->success = success;
+  stats->time_ms = run_timer.elapsed();
+  stats->segments = problem.cellGrid()->countSegments();
+  stats->routed_cells = problem.cellGrid()->countCells({sp::RoutedCell});
+  stats->searches = router.budget()->searchCount();
+  stats->expansions = router.budget()->expansionCount();
+  stats->budget_exhausted = router.budget()->exhausted();
+  stats->instrumentation = *router.recordKeeper()->instrumentation();
+  offerSnapshot(problem.cellGrid(), true);
+  problem.cellGrid()->setChangeTracking(false);
+  emit finished(success);
+}
+
+void RouteWorker::offerSnapshot(sp::Grid *grid, bool force)
+{
+  if (!force && frame_timer.elapsed() < frame_interval_ms) {
+    // drop the frame, a later step will supersede it anyway
+    return;
+  }
+  frame_timer.restart();
+  QSharedPointer<sp::Grid> snapshot(new sp::Grid(grid));
+  if (mailbox->post(snapshot, grid->takeChangedCells())) {
+    emit snapshotReady();
+  }
+}
@@ -0,0 +1,105 @@
+// @file:     route_worker.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Runs the router on a worker thread and hands throttled grid
+//            snapshots over to the GUI thread.
+
+#ifndef _GUI_ROUTE_WORKER_H_
+#define _GUI_ROUTE_WORKER_H_
+
+#include <QObject>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "router/problem.h"
+#include "router/router.h"
+#include "router/route_api.h"
+
+namespace gui {
+
+  //! Hand-off point for grid snapshots between the routing thread and the GUI
+  //! thread. Only the most recent snapshot is kept, older snapshots that the
+  //! GUI hasn't picked up yet are dropped but their changed cells are kept.
+  class SnapshotMailbox
+  {
+  public:
+
+    //! Post a snapshot along with the cells changed since the previous one,
+    //! replacing any pending snapshot. Return true if nothing was pending 
+    //! before, i.e. the GUI thread has to be notified.
+    bool post(const QSharedPointer<sp::Grid> &snapshot,
+        const sp::ChangedCells &changed);
+
+    //! Take the pending snapshot. Returns a null pointer if there's none. If
+    //! provided, changed is set to the cells changed since the snapshot that
+    //! was taken before.
+    QSharedPointer<sp::Grid> take(sp::ChangedCells *changed=nullptr);
+
+    //! Drop any pending snapshot.
+    void clear() {take();}
+
+  private:
+
+    QMutex mutex;                       //!< Guards the pending snapshot.
+    QSharedPointer<sp::Grid> pending;   //!< Snapshot not yet taken by the GUI.
+    sp::ChangedCells pending_changes;   //!< Cells changed up to the pending snapshot.
+  };
+
+  //! Worker object that routes a problem on whichever thread it lives in.
+  //! Router steps are turned into grid snapshots at no more than the given
+  //! frame rate and posted to the SnapshotMailbox; intermediate steps between
+  //! frames are not copied at all. The routed grid tracks its changed cells
+  //! so that the GUI only has to redraw those.
+  class RouteWorker : public QObject
+  {
+    Q_OBJECT
+
+  public:
+
+    //! Constructor taking the problem and settings to route with, the solve
+    //! collection to log to, where to write the run statistics, the 
+    //! cancellation token, the snapshot mailbox and the maximum rate at which
+    //! snapshots are posted.
+    RouteWorker(const rt::Problem &problem, const rt::RouterSettings &settings,
+        rt::SolveCollection *solve_col, rt::RouteStats *stats,
+        rt::CancelToken *soft_halt, SnapshotMailbox *mailbox, int max_fps,
+        QObject *parent=nullptr);
+
+    //! Destructor.
+    ~RouteWorker() {};
+
+  public slots:
+
+    //! Route the problem. Emits finished() when done.
+    void run();
+
+  signals:
+
+    //! Emitted when a snapshot is posted to an empty mailbox.
+    void snapshotReady();
+
+    //! Emitted after routing is complete and the final grid has been posted.
+    void finished(bool success);
+
+  private:
+
+    //! Post a snapshot of the provided grid if enough time has passed since
+    //! the last one (or if forced).
+    void offerSnapshot(sp::Grid *grid, bool force);
+
+    // Private variables
+    rt::Problem problem;              //!< Problem to route.
+    rt::RouterSettings settings;      //!< Router settings.
+    rt::SolveCollection *solve_col;   //!< Collection that the router logs to.
+    rt::RouteStats *stats;            //!< Where run statistics are written to.
+    rt::CancelToken *soft_halt;       //!< Token for stopping the router.
+    SnapshotMailbox *mailbox;         //!< Where snapshots are posted.
+    int frame_interval_ms;            //!< Minimum time between snapshots.
+    QElapsedTimer frame_timer;        //!< Time since the last snapshot.
+  };
+
+}
+
+#endif
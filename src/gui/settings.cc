@@ -13,6 +13,12 @@ using namespace settings;
 
 qreal Settings::sf = 50;
 
+int Settings::max_fps = 30;
+
+qreal Settings::lod_outline_ppc = 4;
+
+qreal Settings::lod_text_ppc = 20;
+
 QList<QColor> Settings::gcols;
 
 QColor Settings::colorGenerator(int ind, int max_ind)
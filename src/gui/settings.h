@@ -21,6 +21,16 @@ namespace settings {
     //! Graphics viewer scaling factor (how many pixels per grid cell).
     static qreal sf;
 
+    //! Maximum number of routing snapshots shown per second while routing.
+    static int max_fps;
+
+    //! Minimum screen pixels per grid cell for cell outlines to be drawn.
+    static qreal lod_outline_ppc;
+
+    //! Minimum screen pixels per grid cell for pin labels and working values
+    //! to be drawn.
+    static qreal lod_text_ppc;
+
     //! Return a color that generated as suitable for the provided index and 
     //! max possible index.
     static QColor colorGenerator(int ind, int max_ind);
@@ -27,15 +27,19 @@ void Viewer::showProblem(const rt::Problem &problem)
 {
   clearProblem();
   curr_problem = problem;
-  Cell::num_pin_sets = problem.pinSets().size();
+  GridTile::num_pin_sets = problem.pinSets().size();
 
-  // create a graphical cell at every part of the grid
+  // cover the grid with tiles, the ones at the far edges may be smaller
   sp::Coord dims = curr_problem.dimensions();
-  for (int x=0; x<dims.x; x++) {
-    for (int y=0; y<dims.y; y++) {
-      Cell *cell = new Cell(curr_problem.cellGrid()->cellAt(sp::Coord(x,y)));
-      cells.append(cell);
-      scene->addItem(cell);
+  tiles_y = (dims.y + GridTile::tile_cells - 1) / GridTile::tile_cells;
+  for (int x=0; x<dims.x; x+=GridTile::tile_cells) {
+    for (int y=0; y<dims.y; y+=GridTile::tile_cells) {
+      sp::Coord size(qMin(GridTile::tile_cells, dims.x-x),
+          qMin(GridTile::tile_cells, dims.y-y));
+      GridTile *tile = new GridTile(sp::Coord(x,y), size);
+      tile->updateFromGrid(curr_problem.cellGrid());
+      tiles.append(tile);
+      scene->addItem(tile);
     }
   }
 
@@ -45,11 +49,12 @@ void Viewer::showProblem(const rt::Problem &problem)
 // clear problem from viewer
 void Viewer::clearProblem()
 {
-  for (Cell *cell : cells) {
-    scene->removeItem(cell);
-    delete cell;
+  for (GridTile *tile : tiles) {
+    scene->removeItem(tile);
+    delete tile;
   }
-  cells.clear();
+  tiles.clear();
+  tiles_y = 0;
   curr_problem = rt::Problem();
 }
 
@@ -75,8 +80,31 @@ void Viewer::updateCellGrid(sp::Grid *cell_grid)
   if (cell_grid == nullptr) {
     cell_grid = curr_problem.cellGrid();
   }
-  for (Cell *cell : cells) {
-    cell->updateCell(cell_grid->cellAt(cell->getCoord()));
+  // tiles schedule their own repaint if any of their cells changed
+  for (GridTile *tile : tiles) {
+    tile->updateFromGrid(cell_grid);
   }
-  scene->update();
+}
+
+void Viewer::updateCells(sp::Grid *cell_grid, const QVector<sp::Coord> &coords)
+{
+  for (const sp::Coord &coord : coords) {
+    GridTile *tile = tileAt(coord);
+    if (tile != nullptr) {
+      tile->updateCell(cell_grid, coord);
+    }
+  }
+}
+
+GridTile *Viewer::tileAt(const sp::Coord &coord) const
+{
+  if (coord.x < 0 || coord.y < 0 || tiles_y == 0) {
+    return nullptr;
+  }
+  int tx = coord.x / GridTile::tile_cells;
+  int ty = coord.y / GridTile::tile_cells;
+  if (ty >= tiles_y) {
+    return nullptr;
+  }
+  return tiles.value(tx*tiles_y + ty, nullptr);
 }
@@ -13,7 +13,7 @@
 #include "settings.h"
 #include "router/problem.h"
 #include "router/router.h"
-#include "prim/cell.h"
+#include "prim/grid_tile.h"
 
 namespace gui {
 
@@ -38,18 +38,31 @@ namespace gui {
     //! Fit problem in viewport.
     void fitProblemInView();
 
-    //! Refresh the viewer with the provided cell grid
+    //! Refresh the viewer with the provided cell grid. Only tiles containing
+    //! changed cells are re-rasterized and repainted.
     void updateCellGrid(sp::Grid *cell_grid=nullptr);
 
+    //! Refresh only the provided cells from the provided cell grid, e.g. the
+    //! cells that changed since the last refresh. Only those cells are 
+    //! re-rasterized and repainted.
+    void updateCells(sp::Grid *cell_grid, const QVector<sp::Coord> &coords);
+
+    //! Return the tiles that the problem is currently shown with.
+    const QList<GridTile*> &gridTiles() const {return tiles;}
+
   private:
 
     //! Initialize the viewer's GUI elements.
     void initViewer();
 
+    //! Return the tile containing the provided coordinate (nullptr if none).
+    GridTile *tileAt(const sp::Coord &coord) const;
+
     // Private variables
     QGraphicsScene *scene=nullptr;  //!< Pointer to the scene object.
     rt::Problem curr_problem;       //!< Current problem being shown.
-    QList<Cell*> cells;             //!< List of cell pointers currently shown.
+    QList<GridTile*> tiles;         //!< Tiles covering the problem grid.
+    int tiles_y=0;                  //!< Number of tiles in the y direction.
   };
 
 }
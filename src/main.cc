@@ -12,11 +12,23 @@
 #include <QDebug>
 
 #include "gui/mainwindow.h"
+#include "cli/batch_runner.h"
+#include "cli/convert.h"
 
 int main(int argc, char **argv) {
-  // initialize QApplication
-  QApplication app(argc, argv);
-  app.setApplicationName("Pin Routing Application");
+  // batch and conversion modes must not construct any GUI objects, so look
+  // for them before deciding which application class to instantiate
+  bool headless = false;
+  for (int i=1; i<argc; i++) {
+    if (qstrcmp(argv[i], "--batch") == 0 || qstrcmp(argv[i], "--convert") == 0) {
+      headless = true;
+    }
+  }
+
+  // initialize QApplication (or QCoreApplication for headless modes)
+  QScopedPointer<QCoreApplication> app(headless
+      ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+  app->setApplicationName("Pin Routing Application");
 
   // specify possible command line inputs
   QCommandLineParser parser;
@@ -24,12 +36,31 @@ int main(int argc, char **argv) {
       "Samuel Ng.");
   parser.addHelpOption();
   parser.addPositionalArgument("in_file", "Input file specifying the problem to"
-      " be routed (optional, can be selected from the GUI).");
+      " be routed (optional, can be selected from the GUI). Batch mode accepts"
+      " multiple input files.");
   QCommandLineOption cachePathOption("cache_path", "Specify a directory path "
       "for cache to be written to. Defaults to somewhere in the system tmp "
       "directories if unspecified.", "path");
   parser.addOption(cachePathOption);
-  parser.process(app);
+  QCommandLineOption convertOption("convert", "Convert the input problem file "
+      "to the provided path and exit. Paths ending with .pbin are written in the"
+      " binary problem format, others in the text format.", "out_path");
+  parser.addOption(convertOption);
+  cli::BatchRunner::addOptions(parser);
+  parser.process(*app);
+
+  // convert or route headlessly if requested
+  if (parser.isSet(convertOption)) {
+    if (parser.positionalArguments().size() != 1) {
+      qCritical() << "Conversion requires exactly one input file.";
+      return 1;
+    }
+    return cli::convertProblem(parser.positionalArguments().first(),
+        parser.value(convertOption));
+  }
+  if (parser.isSet("batch")) {
+    return cli::BatchRunner::exec(parser);
+  }
 
   // get input file path
   const QStringList args = parser.positionalArguments();
@@ -44,5 +75,5 @@ int main(int argc, char **argv) {
   mw.show();
 
   // run app
-  return app.exec();
+  return app->exec();
 }
@@ -5,8 +5,8 @@
 //
 // @desc:     A* algorithm using the Alg base class.
 
-#include <QVariant>
 #include <QDebug>
+#include <algorithm>
 #include "a_star.h"
 
 using namespace rt;
@@ -19,6 +19,13 @@ RouteResult AStarAlg::findRoute(const sp::Coord &source_coord,
   routed_cells_lower_cost = t_routed_cells_lower_cost;
   rip_blacklist = t_rip_blacklist;
   attempt_rip = t_attempt_rip;  // attempt rip if a rip_cand pointer is given
+  if (budget != nullptr) {
+    budget->countSearch();
+  }
+  RT_COUNT(instr, FindRouteCalls);
+  RT_TIME_SCOPE(instr, SearchTimer);
+  TraceScope trace_scope(trace, "findRoute", "search");
+  qint64 expansions_before = (budget != nullptr) ? budget->expansionCount() : 0;
   RouteResult result;
 
 
@@ -44,38 +51,83 @@ RouteResult AStarAlg::findRoute(const sp::Coord &source_coord,
     grid->clearWorkingValues();
   }
 
+  if (trace != nullptr) {
+    trace_scope.arg("alg", QString("A*"));
+    trace_scope.arg("expansions", (double)((budget != nullptr)
+          ? budget->expansionCount() - expansions_before : 0));
+    trace_scope.arg("found", success);
+  }
   return result;
 }
 
-QMultiMap<QPair<int,int>,sp::Coord> AStarAlg::markNeighbors(const sp::Coord &coord,
+bool AStarAlg::takenAfter(const QueueEntry &a, const QueueEntry &b)
+{
+  for (int i=0; i<3; i++) {
+    if (a.keys[i] != b.keys[i]) {
+      return a.keys[i] > b.keys[i];
+    }
+  }
+  // among equal keys the most recently queued entry is taken first
+  return a.seq < b.seq;
+}
+
+void AStarAlg::pushEntry(QVector<QueueEntry> &queue, int k0, int k1, int k2,
+    const sp::Coord &coord)
+{
+  QueueEntry entry;
+  entry.keys[0] = k0;
+  entry.keys[1] = k1;
+  entry.keys[2] = k2;
+  entry.seq = queue_seq++;
+  entry.coord = coord;
+  queue.append(entry);
+  std::push_heap(queue.begin(), queue.end(), takenAfter);
+}
+
+sp::Coord AStarAlg::takeFirst(QVector<QueueEntry> &queue)
+{
+  std::pop_heap(queue.begin(), queue.end(), takenAfter);
+  sp::Coord coord = queue.last().coord;
+  queue.removeLast();
+  return coord;
+}
+
+void AStarAlg::markNeighbors(const sp::Coord &coord,
     const sp::Coord &source_coord, const sp::Coord &sink_coord, sp::Grid *grid,
     int pin_set_id, bool &marked, sp::Coord &termination,
-    QList<sp::Coord> &term_to_sink_route, 
-    QMultiMap<std::tuple<int,int,int>, sp::Coord> &rip_neighbors) const
+    QList<sp::Coord> &term_to_sink_route)
 {
   marked = false;
   termination = sp::Coord();
-  QMultiMap<QPair<int,int>,sp::Coord> expl_map;
-  QList<sp::Coord> neighbors = grid->neighborCoordsOf(coord);
   // mark each neighbor if eligible
-  for (const sp::Coord &neighbor : neighbors) {
+  for (const sp::Coord &neighbor : {coord.above(), coord.right(), coord.below(), coord.left()}) {
+    if (!grid->isWithinBounds(neighbor)) {
+      continue;
+    }
     sp::Cell *nc = grid->cellAt(neighbor);
-    QList<sp::Connection*> coord_conns = grid->connMap()->values(neighbor);
     // is candidate without rip:
     bool is_cand_wo_rip = nc->getType() == sp::BlankCell || nc->pinSetId() == pin_set_id;
     // is candidate with rip if connection to be ripped is not on blacklist:
-    bool is_cand_w_rip = nc->getType() == sp::RoutedCell && nc->pinSetId() != pin_set_id
-      && std::all_of(coord_conns.begin(), coord_conns.end(),
-          [this](sp::Connection* conn){return !rip_blacklist->contains(conn);});
+    bool is_cand_w_rip = nc->getType() == sp::RoutedCell && nc->pinSetId() != pin_set_id;
+    if (is_cand_w_rip && rip_blacklist != nullptr) {
+      for (auto it = grid->connMap()->constFind(neighbor);
+          it != grid->connMap()->constEnd() && it.key() == neighbor; ++it) {
+        if (rip_blacklist->contains(it.value())) {
+          is_cand_w_rip = false;
+          break;
+        }
+      }
+    }
     if (is_cand_wo_rip || (is_cand_w_rip && attempt_rip)) {
       // eligible neighbor found
-      int d_from_source = grid->cellAt(coord)->extraProps()["d_from_source"].toInt();
+      const sp::SearchNode &node = grid->searchNode(coord);
+      int d_from_source = node.d_from_source;
       if (routed_cells_lower_cost && nc->getType() == sp::RoutedCell && nc->pinSetId() == pin_set_id) {
         d_from_source += 40;
       } else {
         d_from_source += 100;
       }
-      int ripped_conns = grid->cellAt(coord)->extraProps()["ripped_conns"].toInt();
+      int ripped_conns = node.ripped_conns;
       if (is_cand_w_rip) {
         ripped_conns += grid->connMap()->count(neighbor);
         d_from_source += 50000;
@@ -83,75 +135,84 @@ QMultiMap<QPair<int,int>,sp::Coord> AStarAlg::markNeighbors(const sp::Coord &coo
       int md_sink = 100*neighbor.manhattanDistance(sink_coord);
       int priority = neighbor.manhattanDistance(sink_coord);
       int working_val = d_from_source + md_sink;
-      bool update_cell = is_cand_wo_rip && (nc->workingValue() < 0 || nc->workingValue() > working_val);
+      int nc_working_val = grid->workingValue(neighbor);
+      sp::SearchNode &nc_node = grid->searchNode(neighbor);
+      bool update_cell = is_cand_wo_rip && (nc_working_val < 0 || nc_working_val > working_val);
       update_cell |= is_cand_w_rip && 
-        (nc->extraProps()["ripped_conns"] <= 0 || nc->extraProps()["ripped_conns"] > ripped_conns);
+        (nc_node.ripped_conns <= 0 || nc_node.ripped_conns > ripped_conns);
       if (update_cell) {
         // update values in the newly traversed neighbor
-        nc->setWorkingValue(working_val);
-        QVariant from_coord_v;
-        from_coord_v.setValue(coord);
-        QVariant source_coord_v, sink_coord_v;
-        source_coord_v.setValue(source_coord);
-        sink_coord_v.setValue(sink_coord);
-        nc->extraProps()["from_coord"] = from_coord_v;
-        nc->extraProps()["d_from_source"] = d_from_source;
-        nc->extraProps()["ripped_conns"] = ripped_conns;
-        nc->extraProps()["source_coord"] = source_coord_v;
-        nc->extraProps()["sink_coord"] = sink_coord_v;
+        grid->setWorkingValue(neighbor, working_val);
+        grid->markChanged(neighbor);
+        nc_node.from = coord;
+        nc_node.d_from_source = d_from_source;
+        nc_node.ripped_conns = ripped_conns;
         if (ripped_conns == 0) {
-          expl_map.insert(qMakePair(working_val, priority), neighbor);
+          pushEntry(expl_queue, working_val, priority, 0, neighbor);
         } else {
-          auto key = std::make_tuple(ripped_conns, d_from_source, priority);
-          rip_neighbors.insert(key, neighbor);
+          pushEntry(rip_queue, ripped_conns, d_from_source, priority, neighbor);
         }
+        RT_COUNT(instr, QueuePushes);
         // bookeeping
         marked = true;
-        bool is_elig_rcell = !is_cand_w_rip && (nc->getType() == sp::RoutedCell 
-            && grid->routeExistsBetweenPins(neighbor, sink_coord, &term_to_sink_route));
+        bool is_elig_rcell = false;
+        if (!is_cand_w_rip && nc->getType() == sp::RoutedCell) {
+          RT_COUNT(instr, RouteExistsProbes);
+          is_elig_rcell = grid->routeExistsBetweenPins(neighbor, sink_coord,
+              &term_to_sink_route);
+        }
         if (neighbor == sink_coord || is_elig_rcell) {
           termination = neighbor;
         }
       }
     }
   }
-  return expl_map;
 }
 
 bool AStarAlg::runAStar(const sp::Coord &source_coord, const sp::Coord &sink_coord,
     sp::Grid *grid, int pin_set_id, sp::Coord &termination, 
     QList<sp::Coord> &term_to_sink_route, bool &route_requires_rip,
-    RoutingRecords *record_keeper) const
+    RoutingRecords *record_keeper)
 {
   bool marked;
-  // keep a map of neighbors to be explored -- first key is the A* score and 
-  // second key the priority determined by distance to sink
-  QMultiMap<QPair<int,int>,sp::Coord> expl_map;
+  // the queue of neighbors to be explored is keyed by the A* score and then
+  // the priority determined by distance to sink, the queue of neighbors that
+  // can be accessed if ripping is allowed is keyed as described in the 
+  // comment of the markNeighbors function. Both keep their storage.
+  expl_queue.resize(0);
+  rip_queue.resize(0);
+  queue_seq = 0;
   bool exploring_rip_solutions=false;
-  // keep a map of neighbors that can be accessed if ripping is allowed. See the
-  // comment of the markNeighbors function for what the key tuple represents.
-  QMultiMap<std::tuple<int,int,int>,sp::Coord> rip_neighbors;
   // add the source coord as the first element to look at
   int md = source_coord.manhattanDistance(sink_coord);
-  expl_map.insert(qMakePair(md,0), source_coord);
-  grid->cellAt(source_coord)->extraProps()["d_from_source"] = 0;
-  grid->cellAt(source_coord)->extraProps()["ripped_conns"] = 0;
-  grid->cellAt(source_coord)->setWorkingValue(md*100);
+  pushEntry(expl_queue, md, 0, 0, source_coord);
+  RT_COUNT(instr, QueuePushes);
+  grid->searchNode(source_coord).d_from_source = 0;
+  grid->searchNode(source_coord).ripped_conns = 0;
+  grid->setWorkingValue(source_coord, md*100);
+  grid->markChanged(source_coord);
   // loop through neighbors list until sink or eligible routed cell found
-  while ((!expl_map.isEmpty()) 
-      || (attempt_rip && exploring_rip_solutions && !rip_neighbors.isEmpty())) {
+  while ((!expl_queue.isEmpty()) 
+      || (attempt_rip && exploring_rip_solutions && !rip_queue.isEmpty())) {
+    // give up if the routing budget has been exhausted
+    if (budget != nullptr && budget->expand()) {
+      return false;
+    }
+    RT_COUNT(instr, NodesExpanded);
+    RT_COUNT(instr, QueuePops);
     // take the coordinate with the minimum working value
     sp::Coord coord_mwv;
     if (!exploring_rip_solutions) {
-      coord_mwv = expl_map.take(expl_map.firstKey());
+      coord_mwv = takeFirst(expl_queue);
     } else {
-      coord_mwv = rip_neighbors.take(rip_neighbors.firstKey());
+      coord_mwv = takeFirst(rip_queue);
     }
-    // insert newly found neighbors to the exploration map
-    expl_map.unite(markNeighbors(coord_mwv, source_coord, sink_coord, grid, 
-          pin_set_id, marked, termination, term_to_sink_route, rip_neighbors));
+    // queue newly found neighbors for exploration
+    markNeighbors(coord_mwv, source_coord, sink_coord, grid, pin_set_id, marked,
+        termination, term_to_sink_route);
     if (marked && record_keeper != nullptr) {
-      record_keeper->logCellGrid(grid, LogAllIntermediate, VisualizeAllIntermediate);
+      record_keeper->logCellGrid(grid, LogAllIntermediate, VisualizeAllIntermediate,
+          true);
     }
     if (!termination.isBlank()) {
       // markNeighbors would already have filled in most of the 
@@ -160,7 +221,7 @@ bool AStarAlg::runAStar(const sp::Coord &source_coord, const sp::Coord &sink_coo
       route_requires_rip = exploring_rip_solutions;
       return true;
     } else {
-      if (expl_map.isEmpty()) {
+      if (expl_queue.isEmpty()) {
         exploring_rip_solutions = true;
       }
     }
@@ -176,8 +237,7 @@ void AStarAlg::runBacktrace(const sp::Coord &curr_coord, const sp::Coord &source
   if (curr_coord == source_coord) {
     return;
   } else {
-    QVariant from_coord_v = grid->cellAt(curr_coord)->extraProps()["from_coord"];
-    sp::Coord from_coord = from_coord_v.value<sp::Coord>();
+    sp::Coord from_coord = grid->searchNode(curr_coord).from;
     route.append(from_coord);
     
     runBacktrace(from_coord, source_coord, grid, pin_set_id, route, record_keeper);
@@ -34,23 +34,41 @@ namespace rt{
 
   private:
 
+    //! An entry of the exploration queues. Entries are taken in ascending
+    //! order of their keys, the most recently queued first among equal keys.
+    struct QueueEntry
+    {
+      int keys[3];      //!< Keys in order of significance.
+      int seq;          //!< Order in which the entry was queued.
+      sp::Coord coord;  //!< Coordinate to explore.
+    };
+
+    //! Return whether entry a is taken after entry b, the ordering of the
+    //! queue heaps.
+    static bool takenAfter(const QueueEntry &a, const QueueEntry &b);
+
+    //! Queue the coordinate with the provided keys.
+    void pushEntry(QVector<QueueEntry> &queue, int k0, int k1, int k2,
+        const sp::Coord &coord);
+
+    //! Remove and return the first coordinate of the non-empty queue.
+    sp::Coord takeFirst(QVector<QueueEntry> &queue);
+
     //! Mark all neighboring cells of a given coordinate by A*. If a valid 
     //! termination is found (whether because it's the sink or because it's a 
     //! routed cell with the same pin_id), then the termination variable is set.
-    //! The returned multi map has a pair of ints as keys and eligible 
-    //! coordinates as values. The first in the pair of ints represents the 
-    //! working value (A* score), the second in the pair has the Manhattan 
-    //! distance to the sink (such that closer ones are explored first).
+    //! Eligible neighbors are queued in expl_queue keyed by the working value
+    //! (A* score) and then the Manhattan distance to the sink (such that 
+    //! closer ones are explored first).
     //! If termination is not sink, then term_to_sink_route ref would be updated
     //! to include the path between the termination and sink.
-    //! Neighbors that require ripping in order to access are put in the 
-    //! rip_neighbors reference. rip_neighbors' key is a tuple of three ints:
-    //! 0. Connections ripped if ripping this cell, 1. A* score, 2. distance to sink.
-    QMultiMap<QPair<int,int>,sp::Coord> markNeighbors(const sp::Coord &coord,
+    //! Neighbors that require ripping in order to access are queued in 
+    //! rip_queue keyed by: 0. Connections ripped if ripping this cell, 
+    //! 1. A* score, 2. distance to sink.
+    void markNeighbors(const sp::Coord &coord,
         const sp::Coord &source_coord, const sp::Coord &sink_coord, sp::Grid *grid,
         int pin_set_id, bool &marked, sp::Coord &termination,
-        QList<sp::Coord> &term_to_sink_route,
-        QMultiMap<std::tuple<int,int,int>, sp::Coord> &rip_neighbors) const;
+        QList<sp::Coord> &term_to_sink_route);
 
     //! Mark neighboring cells contageously from the source coordinate using the
     //! A* algorithm until the specified sink (or eligible routing cell) is 
@@ -61,7 +79,7 @@ namespace rt{
     bool runAStar(const sp::Coord &source_coord, const sp::Coord &sink_coord,
         sp::Grid *grid, int pin_set_id, sp::Coord &termination,
         QList<sp::Coord> &term_to_sink_route, bool &route_requires_rip,
-        RoutingRecords *record_keeper=nullptr) const;
+        RoutingRecords *record_keeper=nullptr);
 
     //! Backtrace from the terminating cell recursively. To be called after 
     //! cells have been marked appropriately. Writes route to the route ref.
@@ -75,6 +93,11 @@ namespace rt{
     bool attempt_rip;
     QList<sp::Connection*> *rip_blacklist=nullptr;
 
+    // exploration queues kept across searches so that their storage is reused
+    QVector<QueueEntry> expl_queue;   //!< Heap of neighbors to explore.
+    QVector<QueueEntry> rip_queue;    //!< Heap of neighbors that require ripping.
+    int queue_seq=0;                  //!< Sequence number of the next entry.
+
   };
 
 }
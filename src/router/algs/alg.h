@@ -9,6 +9,8 @@
 #define _RT_ALG_H_
 
 #include "router/routing_records.h"
+#include "router/route_budget.h"
+#include "router/trace_writer.h"
 
 // router namespace
 namespace rt {
@@ -43,6 +45,23 @@ namespace rt {
         QList<sp::Connection*> *rip_blacklist=nullptr,
         RoutingRecords *record_keeper=nullptr) = 0;
 
+    //! Set the budget that searches draw from. Searches give up and return an
+    //! empty route once the budget is exhausted. Provide nullptr for no limit.
+    void setBudget(RouteBudget *t_budget) {budget = t_budget;}
+
+    //! Set the instrumentation that search events are counted in (nullptr
+    //! for none). Only used when built with PINROUTER_INSTRUMENT.
+    void setInstrumentation(RouteInstrumentation *t_instr) {instr = t_instr;}
+
+    //! Set the trace writer that searches are emitted to (nullptr for none).
+    void setTrace(TraceWriter *t_trace) {trace = t_trace;}
+
+  protected:
+
+    RouteBudget *budget=nullptr;  //!< Budget consumed by cell expansions.
+    RouteInstrumentation *instr=nullptr;  //!< Instrumentation of search events.
+    TraceWriter *trace=nullptr;   //!< Trace that searches are emitted to.
+
   };
 
 }
@@ -18,6 +18,13 @@ RouteResult LeeMooreAlg::findRoute(const sp::Coord &source_coord,
   routed_cells_lower_cost = t_routed_cells_lower_cost;
   rip_blacklist = t_rip_blacklist;
   attempt_rip = t_attempt_rip;
+  if (budget != nullptr) {
+    budget->countSearch();
+  }
+  RT_COUNT(instr, FindRouteCalls);
+  RT_TIME_SCOPE(instr, SearchTimer);
+  TraceScope trace_scope(trace, "findRoute", "search");
+  qint64 expansions_before = (budget != nullptr) ? budget->expansionCount() : 0;
   sp::Cell *source_cell = grid->cellAt(source_coord);
   int pin_set_id = source_cell->pinSetId();
   sp::Coord termination;
@@ -40,21 +47,30 @@ RouteResult LeeMooreAlg::findRoute(const sp::Coord &source_coord,
     grid->clearWorkingValues();
   }
 
+  if (trace != nullptr) {
+    trace_scope.arg("alg", QString("Lee-Moore"));
+    trace_scope.arg("expansions", (double)((budget != nullptr)
+          ? budget->expansionCount() - expansions_before : 0));
+    trace_scope.arg("found", success);
+  }
   return result;
 }
 
-QList<sp::Coord> LeeMooreAlg::markNeighbors(const sp::Coord &coord, sp::Grid *grid,
-    int pin_set_id, bool &marked, bool allow_rip) const
+int LeeMooreAlg::markNeighbors(const sp::Coord &coord, sp::Grid *grid,
+    int pin_set_id, bool allow_rip)
 {
-  marked=false;
-  QList<sp::Coord> neighbors = grid->neighborCoordsOf(coord);
+  int marked=0;
   // mark each neighbor if eligible
-  for (const sp::Coord &neighbor : neighbors) {
+  for (const sp::Coord &neighbor : {coord.above(), coord.right(), coord.below(), coord.left()}) {
+    if (!grid->isWithinBounds(neighbor)) {
+      continue;
+    }
     sp::Cell *cell = grid->cellAt(neighbor);
+    int working_val = grid->workingValue(neighbor);
     bool elig_wo_rip = ((cell->getType() == sp::BlankCell || cell->pinSetId() == pin_set_id)
-        && (cell->workingValue() < 0));
+        && (working_val < 0));
     bool elig_w_rip = ((cell->getType() == sp::RoutedCell && cell->pinSetId() != pin_set_id)
-        && (cell->workingValue() < 0));
+        && (working_val < 0));
     if (elig_wo_rip || (allow_rip && elig_w_rip)) {
       // eligible neighbor found
       int cost;
@@ -63,32 +79,44 @@ QList<sp::Coord> LeeMooreAlg::markNeighbors(const sp::Coord &coord, sp::Grid *gr
       } else {
         cost = 100;
       }
-      cell->setWorkingValue(grid->cellAt(coord)->workingValue()+cost);
-      marked=true;
-    } else {
-      // discard ineligible neighbor
-      neighbors.removeOne(neighbor);
+      grid->setWorkingValue(neighbor, grid->workingValue(coord)+cost);
+      grid->markChanged(neighbor);
+      queue.append(neighbor);
+      marked++;
     }
   }
-  return neighbors;
+  return marked;
 }
 
 bool LeeMooreAlg::runLeeMoore(const sp::Coord &source_coord,
     const sp::Coord &sink_coord, sp::Grid *grid, int pin_set_id, 
     sp::Coord &termination, QList<sp::Coord> &term_to_sink_route, 
-    bool &result_requires_rip, RoutingRecords *record_keeper) const
+    bool &result_requires_rip, RoutingRecords *record_keeper)
 {
-  bool marked;
   bool rip_phase=false;
   // add source to evaluation list
-  QList<sp::Coord> neighbors({source_coord});
-  grid->cellAt(source_coord)->setWorkingValue(0);
+  queue.resize(0);
+  queue_head = 0;
+  queue.append(source_coord);
+  RT_COUNT(instr, QueuePushes);
+  grid->setWorkingValue(source_coord, 0);
+  grid->markChanged(source_coord);
   // loop through neighbors until sink or eligible route found
-  while (!neighbors.isEmpty()) {
-    sp::Coord base_coord = neighbors.takeFirst();
+  while (queue_head < queue.size()) {
+    // give up if the routing budget has been exhausted
+    if (budget != nullptr && budget->expand()) {
+      return false;
+    }
+    sp::Coord base_coord = queue[queue_head++];
+    RT_COUNT(instr, NodesExpanded);
+    RT_COUNT(instr, QueuePops);
     sp::Cell *base_cell = grid->cellAt(base_coord);
-    if (base_cell->pinSetId() == pin_set_id 
-        && grid->routeExistsBetweenPins(base_coord, sink_coord, &term_to_sink_route)) {
+    bool reached = false;
+    if (base_cell->pinSetId() == pin_set_id) {
+      RT_COUNT(instr, RouteExistsProbes);
+      reached = grid->routeExistsBetweenPins(base_coord, sink_coord, &term_to_sink_route);
+    }
+    if (reached) {
       // return if a connection has been made to the sink or a routed wire that
       // leads to the sink
       termination = base_coord;
@@ -97,16 +125,22 @@ bool LeeMooreAlg::runLeeMoore(const sp::Coord &source_coord,
       return true;
     }
     // keep marking neighbors
-    neighbors.append(markNeighbors(base_coord, grid, pin_set_id, marked, rip_phase && attempt_rip));
-    if (marked && record_keeper != nullptr) {
-      record_keeper->logCellGrid(grid, LogAllIntermediate, VisualizeAllIntermediate);
+    int marked = markNeighbors(base_coord, grid, pin_set_id, rip_phase && attempt_rip);
+    RT_COUNT_N(instr, QueuePushes, marked);
+    if (marked > 0 && record_keeper != nullptr) {
+      record_keeper->logCellGrid(grid, LogAllIntermediate, VisualizeAllIntermediate,
+          true);
     }
-    if (neighbors.isEmpty() && !rip_phase && attempt_rip) {
+    if (queue_head == queue.size() && !rip_phase && attempt_rip) {
       // enter rip phase attempt
       rip_phase = true;
       grid->clearWorkingValues();
-      neighbors.append(source_coord);
-      grid->cellAt(source_coord)->setWorkingValue(0);
+      queue.resize(0);
+      queue_head = 0;
+      queue.append(source_coord);
+      RT_COUNT(instr, QueuePushes);
+      grid->setWorkingValue(source_coord, 0);
+      grid->markChanged(source_coord);
     }
   }
   // reaching this point means that no solution was found
@@ -121,12 +155,13 @@ void LeeMooreAlg::runBacktrace(const sp::Coord &curr_coord,
     // backtrace complete
     return;
   } else {
-    int curr_working_val = grid->cellAt(curr_coord)->workingValue();
+    int curr_working_val = grid->workingValue(curr_coord);
     for (sp::Cell *nc : grid->neighborsOf(curr_coord)) {
-      if (nc->workingValue() == 0) {
+      int nc_working_val = grid->workingValue(nc->getCoord());
+      if (nc_working_val == 0) {
         // back tracing complete
         return;
-      } else if (nc->workingValue() >= 0 && nc->workingValue() < curr_working_val) {
+      } else if (nc_working_val >= 0 && nc_working_val < curr_working_val) {
         route.append(nc->getCoord());
         // recurse until source reached
         runBacktrace(nc->getCoord(), source_coord, sink_coord, grid, pin_set_id,
@@ -34,10 +34,10 @@ namespace rt {
 
   private:
 
-    //! Mark all neighboring cells of a given coordinate. Returns a list of 
-    //! neighbors that were successfully marked.
-    QList<sp::Coord> markNeighbors(const sp::Coord &coord, sp::Grid *grid,
-        int pin_set_id, bool &marked, bool allow_rip) const;
+    //! Mark all neighboring cells of a given coordinate and append the ones
+    //! that were successfully marked to the queue. Returns how many were.
+    int markNeighbors(const sp::Coord &coord, sp::Grid *grid, int pin_set_id,
+        bool allow_rip);
 
     //! Mark neighboring cells contageously from the source coordinate until
     //! the specified sink is reached or until no more neighbors are available
@@ -47,7 +47,7 @@ namespace rt {
     bool runLeeMoore(const sp::Coord &source_coord, const sp::Coord &sink_coord,
         sp::Grid *grid, int pin_set_id, sp::Coord &termination, 
         QList<sp::Coord> &term_to_sink_route, bool &result_requires_rip,
-        RoutingRecords *record_keeper=nullptr) const;
+        RoutingRecords *record_keeper=nullptr);
 
     //! Backtrace from the sink (or terminating cell) recursively. To be called
     //! after cells have been marked appropriately. Writes route to the route ref.
@@ -59,6 +59,10 @@ namespace rt {
     bool routed_cells_lower_cost;
     bool attempt_rip;
     QList<sp::Connection*> *rip_blacklist=nullptr;
+
+    // queue kept across searches so that its storage is reused
+    QVector<sp::Coord> queue;   //!< Marked cells in the order to evaluate them.
+    int queue_head=0;           //!< Index of the next cell to evaluate.
   };
 
 }
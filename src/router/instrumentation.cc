@@ -0,0 +1,175 @@
+// @file:     instrumentation.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the router instrumentation classes.
+
+#include <QJsonArray>
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
+#include "instrumentation.h"
+
+using namespace rt;
+
+// RouteCounters struct implementations
+
+void RouteCounters::add(const RouteCounters &other)
+{
+  for (int i=0; i<RouteCounterCount; i++) {
+    counts[i] += other.counts[i];
+  }
+  for (int i=0; i<RouteTimerCount; i++) {
+    nsecs[i] += other.nsecs[i];
+  }
+}
+
+bool RouteCounters::isEmpty() const
+{
+  return std::all_of(counts, counts + RouteCounterCount, [](qint64 c){return c == 0;})
+    && std::all_of(nsecs, nsecs + RouteTimerCount, [](qint64 t){return t == 0;});
+}
+
+QJsonObject RouteCounters::toJson() const
+{
+  QJsonObject obj;
+  for (int i=0; i<RouteCounterCount; i++) {
+    obj[counterName((RouteCounter)i)] = (double)counts[i];
+  }
+  for (int i=0; i<RouteTimerCount; i++) {
+    obj[timerName((RouteTimer)i) + "_ms"] = nsecs[i] / 1e6;
+  }
+  return obj;
+}
+
+QString RouteCounters::summary() const
+{
+  return QString("searches: %1 (%2 ms); expanded: %3; probes: %4; copies: %5; "
+      "rips: %6; reroutes: %7 (%8 ms)")
+    .arg(counts[FindRouteCalls]).arg(nsecs[SearchTimer] / 1000000)
+    .arg(counts[NodesExpanded]).arg(counts[RouteExistsProbes])
+    .arg(counts[GridCopies]).arg(counts[RipAttempts]).arg(counts[Reroutes])
+    .arg(nsecs[RipRerouteTimer] / 1000000);
+}
+
+QString RouteCounters::counterName(RouteCounter counter)
+{
+  switch (counter) {
+    case FindRouteCalls:    return "find_route_calls";
+    case NodesExpanded:     return "nodes_expanded";
+    case QueuePushes:       return "queue_pushes";
+    case QueuePops:         return "queue_pops";
+    case RouteExistsProbes: return "route_exists_probes";
+    case GridCopies:        return "grid_copies";
+    case RipAttempts:       return "rip_attempts";
+    case Reroutes:          return "reroutes";
+    case GlobalReruns:      return "global_reruns";
+    default:                return QString();
+  }
+}
+
+QString RouteCounters::timerName(RouteTimer timer)
+{
+  switch (timer) {
+    case SearchTimer:       return "search";
+    case RipRerouteTimer:   return "rip_reroute";
+    default:                return QString();
+  }
+}
+
+// RouteInstrumentation class implementations
+
+void RouteInstrumentation::reset()
+{
+  attempts.clear();
+  attempts.append(QHash<int, RouteCounters>());
+  curr = RouteCounters();
+  curr_net = -1;
+}
+
+void RouteInstrumentation::beginAttempt()
+{
+  flush();
+  attempts.append(QHash<int, RouteCounters>());
+  curr_net = -1;
+}
+
+void RouteInstrumentation::flush()
+{
+  if (!curr.isEmpty()) {
+    attempts.last()[curr_net].add(curr);
+    curr = RouteCounters();
+  }
+}
+
+RouteCounters RouteInstrumentation::attempt(int i) const
+{
+  RouteCounters sum;
+  if (i < 0 || i >= attempts.size()) {
+    return sum;
+  }
+  for (const RouteCounters &counters : attempts[i]) {
+    sum.add(counters);
+  }
+  if (i == attempts.size()-1) {
+    sum.add(curr);
+  }
+  return sum;
+}
+
+RouteCounters RouteInstrumentation::net(int pin_set_id) const
+{
+  RouteCounters sum;
+  for (const QHash<int, RouteCounters> &nets : attempts) {
+    sum.add(nets.value(pin_set_id));
+  }
+  if (pin_set_id == curr_net) {
+    sum.add(curr);
+  }
+  return sum;
+}
+
+QList<int> RouteInstrumentation::nets() const
+{
+  QSet<int> ids;
+  for (const QHash<int, RouteCounters> &nets : attempts) {
+    for (auto it=nets.constBegin(); it!=nets.constEnd(); ++it) {
+      ids.insert(it.key());
+    }
+  }
+  if (!curr.isEmpty()) {
+    ids.insert(curr_net);
+  }
+  QList<int> sorted = ids.toList();
+  std::sort(sorted.begin(), sorted.end());
+  return sorted;
+}
+
+RouteCounters RouteInstrumentation::total() const
+{
+  RouteCounters sum;
+  for (int i=0; i<attempts.size(); i++) {
+    sum.add(attempt(i));
+  }
+  return sum;
+}
+
+QJsonObject RouteInstrumentation::toJson() const
+{
+  QJsonObject obj;
+  obj["total"] = total().toJson();
+  QJsonArray attempt_arr;
+  for (int i=0; i<attempts.size(); i++) {
+    attempt_arr.append(attempt(i).toJson());
+  }
+  obj["attempts"] = attempt_arr;
+  QJsonArray net_arr;
+  for (int id : nets()) {
+    QJsonObject net_obj = net(id).toJson();
+    net_obj["net"] = id;
+    net_arr.append(net_obj);
+  }
+  obj["nets"] = net_arr;
+  return obj;
+}
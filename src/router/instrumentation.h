@@ -0,0 +1,188 @@
+// @file:     instrumentation.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Counters and timers of router events, compiled in only when
+//            PINROUTER_INSTRUMENT is defined.
+
+#ifndef _RT_INSTRUMENTATION_H_
+#define _RT_INSTRUMENTATION_H_
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QVector>
+
+// Instrumentation macros. Without PINROUTER_INSTRUMENT they expand to empty
+// statements and their arguments are never evaluated, so they can be placed
+// in the inner loops of the routing algorithms.
+#ifdef PINROUTER_INSTRUMENT
+#define RT_COUNT_N(instr, counter, n) \
+  do { if ((instr) != nullptr) (instr)->count(rt::counter, (n)); } while (false)
+#define RT_COUNT(instr, counter) RT_COUNT_N(instr, counter, 1)
+#define RT_TIME_SCOPE(instr, timer) \
+  rt::ScopedRouteTimer rt_scoped_timer_##timer((instr), rt::timer)
+#else
+#define RT_COUNT_N(instr, counter, n) do {} while (false)
+#define RT_COUNT(instr, counter) do {} while (false)
+#define RT_TIME_SCOPE(instr, timer) do {} while (false)
+#endif
+
+namespace rt {
+
+  //! Router events that are counted.
+  enum RouteCounter{
+    FindRouteCalls,     //!< RoutingAlg::findRoute calls.
+    NodesExpanded,      //!< Cells taken off the search queues and expanded.
+    QueuePushes,        //!< Cells queued for expansion.
+    QueuePops,          //!< Cells taken off the search queues.
+    RouteExistsProbes,  //!< Grid::routeExistsBetweenPins calls.
+    GridCopies,         //!< Grid copies and wholesale state copies.
+    RipAttempts,        //!< Rounds of ripping connections out of the way.
+    Reroutes,           //!< Searches rerouting ripped connections.
+    GlobalReruns,       //!< Restarts of the whole suite after failures.
+    RouteCounterCount   //!< Number of counters.
+  };
+
+  //! Router phases that are timed.
+  enum RouteTimer{
+    SearchTimer,        //!< Time spent in RoutingAlg::findRoute.
+    RipRerouteTimer,    //!< Time spent ripping and rerouting, searches included.
+    RouteTimerCount     //!< Number of timers.
+  };
+
+  //! Counts and times aggregated over some part of a routing run.
+  struct RouteCounters
+  {
+    //! Add the counts and times of other to this.
+    void add(const RouteCounters &other);
+
+    //! Return whether nothing has been counted or timed.
+    bool isEmpty() const;
+
+    //! Return the counts and times (in ms) as a JSON object.
+    QJsonObject toJson() const;
+
+    //! Return a compact one-line summary of the main counters and timers.
+    QString summary() const;
+
+    //! Return the name of the provided counter as used in JSON output.
+    static QString counterName(RouteCounter counter);
+
+    //! Return the name of the provided timer as used in JSON output.
+    static QString timerName(RouteTimer timer);
+
+    qint64 counts[RouteCounterCount] = {};  //!< Event counts by RouteCounter.
+    qint64 nsecs[RouteTimerCount] = {};     //!< Elapsed ns by RouteTimer.
+  };
+
+  //! Counters and timers of a routing run, aggregated per solve attempt and
+  //! per net. Attempts line up with the SolveSteps that the run creates in
+  //! its SolveCollection. Events are attributed to the net whose pin pair is
+  //! being routed, including the rerouting of other nets that it rips.
+  //! Events are only recorded through the RT_ macros above, so an
+  //! instrumentation stays empty unless PINROUTER_INSTRUMENT is defined.
+  class RouteInstrumentation
+  {
+  public:
+
+    //! Constructor, starts out with a single empty attempt.
+    RouteInstrumentation() {reset();}
+
+    //! Return whether instrumentation has been compiled in.
+    static bool enabled()
+    {
+#ifdef PINROUTER_INSTRUMENT
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    //! Discard everything and start over with a single empty attempt.
+    void reset();
+
+    //! Start attributing events to a new solve attempt.
+    void beginAttempt();
+
+    //! Start attributing events to the provided net (-1 for none).
+    void beginNet(int pin_set_id)
+    {
+      if (pin_set_id != curr_net) {
+        flush();
+        curr_net = pin_set_id;
+      }
+    }
+
+    //! Count an event, use RT_COUNT instead of calling this directly.
+    void count(RouteCounter counter, qint64 n=1) {curr.counts[counter] += n;}
+
+    //! Add elapsed time, use RT_TIME_SCOPE instead of calling this directly.
+    void addTime(RouteTimer timer, qint64 nsecs) {curr.nsecs[timer] += nsecs;}
+
+    //! Return whether nothing has been recorded.
+    bool isEmpty() const {return total().isEmpty();}
+
+    //! Return the number of solve attempts.
+    int attemptCount() const {return attempts.size();}
+
+    //! Return the counters of the i-th solve attempt summed over all nets.
+    RouteCounters attempt(int i) const;
+
+    //! Return the counters of the provided net summed over all attempts.
+    RouteCounters net(int pin_set_id) const;
+
+    //! Return the nets that have counters, in ascending order.
+    QList<int> nets() const;
+
+    //! Return the counters of the whole run.
+    RouteCounters total() const;
+
+    //! Return the totals, attempts and nets as a JSON object.
+    QJsonObject toJson() const;
+
+  private:
+
+    //! Move the counters of the current net into the current attempt.
+    void flush();
+
+    // Private variables
+    QVector<QHash<int, RouteCounters>> attempts;  //!< Flushed counters by attempt and net.
+    RouteCounters curr;                           //!< Unflushed counters of the current net.
+    int curr_net=-1;                              //!< Net that events are attributed to.
+  };
+
+  //! Add the time elapsed between construction and destruction to a timer of
+  //! the provided instrumentation (if not nullptr). Use RT_TIME_SCOPE.
+  class ScopedRouteTimer
+  {
+  public:
+
+    //! Constructor starting the clock.
+    ScopedRouteTimer(RouteInstrumentation *instr, RouteTimer timer_id)
+      : instr(instr), timer_id(timer_id)
+    {
+      if (instr != nullptr) {
+        timer.start();
+      }
+    }
+
+    //! Destructor adding the elapsed time.
+    ~ScopedRouteTimer()
+    {
+      if (instr != nullptr) {
+        instr->addTime(timer_id, timer.nsecsElapsed());
+      }
+    }
+
+  private:
+
+    RouteInstrumentation *instr;  //!< Instrumentation to add the time to.
+    RouteTimer timer_id;          //!< Timer to add the time to.
+    QElapsedTimer timer;          //!< Clock started on construction.
+  };
+
+}
+
+#endif
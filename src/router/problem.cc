@@ -8,14 +8,149 @@
 #include <QFile>
 #include <QDir>
 #include <QDebug>
+#include <QTextStream>
+#include <QBitArray>
+#include <QHash>
+#include <QtEndian>
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include "problem.h"
 
 using namespace rt;
 
+namespace {
+
+  //! Reads whitespace separated integers straight out of a character buffer
+  //! without any allocation, keeping track of the line number for error
+  //! reporting. Problem files are line based, so line ends are only crossed 
+  //! explicitly.
+  class IntTokenizer
+  {
+  public:
+
+    //! Construct a tokenizer for the characters in [begin, end).
+    IntTokenizer(const char *begin, const char *end) : pos(begin), end(end) {};
+
+    //! Return the current 1-based line number.
+    int lineNumber() const {return line;}
+
+    //! Skip lines that contain nothing but whitespace. Return false if the
+    //! end of the buffer is reached.
+    bool skipBlankLines()
+    {
+      while (true) {
+        skipSpaces();
+        if (pos < end && *pos == '\n') {
+          pos++;
+          line++;
+        } else {
+          return pos < end;
+        }
+      }
+    }
+
+    //! Read an integer on the current line. Return false if there isn't one.
+    bool readInt(int &val)
+    {
+      skipSpaces();
+      bool neg = (pos < end && *pos == '-');
+      const char *p = neg ? pos + 1 : pos;
+      // the magnitude of INT_MIN is one more than INT_MAX
+      const qint64 limit = neg ? -(qint64)INT_MIN : (qint64)INT_MAX;
+      qint64 acc = 0;
+      const char *digits = p;
+      while (p < end && *p >= '0' && *p <= '9' && acc <= limit) {
+        acc = acc * 10 + (*p++ - '0');
+      }
+      if (p == digits || acc > limit || (p < end && !isSpace(*p) && *p != '\n')) {
+        return false;
+      }
+      val = (int)(neg ? -acc : acc);
+      pos = p;
+      return true;
+    }
+
+    //! Return the number of characters left to read.
+    qint64 remaining() const {return end - pos;}
+
+    //! Move on to the next line. Return false if the current line has more
+    //! content.
+    bool endLine()
+    {
+      skipSpaces();
+      if (pos < end && *pos != '\n') {
+        return false;
+      }
+      if (pos < end) {
+        pos++;
+        line++;
+      }
+      return true;
+    }
+
+  private:
+
+    static bool isSpace(char c) {return c == ' ' || c == '\t' || c == '\r';}
+
+    void skipSpaces()
+    {
+      while (pos < end && isSpace(*pos)) {
+        pos++;
+      }
+    }
+
+    const char *pos;  //!< Current position.
+    const char *end;  //!< End of the buffer.
+    int line=1;       //!< Current line number.
+  };
+
+  const char bin_magic[4] = {'P', 'P', 'R', 'B'};  //!< Binary problem magic.
+  const qint32 bin_version = 1;                     //!< Binary problem version.
+
+}
+
+namespace rt {
+
+  //! Immutable problem description shared between copies of a Problem. It is
+  //! only modified while being read, before any Problem refers to it.
+  class ProblemData : public QSharedData
+  {
+  public:
+
+    //! Parse the text format in [begin, end). Return false and set error on
+    //! malformed input.
+    bool parseText(const char *begin, const char *end, QString *error);
+
+    //! Parse the binary format in [begin, end). Return false and set error on
+    //! malformed input.
+    bool parseBinary(const char *begin, const char *end, QString *error);
+
+    //! Add an obstruction cell, extending the last span if possible.
+    void addObsCell(const sp::Coord &coord);
+
+    //! Validate the problem in a single pass over an obstruction bitmap and
+    //! store the result.
+    void validate();
+
+    //! Build a fresh unrouted grid of this problem.
+    sp::Grid *buildGrid() const;
+
+    int dim_x=-1, dim_y=-1;         //!< x and y dimensions.
+    QVector<sp::Segment> obs_spans; //!< Obstruction cells as spans along y.
+    QList<sp::PinSet> pin_sets;     //!< List of sets of pins.
+    bool valid=false;               //!< Validation result.
+    QString validation_error=QObject::tr("No problem has been loaded.");
+                                    //!< Why validation failed.
+  };
+
+}
+
 // Problem class implementations
 
 // Constructor
 Problem::Problem(const QString &in_path)
+  : d(new ProblemData)
 {
   // read problem file if specified, otherwise keep the problem as an empty one
   if (!in_path.isEmpty()) {
@@ -26,177 +161,424 @@ Problem::Problem(const QString &in_path)
   }
 }
 
+Problem::Problem(const Problem &other)
+  : d(other.d), read_error(other.read_error)
+{
+  // the grid isn't copied, this copy builds its own when it's needed
+}
+
+Problem::~Problem()
+{
+}
+
+Problem &Problem::operator=(const Problem &other)
+{
+  if (this != &other) {
+    d = other.d;
+    read_error = other.read_error;
+    cell_grid.reset();
+  }
+  return *this;
+}
+
 // Read problem
 bool Problem::readProblem(const QString &in_path)
 {
+  // start from an empty problem
+  d = new ProblemData;
+  cell_grid.reset();
+  read_error.clear();
+
   // attempt to open the input file for reading
   QFile in_file(in_path);
   qDebug() << QObject::tr("Attempting to read input file %1...").arg(in_path);
-  if (!in_file.open(QFile::ReadOnly | QFile::Text)) {
-    qDebug() << "Unable to open file for reading.";
+  if (!in_file.open(QFile::ReadOnly)) {
+    read_error = QObject::tr("Unable to open file for reading.");
+    qDebug() << read_error;
     return false;
   }
 
-  // lambda function for splitting pairs of ints from strings and assigning 
-  // them to provided refs; the delimitor can be changed
-  auto readStrPairToInts = [](const QString &line, int &a, int &b, 
-      const QString &delim=" ") -> bool
-  {
-    QStringList dims(line.split(delim));
-    if (dims.size() == 2) {
-      a = dims[0].toInt();
-      b = dims[1].toInt();
-      return true;
+  // map the file and parse it in place, falling back to reading the whole
+  // file if it can't be mapped (e.g. compressed resources)
+  qint64 size = in_file.size();
+  const char *data = (size > 0) ? (const char*)in_file.map(0, size) : nullptr;
+  QByteArray fallback;
+  if (data == nullptr) {
+    fallback = in_file.readAll();
+    data = fallback.constData();
+    size = fallback.size();
+  }
+
+  // the format is told apart by the binary magic
+  ProblemData *new_d = new ProblemData;
+  bool success;
+  if (size >= 4 && memcmp(data, bin_magic, 4) == 0) {
+    success = new_d->parseBinary(data, data + size, &read_error);
+  } else {
+    success = new_d->parseText(data, data + size, &read_error);
+  }
+  in_file.close();
+  if (!success) {
+    delete new_d;
+    qDebug() << read_error;
+    return false;
+  }
+  new_d->obs_spans.squeeze();
+  new_d->validate();
+  d = new_d;
+  qDebug() << "Successfully read the problem file.";
+  return true;
+}
+
+bool Problem::setProblem(const sp::Coord &dims, const QVector<sp::Segment> &obs_spans,
+    const QList<sp::PinSet> &pin_sets)
+{
+  ProblemData *new_d = new ProblemData;
+  new_d->dim_x = dims.x;
+  new_d->dim_y = dims.y;
+  new_d->obs_spans = obs_spans;
+  new_d->pin_sets = pin_sets;
+  new_d->validate();
+  d = new_d;
+  cell_grid.reset();
+  read_error.clear();
+  return d->valid;
+}
+
+bool Problem::writeProblem(const QString &out_path, ProblemFormat format) const
+{
+  QByteArray buf;
+  if (format == BinaryFormat) {
+    auto writeInt = [&buf](qint32 val)
+    {
+      uchar bytes[4];
+      qToLittleEndian(val, bytes);
+      buf.append((const char*)bytes, 4);
+    };
+    int pin_count = 0;
+    for (const sp::PinSet &pin_set : d->pin_sets) {
+      pin_count += pin_set.size();
+    }
+    buf.reserve(4 * (5 + 3*d->obs_spans.size() + d->pin_sets.size() + 2*pin_count + 1));
+    buf.append(bin_magic, 4);
+    writeInt(bin_version);
+    writeInt(d->dim_x);
+    writeInt(d->dim_y);
+    writeInt(d->obs_spans.size());
+    for (const sp::Segment &span : d->obs_spans) {
+      writeInt(span.start.x);
+      writeInt(span.start.y);
+      writeInt(span.length);
     }
+    writeInt(d->pin_sets.size());
+    for (const sp::PinSet &pin_set : d->pin_sets) {
+      writeInt(pin_set.size());
+      for (const sp::Coord &pin : pin_set) {
+        writeInt(pin.x);
+        writeInt(pin.y);
+      }
+    }
+  } else {
+    int obs_count = 0;
+    for (const sp::Segment &span : d->obs_spans) {
+      obs_count += span.length;
+    }
+    QTextStream out(&buf);
+    out << d->dim_x << " " << d->dim_y << "\n" << obs_count << "\n";
+    for (const sp::Segment &span : d->obs_spans) {
+      for (int i=0; i<span.length; i++) {
+        out << span.start.x << " " << span.start.y + i << "\n";
+      }
+    }
+    out << d->pin_sets.size() << "\n";
+    for (const sp::PinSet &pin_set : d->pin_sets) {
+      out << pin_set.size();
+      for (const sp::Coord &pin : pin_set) {
+        out << " " << pin.x << " " << pin.y;
+      }
+      out << "\n";
+    }
+    out.flush();
+  }
+
+  QFile out_file(out_path);
+  if (!out_file.open(QFile::WriteOnly | QFile::Truncate)) {
+    qDebug() << QObject::tr("Unable to open %1 for writing.").arg(out_path);
     return false;
+  }
+  return out_file.write(buf) == buf.size();
+}
+
+Problem::ProblemFormat Problem::formatForPath(const QString &path)
+{
+  return path.endsWith(".pbin", Qt::CaseInsensitive) ? BinaryFormat : TextFormat;
+}
+
+bool ProblemData::parseText(const char *begin, const char *end, QString *error)
+{
+  auto fail = [error](int line, const QString &msg) -> bool
+  {
+    *error = QObject::tr("Line %1: %2").arg(line).arg(msg);
+    return false;
+  };
+
+  IntTokenizer tok(begin, end);
+  // counts come from the file, so only reserve what the rest of it can hold
+  auto capped = [&tok](int count, int min_bytes) -> int
+  {
+    return (int)qMin<qint64>(count, tok.remaining() / min_bytes + 1);
   };
 
-  // lambda function for reading sinks into the provided coordinates ref.
-  auto readGridPoints = [](const QString &line, sp::PinSet &coords,
-      const QString &delim=" ") -> bool
+  // grid size
+  if (!tok.skipBlankLines()) {
+    return fail(tok.lineNumber(), QObject::tr("Expected the grid size but the "
+          "file is empty."));
+  }
+  if (!tok.readInt(dim_x) || !tok.readInt(dim_y) || !tok.endLine()) {
+    return fail(tok.lineNumber(), QObject::tr("Expected the grid size as two "
+          "integers."));
+  }
+
+  // obstruction cells
+  int obs_count;
+  if (!tok.skipBlankLines() || !tok.readInt(obs_count) || obs_count < 0
+      || !tok.endLine()) {
+    return fail(tok.lineNumber(), QObject::tr("Expected the obstruction cell "
+          "count."));
+  }
+  obs_spans.reserve(capped(obs_count, 4));
+  for (int i=0; i<obs_count; i++) {
+    int x, y;
+    if (!tok.skipBlankLines()) {
+      return fail(tok.lineNumber(), QObject::tr("Expected %1 obstruction cells "
+            "but only found %2.").arg(obs_count).arg(i));
+    }
+    if (!tok.readInt(x) || !tok.readInt(y) || !tok.endLine()) {
+      return fail(tok.lineNumber(), QObject::tr("Expected obstruction cell "
+            "coordinates as two integers."));
+    }
+    addObsCell(sp::Coord(x, y));
+  }
+
+  // pin sets
+  int pin_set_count;
+  if (!tok.skipBlankLines() || !tok.readInt(pin_set_count) || pin_set_count < 0
+      || !tok.endLine()) {
+    return fail(tok.lineNumber(), QObject::tr("Expected the pin set count."));
+  }
+  pin_sets.reserve(capped(pin_set_count, 2));
+  for (int i=0; i<pin_set_count; i++) {
+    int pin_count;
+    if (!tok.skipBlankLines()) {
+      return fail(tok.lineNumber(), QObject::tr("Expected %1 pin sets but only "
+            "found %2.").arg(pin_set_count).arg(i));
+    }
+    if (!tok.readInt(pin_count) || pin_count < 0) {
+      return fail(tok.lineNumber(), QObject::tr("Expected the pin count of a "
+            "pin set."));
+    }
+    sp::PinSet pin_set;
+    pin_set.reserve(capped(pin_count, 4));
+    for (int j=0; j<pin_count; j++) {
+      int x, y;
+      if (!tok.readInt(x) || !tok.readInt(y)) {
+        return fail(tok.lineNumber(), QObject::tr("Expected %1 pin coordinate "
+              "pairs but only found %2.").arg(pin_count).arg(j));
+      }
+      pin_set.append(sp::Coord(x, y));
+    }
+    if (!tok.endLine()) {
+      return fail(tok.lineNumber(), QObject::tr("Found more than the %1 "
+            "declared pin coordinate pairs.").arg(pin_count));
+    }
+    pin_sets.append(pin_set);
+  }
+  // anything after the pin sets is ignored
+  return true;
+}
+
+bool ProblemData::parseBinary(const char *begin, const char *end, QString *error)
+{
+  const char *pos = begin + 4;  // skip the magic
+  auto fail = [error, begin, &pos](const QString &msg) -> bool
   {
-    QStringList pts(line.split(delim));
-    int num_grid_pts = pts.takeFirst().toInt();
-    while (!pts.empty()) {
-      int x = pts.takeFirst().toInt();
-      int y = pts.takeFirst().toInt();
-      coords.append(sp::Coord(x, y));
-    }
-    if (num_grid_pts != coords.size()) {
-      qDebug() << QObject::tr("%1 grid points expected but %2 points retrieved."
-          " Something is wrong.").arg(num_grid_pts).arg(coords.size());
+    *error = QObject::tr("Byte %1: %2").arg(pos - begin).arg(msg);
+    return false;
+  };
+  auto readInts = [&pos, end](qint32 *vals, int count) -> bool
+  {
+    if (end - pos < 4 * count) {
       return false;
     }
+    for (int i=0; i<count; i++) {
+      vals[i] = qFromLittleEndian<qint32>((const uchar*)pos);
+      pos += 4;
+    }
     return true;
   };
 
-  // parse the file
-  QTextStream out(&in_file);
-  int remaining_o_cells=-1;
-  int remaining_pins=-1;
-  ReadPhase phase = GridSize;
-  while (!in_file.atEnd()) {
-    QString line = in_file.readLine().trimmed();
-    switch (phase)
-    {
-      // read grid size
-      case GridSize:
-        {
-          bool success = readStrPairToInts(line, dim_x, dim_y);
-          if (!success) {
-            qDebug() << "Unexpected number of values received for GridSize";
-            return false;
-          }
-          phase = ObsCellCount;   // proceed to next phase
-          break;
-        }
-      // read obstruction cell count
-      case ObsCellCount:
-        {
-          remaining_o_cells = line.toInt();
-          if (remaining_o_cells != 0) {
-            phase = ObsCells;       // proceed to next phase
-          } else {
-            phase = PinCount;       // skip to pin count phase if no obs cells
-          }
-          break;
-        }
-      // read obstruction cells
-      case ObsCells:
-        {
-          // read obstruction cell and add to list
-          int x, y;
-          bool success = readStrPairToInts(line, x, y);
-          if (!success) {
-            qDebug() << "Unexpected number of values received for obstruction "
-                "cell coordinates";
-          }
-          obs_cells.append(sp::Coord(x, y));
-          
-          // bookkeeping
-          if (--remaining_o_cells == 0) {
-            phase = PinCount;   // proceed to next phase
-          }
-          break;
-        }
-      case PinCount:
-        {
-          remaining_pins = line.toInt();
-          if (remaining_pins != 0) {
-            phase = Pins;       // proceed to next phase
-          } else {
-            phase = Finished;   // done if no pins to read
-          }
-          break;
-        }
-      case Pins:
-        {
-          sp::PinSet grid_pts;
-          bool success = readGridPoints(line, grid_pts);
-          if (success) {
-            pin_sets.append(grid_pts);
-          } else {
-            return false;
-          }
-
-          // bookkeeping
-          if (--remaining_pins == 0) {
-            phase = Finished;
-          }
-          break;
-        }
-      case Finished:
-      default:
-        break;
+  qint32 header[4];   // version, dim_x, dim_y, obstruction span count
+  if (!readInts(header, 4)) {
+    return fail(QObject::tr("Truncated header."));
+  }
+  if (header[0] != bin_version) {
+    return fail(QObject::tr("Unsupported binary problem version %1.").arg(header[0]));
+  }
+  dim_x = header[1];
+  dim_y = header[2];
+  qint32 span_count = header[3];
+  if (span_count < 0 || end - pos < 12 * (qint64)span_count) {
+    return fail(QObject::tr("Truncated obstruction spans."));
+  }
+  obs_spans.resize(span_count);
+  for (sp::Segment &span : obs_spans) {
+    qint32 vals[3];
+    readInts(vals, 3);
+    span = sp::Segment(sp::Coord(vals[0], vals[1]), sp::Segment::PosY, vals[2]);
+  }
+
+  qint32 pin_set_count;
+  if (!readInts(&pin_set_count, 1) || pin_set_count < 0) {
+    return fail(QObject::tr("Expected the pin set count."));
+  }
+  // every pin set takes at least its count
+  pin_sets.reserve((int)qMin<qint64>(pin_set_count, (end - pos) / 4));
+  for (int i=0; i<pin_set_count; i++) {
+    qint32 pin_count;
+    if (!readInts(&pin_count, 1) || pin_count < 0 
+        || end - pos < 8 * (qint64)pin_count) {
+      return fail(QObject::tr("Truncated pin set %1.").arg(i));
+    }
+    sp::PinSet pin_set;
+    pin_set.reserve(pin_count);
+    for (int j=0; j<pin_count; j++) {
+      qint32 xy[2];
+      readInts(xy, 2);
+      pin_set.append(sp::Coord(xy[0], xy[1]));
     }
+    pin_sets.append(pin_set);
   }
-  in_file.close();
-  refreshGrid();
-  qDebug() << "Successfully read the problem file.";
   return true;
 }
 
+void ProblemData::addObsCell(const sp::Coord &coord)
+{
+  // extend the last span if the cell continues it
+  if (!obs_spans.isEmpty()) {
+    sp::Segment &last = obs_spans.last();
+    if (last.start.x == coord.x && last.start.y + last.length == coord.y) {
+      last.length++;
+      return;
+    }
+  }
+  obs_spans.append(sp::Segment(coord, sp::Segment::PosY, 1));
+}
+
 bool Problem::isValid() const
 {
-  // simplest checks
-  if (dim_x <= 0 || dim_y <= 0 || pin_sets.empty()) {
-    return false;
+  return d->valid;
+}
+
+QString Problem::validationError() const
+{
+  return d->validation_error;
+}
+
+sp::Coord Problem::dimensions() const
+{
+  return sp::Coord(d->dim_x, d->dim_y);
+}
+
+sp::Grid *Problem::cellGrid()
+{
+  if (cell_grid.isNull()) {
+    cell_grid.reset(d->buildGrid());
   }
+  return cell_grid.data();
+}
+
+QList<sp::PinSet> Problem::pinSets() const
+{
+  return d->pin_sets;
+}
 
-  // out of bound errors
-  auto allInBound = [this](QList<sp::Coord> coords)->bool
+void ProblemData::validate()
+{
+  auto invalidate = [this](const QString &msg)
   {
-    // return whether all of the coordinates in a provided iterable containing
-    // coords are within bounds
-    return std::all_of(coords.begin(), coords.end(),
-        [this](sp::Coord coord){return coord.isWithinBounds(dim_x, dim_y);});
+    valid = false;
+    validation_error = msg;
+    qDebug() << msg;
   };
-  // apply the boundary check on obstruction cells and sets of pins
-  bool in_bound = std::all_of(pin_sets.begin(), pin_sets.end(), 
-      [allInBound](sp::PinSet pin_set){return allInBound(pin_set);});
-  in_bound &= allInBound(obs_cells);
-  if (!in_bound) {
-    qDebug() << "Problem contains out of bound pins or obstruction cells.";
-    return false;
+
+  // simplest checks
+  if (dim_x <= 0 || dim_y <= 0) {
+    return invalidate(QObject::tr("The grid size must be positive."));
+  }
+  if ((qint64)dim_x * dim_y > sp::Grid::maxCells()) {
+    return invalidate(QObject::tr("The grid is too large, at most %1 cells are supported.")
+        .arg(sp::Grid::maxCells()));
+  }
+  if (pin_sets.isEmpty()) {
+    return invalidate(QObject::tr("The problem contains no pins."));
   }
 
-  // find coordinate clashes between obstruction cells and pins
-  for (sp::Coord obs_coord : obs_cells) {
-    for (sp::PinSet pin_set : pin_sets) {
-      for (sp::Coord pin_coord : pin_set) {
-        if (obs_coord == pin_coord) {
-          qDebug() << "Found clashing pin and obstruction cell coordinates.";
-          return false;
-        }
+  // mark obstruction cells in a bitmap indexed along y first, spans are then
+  // contiguous ranges of bits
+  auto index = [this](const sp::Coord &coord) {return coord.x * dim_y + coord.y;};
+  QBitArray obs_bits(dim_x * dim_y);
+  for (const sp::Segment &span : obs_spans) {
+    if (span.dir != sp::Segment::PosY || span.length <= 0
+        || !span.start.isWithinBounds(dim_x, dim_y)
+        || !span.end().isWithinBounds(dim_x, dim_y)) {
+      return invalidate(QObject::tr("Obstruction cells starting at %1 are out of "
+            "bounds.").arg(span.start.str()));
+    }
+    obs_bits.fill(true, index(span.start), index(span.start) + span.length);
+  }
+
+  // check each pin against the bitmap and the pins seen before it
+  int pin_count = 0;
+  for (const sp::PinSet &pin_set : pin_sets) {
+    pin_count += pin_set.size();
+  }
+  QHash<int, int> pin_owners;   // cell index to pin set id
+  pin_owners.reserve(pin_count);
+  for (int id=0; id<pin_sets.size(); id++) {
+    for (const sp::Coord &pin : pin_sets[id]) {
+      if (!pin.isWithinBounds(dim_x, dim_y)) {
+        return invalidate(QObject::tr("Pin %1 of net %2 is out of bounds.")
+            .arg(pin.str()).arg(id));
+      }
+      int i = index(pin);
+      if (obs_bits.testBit(i)) {
+        return invalidate(QObject::tr("Pin %1 of net %2 clashes with an "
+              "obstruction cell.").arg(pin.str()).arg(id));
+      }
+      auto owner = pin_owners.constFind(i);
+      if (owner == pin_owners.constEnd()) {
+        pin_owners.insert(i, id);
+      } else if (owner.value() == id) {
+        return invalidate(QObject::tr("Pin %1 appears more than once in net %2.")
+            .arg(pin.str()).arg(id));
+      } else {
+        return invalidate(QObject::tr("Pin %1 is shared by nets %2 and %3.")
+            .arg(pin.str()).arg(owner.value()).arg(id));
       }
     }
   }
 
-  return true;
+  valid = true;
+  validation_error.clear();
 }
 
-void Problem::refreshGrid()
+sp::Grid *ProblemData::buildGrid() const
 {
-  cell_grid = sp::Grid(dim_x, dim_y, obs_cells, pin_sets);
+  sp::Grid *grid = new sp::Grid(qMax(dim_x, 0), qMax(dim_y, 0));
+  grid->setObsSpans(obs_spans);
+  for (int id=0; id<pin_sets.size(); id++) {
+    grid->setPinCells(pin_sets[id], id);
+  }
+  return grid;
 }
 
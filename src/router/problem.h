@@ -10,6 +10,8 @@
 
 #include <QObject>
 #include <QMap>
+#include <QSharedData>
+#include <QScopedPointer>
 #include <algorithm>
 #include "spatial.h"
 
@@ -17,56 +19,90 @@
 namespace rt {
 
 
+  class ProblemData;
+
   //! A routing problem to be routed. Contains the problem dimensions, various
   //! collections of cells, etc.
+  //!
+  //! The problem description is immutable and implicitly shared, so copies 
+  //! are cheap. The mutable routing grid is only built when cellGrid() is 
+  //! first called on a copy; each copy builds its own unrouted grid.
+  //!
+  //! Problems are read from either the text .infile format or a versioned 
+  //! little-endian binary format (.pbin), which is detected by its magic. The
+  //! binary format consists of the magic "PPRB", the version, the grid size,
+  //! the obstruction cells as spans along y (x, y, length) and the pin sets 
+  //! (pin count followed by x, y pairs), all as 32-bit integers.
   class Problem
   {
   public:
-    //! Stages when reading the input file.
-    enum ReadPhase{GridSize, ObsCellCount, ObsCells, PinCount, Pins, Finished};
-    
+
+    //! File formats that problems can be written in.
+    enum ProblemFormat{TextFormat, BinaryFormat};
+
     //! Constructor for a problem to be routed, taking the problem file as input.
     Problem(const QString &in_path="");
 
-    //! Copy constructor
-    Problem(const Problem &other) 
-      : dim_x(other.dim_x), dim_y(other.dim_y), obs_cells(other.obs_cells), 
-        pin_sets(other.pin_sets) {refreshGrid();}
+    //! Copy constructor, shares the problem description but not the grid.
+    Problem(const Problem &other);
 
     //! Destructor.
-    ~Problem() {};
+    ~Problem();
+
+    //! Assignment operator, shares the problem description but not the grid.
+    Problem &operator=(const Problem &other);
 
     //! Read the problem from the input path. Return true if successful, false
-    //! otherwise (e.g. if input file contains invalid formatting).
+    //! otherwise (e.g. if input file contains invalid formatting), in which 
+    //! case lastError() describes the problem and the offending line. The 
+    //! problem is validated once after reading.
     bool readProblem(const QString &in_path);
 
+    //! Replace the problem with the provided one, e.g. a generated problem.
+    //! Obstruction cells are provided as spans along the y direction. The
+    //! problem is validated and the validation result returned.
+    bool setProblem(const sp::Coord &dims, const QVector<sp::Segment> &obs_spans,
+        const QList<sp::PinSet> &pin_sets);
+
+    //! Return why the last readProblem call failed (empty if it didn't).
+    QString lastError() const {return read_error;}
+
+    //! Write the problem to the output path in the provided format. Return
+    //! false if the file can't be written.
+    bool writeProblem(const QString &out_path, ProblemFormat format) const;
+
+    //! Return the format implied by the extension of the provided path 
+    //! (.pbin for binary, text otherwise).
+    static ProblemFormat formatForPath(const QString &path);
+
     //! Return whether this problem is valid. Invalid if there are no pins at 
     //! all, if pins/obstruction cells exist outside of the specified 
-    //! x and y dimensions, or if there are overlaps between pins and 
-    //! obstruction cells.
+    //! x and y dimensions, if there are overlaps between pins and 
+    //! obstruction cells or if a pin appears more than once (in the same or
+    //! in different nets).
     bool isValid() const;
 
+    //! Return why the problem is invalid (empty if it's valid).
+    QString validationError() const;
+
     //! Return the dimensions of the problem as a Coord(dim_x, dim_y). There 
     //! should be cells in the ranges [0,dim_x) and [0,dim_y) in the x and y 
     //! directions.
-    sp::Coord dimensions() const {return sp::Coord(dim_x, dim_y);}
+    sp::Coord dimensions() const;
 
-    //! Return a pointer to the cell grid
-    sp::Grid *cellGrid() {return &cell_grid;}
+    //! Return a pointer to the cell grid, building it if this copy of the 
+    //! problem doesn't have one yet.
+    sp::Grid *cellGrid();
 
     //! Return a list of pin sets.
-    QList<sp::PinSet> pinSets() const {return pin_sets;}
+    QList<sp::PinSet> pinSets() const;
 
   private:
 
-    //! Construct cell map.
-    void refreshGrid();
-
     // Private variables:
-    int dim_x=-1, dim_y=-1;       //!< x and y dimensions.
-    QList<sp::Coord> obs_cells;   //!< List of obstruction cells.
-    QList<sp::PinSet> pin_sets;   //!< List of sets of pins
-    sp::Grid cell_grid;           //!< Grid of cells in the problem
+    QExplicitlySharedDataPointer<const ProblemData> d; //!< Shared description.
+    QScopedPointer<sp::Grid> cell_grid; //!< Grid of cells, built on demand.
+    QString read_error;                 //!< Why the last read failed.
   };
 }
 
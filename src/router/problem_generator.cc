@@ -0,0 +1,178 @@
+// @file:     problem_generator.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the ProblemGenerator class.
+
+#include <QBitArray>
+#include <QtMath>
+#include <random>
+#include "problem_generator.h"
+
+using namespace rt;
+
+namespace {
+
+  //! Random numbers derived from the raw output of a Mersenne Twister. The
+  //! standard distributions are avoided since their results differ between
+  //! standard library implementations.
+  class GenRandom
+  {
+  public:
+
+    //! Constructor taking the seed.
+    GenRandom(quint32 seed) : engine(seed) {};
+
+    //! Return an integer in [0, n).
+    int below(int n) {return (int)(engine() % (quint32)n);}
+
+    //! Return an integer in [lo, hi].
+    int between(int lo, int hi) {return lo + below(hi - lo + 1);}
+
+    //! Return a real number in [0, 1).
+    double unit() {return engine() / 4294967296.0;}
+
+  private:
+
+    std::mt19937 engine;  //!< Underlying engine.
+  };
+
+  const int max_dim = 10000;      //!< Largest supported grid side.
+  const int window_attempts = 8;  //!< Windows tried per net before leaving it out.
+
+}
+
+bool ProblemGenerator::generate(const GeneratorSettings &settings, Problem *problem,
+    QString *error)
+{
+  auto fail = [error](const QString &msg) -> bool
+  {
+    if (error != nullptr) {
+      *error = msg;
+    }
+    return false;
+  };
+
+  const GeneratorSettings &s = settings;
+  if (s.dim_x < 1 || s.dim_y < 1 || s.dim_x > max_dim || s.dim_y > max_dim) {
+    return fail(QObject::tr("The grid size must be between 1 and %1.").arg(max_dim));
+  }
+  if (s.obs_density < 0 || s.obs_density > 0.9) {
+    return fail(QObject::tr("The obstruction density must be between 0 and 0.9."));
+  }
+  if (s.obs_clustering < 0 || s.obs_clustering > 1 || s.max_cluster_size < 1) {
+    return fail(QObject::tr("The obstruction clustering must be between 0 and 1."));
+  }
+  if (s.net_count < 1 || s.min_pins < 1 || s.max_pins < s.min_pins) {
+    return fail(QObject::tr("There must be at least one net with a valid pin count range."));
+  }
+  int max_span = (s.max_span < 0) ? qMax(s.dim_x, s.dim_y) : s.max_span;
+  if (s.min_span < 1 || max_span < s.min_span) {
+    return fail(QObject::tr("The net span range is invalid."));
+  }
+
+  GenRandom rng(s.seed);
+  int dim_x = s.dim_x;
+  int dim_y = s.dim_y;
+  auto index = [dim_y](int x, int y) {return x * dim_y + y;};
+  QBitArray taken(dim_x * dim_y);
+
+  // place obstruction blocks until the density is reached, giving up after
+  // a generous number of attempts in case the grid is nearly full
+  qint64 obs_target = (qint64)(s.obs_density * dim_x * dim_y);
+  int max_side = 1 + qRound(s.obs_clustering * (s.max_cluster_size - 1));
+  qint64 obs_count = 0;
+  for (qint64 attempts = 20 * obs_target; obs_count < obs_target && attempts > 0; attempts--) {
+    int w = qMin(rng.between(1, max_side), dim_x);
+    int h = qMin(rng.between(1, max_side), dim_y);
+    int x0 = rng.below(dim_x - w + 1);
+    int y0 = rng.below(dim_y - h + 1);
+    for (int x=x0; x<x0+w && obs_count<obs_target; x++) {
+      for (int y=y0; y<y0+h && obs_count<obs_target; y++) {
+        if (!taken.testBit(index(x, y))) {
+          taken.setBit(index(x, y));
+          obs_count++;
+        }
+      }
+    }
+  }
+
+  // collect the obstruction cells as spans along y before pins are marked
+  QVector<sp::Segment> obs_spans;
+  for (int x=0; x<dim_x; x++) {
+    int y = 0;
+    while (y < dim_y) {
+      if (!taken.testBit(index(x, y))) {
+        y++;
+        continue;
+      }
+      int y_start = y;
+      while (y < dim_y && taken.testBit(index(x, y))) {
+        y++;
+      }
+      obs_spans.append(sp::Segment(sp::Coord(x, y_start), sp::Segment::PosY, y - y_start));
+    }
+  }
+
+  // place nets, each within a window of the drawn span
+  QList<sp::PinSet> pin_sets;
+  for (int i=0; i<s.net_count; i++) {
+    int pin_count = rng.between(s.min_pins, s.max_pins);
+    sp::PinSet pin_set;
+    for (int w_attempt=0; w_attempt<window_attempts && pin_set.size()<pin_count; w_attempt++) {
+      int span;
+      if (s.span_dist == GeneratorSettings::LogUniformSpan) {
+        span = qRound(s.min_span * qPow((double)max_span / s.min_span, rng.unit()));
+      } else {
+        span = rng.between(s.min_span, max_span);
+      }
+      int w = qBound(1, span, dim_x);
+      int h = qBound(1, span, dim_y);
+      int x0 = rng.below(dim_x - w + 1);
+      int y0 = rng.below(dim_y - h + 1);
+
+      // release the pins of a failed window before trying the next one
+      for (const sp::Coord &pin : pin_set) {
+        taken.clearBit(index(pin.x, pin.y));
+      }
+      pin_set.clear();
+      for (int p_attempt=0; p_attempt<16*pin_count && pin_set.size()<pin_count; p_attempt++) {
+        int x = x0 + rng.below(w);
+        int y = y0 + rng.below(h);
+        if (!taken.testBit(index(x, y))) {
+          taken.setBit(index(x, y));
+          pin_set.append(sp::Coord(x, y));
+        }
+      }
+    }
+    if (pin_set.size() == pin_count) {
+      pin_sets.append(pin_set);
+    } else {
+      for (const sp::Coord &pin : pin_set) {
+        taken.clearBit(index(pin.x, pin.y));
+      }
+    }
+  }
+
+  if (!problem->setProblem(sp::Coord(dim_x, dim_y), obs_spans, pin_sets)) {
+    return fail(problem->validationError());
+  }
+  return true;
+}
+
+bool ProblemGenerator::generateFile(const GeneratorSettings &settings,
+    const QString &out_path, QString *error)
+{
+  Problem problem;
+  if (!generate(settings, &problem, error)) {
+    return false;
+  }
+  if (!problem.writeProblem(out_path, Problem::formatForPath(out_path))) {
+    if (error != nullptr) {
+      *error = QObject::tr("Unable to write %1.").arg(out_path);
+    }
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,63 @@
+// @file:     problem_generator.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Generation of random routing problems for scaling studies.
+
+#ifndef _RT_PROBLEM_GENERATOR_H_
+#define _RT_PROBLEM_GENERATOR_H_
+
+#include "problem.h"
+
+namespace rt {
+
+  //! Parameters of a generated problem.
+  struct GeneratorSettings
+  {
+    //! How the spans of nets are distributed between min_span and max_span.
+    //! Log-uniform spans make short nets much more common than long ones.
+    enum SpanDistribution{UniformSpan, LogUniformSpan};
+
+    int dim_x=64;                 //!< x size of the grid.
+    int dim_y=64;                 //!< y size of the grid.
+    double obs_density=0.1;       //!< Fraction of cells obstructed, at most 0.9.
+    double obs_clustering=0;      //!< 0 scatters single obstruction cells, 1 places blocks of up to max_cluster_size cells a side.
+    int max_cluster_size=32;      //!< Largest side of an obstruction block.
+    int net_count=16;             //!< Number of nets.
+    int min_pins=2;               //!< Fewest pins per net.
+    int max_pins=4;               //!< Most pins per net.
+    int min_span=4;               //!< Smallest side of the window that a net's pins are placed in.
+    int max_span=-1;              //!< Largest side of a net's window (-1 for the grid size).
+    SpanDistribution span_dist=LogUniformSpan;  //!< Distribution of net spans.
+    quint32 seed=1;               //!< Seed of the random number generator.
+  };
+
+  //! Generates random valid problems of up to 10k by 10k cells. Obstruction
+  //! cells are placed first as rectangular blocks whose size grows with the
+  //! clustering, until the density is reached. Each net then draws a span,
+  //! places a window of that size at random and places its pins on free cells
+  //! within the window. The same settings always produce the same problem on
+  //! every platform.
+  class ProblemGenerator
+  {
+  public:
+
+    //! Generate a problem with the provided settings into problem. Returns
+    //! false if the settings are out of range, in which case error (if
+    //! provided) says why. Nets for which too few free cells can be found
+    //! are left out, so crowded problems may have fewer nets than requested.
+    static bool generate(const GeneratorSettings &settings, Problem *problem,
+        QString *error=nullptr);
+
+    //! Generate a problem with the provided settings and write it to the
+    //! provided path, in the format implied by its extension. Returns false
+    //! if the settings are out of range or the file can't be written, in
+    //! which case error (if provided) says why.
+    static bool generateFile(const GeneratorSettings &settings,
+        const QString &out_path, QString *error=nullptr);
+  };
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+// @file:     route_api.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the pinrouter_core API.
+
+#include <QElapsedTimer>
+#include "route_api.h"
+
+using namespace rt;
+
+bool rt::loadProblem(const QString &in_path, Problem *problem, QString *error)
+{
+  if (!problem->readProblem(in_path)) {
+    if (error != nullptr) {
+      *error = QObject::tr("Unable to read problem file %1. %2").arg(in_path)
+        .arg(problem->lastError());
+    }
+    return false;
+  }
+  if (!problem->isValid()) {
+    if (error != nullptr) {
+      *error = QObject::tr("Problem file %1 describes an invalid problem. %2")
+        .arg(in_path).arg(problem->validationError());
+    }
+    return false;
+  }
+  return true;
+}
+
+namespace {
+
+  //! Route a copy of the provided problem, either from scratch or on top of
+  //! the provided prior connections, and collect the results.
+  RouteOutput runRouter(const Problem &problem, const QList<sp::Connection> *prior_conns,
+      const RouterSettings &settings, CancelToken *cancel, SolveCollection *solve_col)
+  {
+    RouteOutput output;
+
+    // don't pay for logging that nobody will look at
+    RouterSettings run_settings = settings;
+    if (solve_col == nullptr && settings.step_log_path.isEmpty()) {
+      run_settings.log_level = LogNone;
+    }
+    if (solve_col == nullptr) {
+      run_settings.gui_update_level = VisualizeNone;
+    }
+    CancelToken local_cancel;
+    if (cancel == nullptr) {
+      cancel = &local_cancel;
+    }
+
+    // route on a copy so the provided problem stays untouched
+    Problem problem_cp(problem);
+    Router router(problem_cp, run_settings);
+    QElapsedTimer timer;
+    timer.start();
+    if (prior_conns == nullptr) {
+      output.stats.success = router.routeSuite(problem_cp.pinSets(),
+          problem_cp.cellGrid(), cancel, solve_col);
+    } else {
+      IncrementalSummary summary;
+      output.stats.success = router.routeIncremental(problem_cp.pinSets(),
+          problem_cp.cellGrid(), *prior_conns, cancel, solve_col, &summary);
+      output.stats.kept_connections = summary.kept_connections;
+      output.stats.invalidated_connections = summary.invalidated_connections;
+    }
+    output.stats.time_ms = timer.elapsed();
+
+    // collect results
+    sp::Grid *grid = problem_cp.cellGrid();
+    output.stats.segments = grid->countSegments();
+    output.stats.routed_cells = grid->countCells({sp::RoutedCell});
+    output.stats.searches = router.budget()->searchCount();
+    output.stats.expansions = router.budget()->expansionCount();
+    output.stats.budget_exhausted = router.budget()->exhausted();
+    output.stats.instrumentation = *router.recordKeeper()->instrumentation();
+    output.grid = QSharedPointer<sp::Grid>(new sp::Grid(grid));
+    QSet<sp::Connection*> collected;
+    for (auto it=grid->connMap()->constBegin(); it!=grid->connMap()->constEnd(); ++it) {
+      if (!collected.contains(it.value())) {
+        collected.insert(it.value());
+        output.connections.append(sp::Connection(it.value()));
+      }
+    }
+
+    return output;
+  }
+
+}
+
+RouteOutput rt::routeProblem(const Problem &problem, const RouterSettings &settings,
+    CancelToken *cancel, SolveCollection *solve_col)
+{
+  return runRouter(problem, nullptr, settings, cancel, solve_col);
+}
+
+RouteOutput rt::rerouteProblem(const Problem &problem,
+    const QList<sp::Connection> &prior_conns, const RouterSettings &settings,
+    CancelToken *cancel, SolveCollection *solve_col)
+{
+  return runRouter(problem, &prior_conns, settings, cancel, solve_col);
+}
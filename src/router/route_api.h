@@ -0,0 +1,64 @@
+// @file:     route_api.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Minimal stable API of the pinrouter_core library for routing
+//            problems in-process.
+
+#ifndef _RT_ROUTE_API_H_
+#define _RT_ROUTE_API_H_
+
+#include <QSharedPointer>
+#include "problem.h"
+#include "router.h"
+
+//! Version of the API below, bumped whenever it changes incompatibly.
+#define PINROUTER_CORE_API_VERSION 1
+
+namespace rt {
+
+  //! Statistics of a routing run.
+  struct RouteStats
+  {
+    bool success=false;           //!< Whether all pins were routed.
+    int segments=0;               //!< Routed segments in the final grid.
+    int routed_cells=0;           //!< Routed cells in the final grid.
+    qint64 time_ms=0;             //!< Wall-clock routing time.
+    qint64 searches=0;            //!< Pin pair searches run.
+    qint64 expansions=0;          //!< Cells expanded by the searches.
+    bool budget_exhausted=false;  //!< Whether routing was cut short by the budget.
+    int kept_connections=0;       //!< Prior connections reused (incremental only).
+    int invalidated_connections=0;  //!< Prior connections ripped (incremental only).
+    RouteInstrumentation instrumentation; //!< Counters and timers (empty unless built with PINROUTER_INSTRUMENT).
+  };
+
+  //! Everything produced by routing a problem.
+  struct RouteOutput
+  {
+    RouteStats stats;                   //!< Statistics of the run.
+    QList<sp::Connection> connections;  //!< Routed pin pair connections.
+    QSharedPointer<sp::Grid> grid;      //!< The final routed grid.
+  };
+
+  //! Load a problem from the provided path. Returns false if the file can't
+  //! be read or if the problem is invalid, in which case error (if provided)
+  //! describes why.
+  bool loadProblem(const QString &in_path, Problem *problem, QString *error=nullptr);
+
+  //! Route the provided problem with the provided settings. Step logging is
+  //! disabled unless a solve collection is provided. Routing can be stopped
+  //! early through the optional cancellation token.
+  RouteOutput routeProblem(const Problem &problem, const RouterSettings &settings,
+      CancelToken *cancel=nullptr, SolveCollection *solve_col=nullptr);
+
+  //! Reroute an edited problem incrementally, reusing the still valid 
+  //! connections of a prior solution (see Router::routeIncremental). 
+  //! Otherwise behaves like routeProblem.
+  RouteOutput rerouteProblem(const Problem &problem,
+      const QList<sp::Connection> &prior_conns, const RouterSettings &settings,
+      CancelToken *cancel=nullptr, SolveCollection *solve_col=nullptr);
+
+}
+
+#endif
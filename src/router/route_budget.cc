@@ -0,0 +1,35 @@
+// @file:     route_budget.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the RouteBudget class.
+
+#include "route_budget.h"
+
+using namespace rt;
+
+void RouteBudget::start()
+{
+  timer.start();
+  expansions = 0;
+  searches = 0;
+  check_countdown = check_interval;
+  is_exhausted = false;
+  exhausted();
+}
+
+bool RouteBudget::exhausted()
+{
+  if (is_exhausted) {
+    return true;
+  }
+  if (token != nullptr && token->isCancelled()) {
+    is_exhausted = true;
+  } else if (expansion_limit >= 0 && expansions >= expansion_limit) {
+    is_exhausted = true;
+  } else if (time_limit_ms >= 0 && timer.isValid() && timer.elapsed() >= time_limit_ms) {
+    is_exhausted = true;
+  }
+  return is_exhausted;
+}
@@ -0,0 +1,113 @@
+// @file:     route_budget.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Cancellation token and time/expansion budgets for routing runs.
+
+#ifndef _RT_ROUTE_BUDGET_H_
+#define _RT_ROUTE_BUDGET_H_
+
+#include <QElapsedTimer>
+#include <atomic>
+
+namespace rt {
+
+  //! A cancellation flag that can be raised from any thread (e.g. the GUI's
+  //! soft halt button) and polled by the router.
+  class CancelToken
+  {
+  public:
+    //! Constructor, the token starts out not cancelled.
+    CancelToken() : cancelled(false) {};
+
+    //! Request cancellation.
+    void cancel() {cancelled.store(true, std::memory_order_relaxed);}
+
+    //! Clear any previous cancellation request.
+    void reset() {cancelled.store(false, std::memory_order_relaxed);}
+
+    //! Return whether cancellation has been requested.
+    bool isCancelled() const {return cancelled.load(std::memory_order_relaxed);}
+
+  private:
+
+    std::atomic<bool> cancelled;  //!< Whether cancellation has been requested.
+  };
+
+  //! Keep track of the resources consumed by a routing run and report when
+  //! they have been exhausted. The budget is considered exhausted once the
+  //! wall-clock deadline passes, the expansion limit is reached or the
+  //! attached CancelToken is cancelled. Once exhausted, it stays exhausted
+  //! until start() is called again.
+  class RouteBudget
+  {
+  public:
+
+    //! Constructor taking the time limit in ms and the maximum number of cell
+    //! expansions. Negative limits are treated as unlimited.
+    RouteBudget(qint64 time_limit_ms=-1, qint64 expansion_limit=-1)
+      : time_limit_ms(time_limit_ms), expansion_limit(expansion_limit) {};
+
+    //! Set the cancellation token to observe (nullptr to observe none).
+    void setCancelToken(CancelToken *t_token) {token = t_token;}
+
+    //! Restart the clock and reset the consumption counters.
+    void start();
+
+    //! Record the given number of cell expansions and return whether the
+    //! budget has been exhausted. The clock and cancellation token are only
+    //! polled every check_interval expansions to keep this cheap enough for
+    //! the inner loops of the routing algorithms.
+    bool expand(int count=1)
+    {
+      expansions += count;
+      if (is_exhausted) {
+        return true;
+      }
+      if (expansion_limit >= 0 && expansions >= expansion_limit) {
+        is_exhausted = true;
+        return true;
+      }
+      check_countdown -= count;
+      if (check_countdown > 0) {
+        return false;
+      }
+      check_countdown = check_interval;
+      return exhausted();
+    }
+
+    //! Poll the deadline, expansion limit and cancellation token. Return
+    //! whether the budget has been exhausted.
+    bool exhausted();
+
+    //! Return the time elapsed since start() in ms.
+    qint64 elapsedMs() const {return timer.isValid() ? timer.elapsed() : 0;}
+
+    //! Return the number of expansions recorded since start().
+    qint64 expansionCount() const {return expansions;}
+
+    //! Record the start of a search. Searches aren't limited, they are only
+    //! counted for reporting.
+    void countSearch() {searches++;}
+
+    //! Return the number of searches recorded since start().
+    qint64 searchCount() const {return searches;}
+
+  private:
+
+    // Private variables
+    static const int check_interval=256;  //!< Expansions between clock polls.
+    qint64 time_limit_ms=-1;              //!< Wall-clock limit, -1 for unlimited.
+    qint64 expansion_limit=-1;            //!< Expansion limit, -1 for unlimited.
+    CancelToken *token=nullptr;           //!< Token for external cancellation.
+    QElapsedTimer timer;                  //!< Clock started by start().
+    qint64 expansions=0;                  //!< Expansions since start().
+    qint64 searches=0;                    //!< Searches since start().
+    int check_countdown=check_interval;   //!< Expansions until the next poll.
+    bool is_exhausted=false;              //!< Sticky exhaustion flag.
+  };
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include <QFile>
 #include <QDir>
 #include <QQueue>
+#include <QHash>
 #include <QDebug>
 #include "router.h"
 
@@ -15,17 +16,22 @@ using namespace rt;
 
 // Constructor
 Router::Router(const Problem &problem, RouterSettings settings)
-  : problem(problem), settings(settings)
+  : problem(problem), settings(settings),
+    run_budget(settings.time_budget_ms, settings.expansion_budget)
 {
   records = new RoutingRecords(settings.log_level, settings.gui_update_level);
+  records->setAsyncRecording(settings.async_step_recording);
+}
+
+Router::~Router()
+{
+  delete records;
 }
 
 bool Router::routeSuite(QList<sp::PinSet> pin_sets, sp::Grid *cell_grid,
-    bool *soft_halt, SolveCollection *solve_col)
+    CancelToken *soft_halt, SolveCollection *solve_col)
 {
-  // prepare record keeping
-  records->setSolveCollection(solve_col);
-  records->newSolveSteps();
+  startRun(soft_halt, solve_col, cell_grid);
   
   // prepare variables before routing
   RoutingAlg *alg;                // algorithm to use
@@ -33,20 +39,193 @@ bool Router::routeSuite(QList<sp::PinSet> pin_sets, sp::Grid *cell_grid,
   QMultiMap<int, sp::PinPair> map_pin_sets; // effectively sort pairs of pins by distance
   routePrep(pin_sets, map_pin_sets, unrouted_pins, &alg);
 
-  // make copies of variables that need to be reset after full routing attempts
-  sp::Grid *cell_grid_cp = new sp::Grid(cell_grid);
-  QMultiMap<int, sp::PinPair> map_pin_sets_cp = map_pin_sets;
+  bool all_done = routePairs(map_pin_sets, unrouted_pins, alg, cell_grid);
+  delete alg;
+  finishRun();
+  return all_done;
+}
 
+bool Router::routeIncremental(QList<sp::PinSet> pin_sets, sp::Grid *cell_grid,
+    const QList<sp::Connection> &prior_conns, CancelToken *soft_halt,
+    SolveCollection *solve_col, IncrementalSummary *summary)
+{
+  startRun(soft_halt, solve_col, cell_grid);
+
+  RoutingAlg *alg;
+  QSet<sp::Coord> unrouted_pins;
+  QMultiMap<int, sp::PinPair> all_pin_pairs;
+  routePrep(pin_sets, all_pin_pairs, unrouted_pins, &alg);
+
+  // seed the prior connections that are still valid in the edited problem
+  IncrementalSummary local_summary;
+  if (summary == nullptr) {
+    summary = &local_summary;
+  }
+  *summary = IncrementalSummary();
+  QHash<sp::Coord, sp::Coord> component;  // union-find parents of pins
+  auto findComponent = [&component](sp::Coord pin) -> sp::Coord
+  {
+    while (component.value(pin, pin) != pin) {
+      pin = component.value(pin);
+    }
+    return pin;
+  };
+  for (const sp::Connection &conn : prior_conns) {
+    int pin_set_id = conn.pinSetId();
+    sp::PinPair pin_pair = conn.pinPair();
+    bool valid = pin_set_id >= 0 && pin_set_id < pin_sets.size()
+      && pin_sets[pin_set_id].contains(pin_pair.first)
+      && pin_sets[pin_set_id].contains(pin_pair.second);
+    for (auto it=conn.begin(); valid && it!=conn.end(); ++it) {
+      // overlaps with new obstacles or other nets' pins or routes invalidate
+      valid = cell_grid->isWithinBounds(*it)
+        && (cell_grid->cellAt(*it)->getType() == sp::BlankCell
+            || cell_grid->cellAt(*it)->pinSetId() == pin_set_id);
+    }
+    if (!valid) {
+      summary->invalidated_connections++;
+      continue;
+    }
+    createConnection(pin_pair, conn.routedCells(), pin_set_id, cell_grid);
+    sp::Coord root_a = findComponent(pin_pair.first);
+    sp::Coord root_b = findComponent(pin_pair.second);
+    if (root_a != root_b) {
+      component[root_a] = root_b;
+    }
+    summary->kept_connections++;
+  }
+  records->logCellGrid(cell_grid, LogCoarseIntermediate, VisualizeCoarseIntermediate);
+
+  // only route pairs that the kept connections don't already join
+  QMultiMap<int, sp::PinPair> map_pin_sets;
+  for (auto it=all_pin_pairs.constBegin(); it!=all_pin_pairs.constEnd(); ++it) {
+    if (findComponent(it.value().first) != findComponent(it.value().second)) {
+      map_pin_sets.insert(it.key(), it.value());
+    }
+  }
+  summary->pairs_to_route = map_pin_sets.size();
+  qDebug() << tr("Incremental routing kept %1 connections, invalidated %2, "
+      "%3 pin pairs to route.").arg(summary->kept_connections)
+    .arg(summary->invalidated_connections).arg(summary->pairs_to_route);
+
+  bool all_done;
+  if (map_pin_sets.isEmpty()) {
+    all_done = cell_grid->allPinsRouted();
+    records->logCellGrid(cell_grid, LogResultsOnly, VisualizeResultsOnly);
+  } else {
+    all_done = routePairs(map_pin_sets, unrouted_pins, alg, cell_grid);
+  }
+  delete alg;
+  finishRun();
+  return all_done;
+}
+
+void Router::startRun(CancelToken *soft_halt, SolveCollection *solve_col,
+    sp::Grid *cell_grid)
+{
+  // start the clock on the routing budget
+  run_budget.setCancelToken(soft_halt);
+  run_budget.start();
+  records->instrumentation()->reset();
+
+  // prepare record keeping
+  if (solve_col != nullptr) {
+    solve_col->setMemoryBudget((qint64)settings.step_memory_budget_mb << 20);
+  }
+  records->setSolveCollection(solve_col);
+  step_log.reset();
+  if (!settings.step_log_path.isEmpty()) {
+    step_log.reset(new StepLogWriter());
+    if (!step_log->open(settings.step_log_path, cell_grid->dimensions(),
+          problem.pinSets())) {
+      qWarning() << tr("Unable to write the step log to %1.")
+        .arg(settings.step_log_path);
+      step_log.reset();
+    }
+  }
+  records->setStepLog(step_log.data());
+  trace.reset();
+  if (!settings.trace_path.isEmpty()) {
+    trace.reset(new TraceWriter());
+    if (!trace->open(settings.trace_path)) {
+      qWarning() << tr("Unable to write the trace to %1.")
+        .arg(settings.trace_path);
+      trace.reset();
+    } else {
+      trace->begin("run", "router");
+    }
+  }
+  records->startRecording(cell_grid);
+}
+
+void Router::finishRun()
+{
+  records->finishRecording();
+  records->setStepLog(nullptr);
+  if (step_log) {
+    step_log->finish();
+    step_log.reset();
+  }
+  if (trace) {
+    trace->end("run", "router");
+    if (!trace->finish()) {
+      qWarning() << tr("Unable to write the trace to %1.")
+        .arg(settings.trace_path);
+    }
+    trace.reset();
+  }
+}
+
+bool Router::routePairs(QMultiMap<int,sp::PinPair> map_pin_sets,
+    const QSet<sp::Coord> &unrouted_pins, RoutingAlg *alg, sp::Grid *cell_grid)
+{
   // runtime settings and flags
   bool all_done = false;
   int attempts_left = (settings.net_reordering) ? settings.max_rerun_count : 1;
+
+  // make copies of variables that need to be reset after full routing
+  // attempts, the grid is only backed up if there can be another attempt
+  QSharedPointer<sp::Grid> cell_grid_cp;
+  if (attempts_left > 1) {
+    cell_grid_cp.reset(new sp::Grid(cell_grid));
+    RT_COUNT(records->instrumentation(), GridCopies);
+  }
+  QMultiMap<int, sp::PinPair> map_pin_sets_cp = map_pin_sets;
+  int attempt_index = 0;
+  bool attempt_traced = !trace.isNull();
+  if (attempt_traced) {
+    trace->begin("attempt", "router", {{"index", attempt_index}});
+  }
   QQueue<sp::PinPair> priority_routes;
   QSet<sp::Coord> failed_pins;
   QList<sp::PinPair> difficult_pairs;
   QMap<sp::PinPair, int> difficult_pair_failure_count;
 
+  // keep the best grid seen so far in case routing can't be completed,
+  // return whether the grid was copied
+  sp::Grid *best_grid = nullptr;
+  int best_segments = -1;
+  int best_routed_cells = -1;
+  auto keepIfBest = [&best_grid, &best_segments, &best_routed_cells](sp::Grid *grid) -> bool
+  {
+    int segments = grid->countSegments();
+    int routed_cells = grid->countCells({sp::RoutedCell});
+    if (best_grid == nullptr || segments > best_segments
+        || (segments == best_segments && routed_cells < best_routed_cells)) {
+      if (best_grid == nullptr) {
+        best_grid = new sp::Grid(grid);
+      } else {
+        best_grid->copyState(grid);
+      }
+      best_segments = segments;
+      best_routed_cells = routed_cells;
+      return true;
+    }
+    return false;
+  };
+
   // high level routing loop
-  while (!(*soft_halt) && !all_done && attempts_left > 0 && !map_pin_sets.isEmpty()) {
+  while (!run_budget.exhausted() && !all_done && attempts_left > 0 && !map_pin_sets.isEmpty()) {
     // decide the source & sink to route
     sp::Coord source_coord, sink_coord;
     sp::PinPair pin_pair;
@@ -97,17 +276,44 @@ bool Router::routeSuite(QList<sp::PinSet> pin_sets, sp::Grid *cell_grid,
       for (auto difficult_pair : difficult_pairs) {
         priority_routes.enqueue(difficult_pair);
       }
-      // restore backups and clear flags
-      cell_grid->copyState(cell_grid_cp);
+      // remember this attempt if it's the best so far, then restore backups 
+      // and clear flags if there is another attempt
+      records->instrumentation()->beginNet(-1);
+      attempts_left--;
+      {
+        TraceScope restore_scope(trace.data(), "restore", "router");
+        if (keepIfBest(cell_grid)) {
+          RT_COUNT(records->instrumentation(), GridCopies);
+        }
+        if (attempts_left > 0) {
+          cell_grid->copyState(cell_grid_cp.data());
+        }
+      }
+      if (attempts_left > 0) {
+        RT_COUNT(records->instrumentation(), GridCopies);
+        records->gridReplaced(cell_grid_cp);
+      }
       map_pin_sets = map_pin_sets_cp;
       failed_pins.clear();
-      attempts_left--;
       qDebug() << tr("****No solution found, attempts left: %1****").arg(attempts_left);
+      if (attempt_traced) {
+        trace->end("attempt", "router");
+        attempt_traced = false;
+      }
       if (attempts_left > 0) {
+        RT_COUNT(records->instrumentation(), GlobalReruns);
+        records->instrumentation()->beginAttempt();
         records->newSolveSteps();
+        if (trace) {
+          trace->begin("attempt", "router", {{"index", ++attempt_index}});
+          attempt_traced = true;
+        }
       }
     }
   }
+  if (attempt_traced) {
+    trace->end("attempt", "router");
+  }
 
   // if main loop thinks it's done, perform sanity checks
   if (all_done) {
@@ -119,10 +325,31 @@ bool Router::routeSuite(QList<sp::PinSet> pin_sets, sp::Grid *cell_grid,
     } else {
       qDebug() << tr("ALL ROUTES COMPLETED SUCCESSFULLY.");
     }
+  } else {
+    // leave the best partial result in the provided grid
+    if (run_budget.exhausted()) {
+      qDebug() << tr("Routing budget exhausted after %1 ms and %2 expansions.")
+        .arg(run_budget.elapsedMs()).arg(run_budget.expansionCount());
+    }
+    records->instrumentation()->beginNet(-1);
+    bool restored = false;
+    {
+      TraceScope restore_scope(trace.data(), "restore", "router");
+      if (keepIfBest(cell_grid)) {
+        // the final attempt is the best one and stays in place
+        RT_COUNT(records->instrumentation(), GridCopies);
+      } else {
+        cell_grid->copyState(best_grid);
+        RT_COUNT(records->instrumentation(), GridCopies);
+        restored = true;
+      }
+    }
+    if (restored) {
+      records->gridReplaced(cell_grid);
+    }
   }
 
-  delete cell_grid_cp;
-  delete alg;
+  delete best_grid;
 
   return all_done;
 }
@@ -131,15 +358,16 @@ sp::Connection *Router::createConnection(const sp::PinPair &pin_pair,
     const QList<sp::Coord> &route, int pin_set_id, sp::Grid *grid,
     RoutingRecords *record_keeper)
 {
-  sp::Connection *conn = new sp::Connection(pin_pair, route, pin_set_id);
+  sp::Connection *conn = grid->newConnection(pin_pair, route, pin_set_id);
   for (const sp::Coord &coord : route) {
     // add this to connectivity track map
     grid->connMap()->insert(coord, conn);
     // update cell properties
     sp::Cell *cell = grid->cellAt(coord);
     if (cell->getType() == sp::BlankCell) {
-      cell->setType(sp::RoutedCell);
-      cell->setPinSetId(pin_set_id);
+      grid->setCellType(coord, sp::RoutedCell, pin_set_id);
+      grid->markChanged(coord);
+      records->cellChanged(coord, sp::RoutedCell, pin_set_id);
       if (record_keeper != nullptr) {
         record_keeper->logCellGrid(grid, LogAllIntermediate, VisualizeAllIntermediate);
       }
@@ -165,8 +393,7 @@ QSet<sp::Connection*> Router::existingConnections(const QList<sp::Coord> &coords
 void Router::ripConnection(sp::Connection *conn, sp::Grid *grid,
     RoutingRecords *record_keeper)
 {
-  auto routed_cells = conn->routedCells();
-  for (sp::Coord &coord : routed_cells) {
+  for (const sp::Coord &coord : *conn) {
     // remove the specific entry in the connectivity map
     int removed = grid->connMap()->remove(coord, conn); 
     if (!removed) {
@@ -174,8 +401,9 @@ void Router::ripConnection(sp::Connection *conn, sp::Grid *grid,
     }
     if (!grid->connMap()->contains(coord) && grid->cellAt(coord)->getType() != sp::PinCell) {
       // if the cell doesn't have other connections running through, set to blank
-      grid->cellAt(coord)->setType(sp::BlankCell);
-      grid->cellAt(coord)->setPinSetId(-1);
+      grid->setCellType(coord, sp::BlankCell);
+      grid->markChanged(coord);
+      records->cellChanged(coord, sp::BlankCell, -1);
       if (record_keeper != nullptr) {
         record_keeper->logCellGrid(grid, LogAllIntermediate, VisualizeAllIntermediate);
       }
@@ -197,6 +425,9 @@ void Router::routePrep(const QList<sp::PinSet> &pin_sets,
       (*alg) = new AStarAlg();
       break;
   }
+  (*alg)->setBudget(&run_budget);
+  (*alg)->setInstrumentation(records->instrumentation());
+  (*alg)->setTrace(trace.data());
 
   // initialize a map that sorts pin sets from nearest to farthest as well as
   // a set that stores unrouted pins
@@ -224,11 +455,18 @@ bool Router::routePinPair(RoutingAlg *alg, const sp::PinPair &pin_pair,
   QList<sp::Connection*> rip_cand;
   QList<sp::Connection*> rip_blacklist;
 
+  // attribute counters to the net being routed
+  records->instrumentation()->beginNet((*grid)(source_coord)->pinSetId());
+  TraceScope pair_scope(trace.data(), "routePinPair", "router");
+  pair_scope.arg("net", (*grid)(source_coord)->pinSetId());
+
   // end early if a connection already exists
   QList<sp::Coord> route;
+  RT_COUNT(records->instrumentation(), RouteExistsProbes);
   if (grid->routeExistsBetweenPins(source_coord, sink_coord, &route)) {
     createConnection(pin_pair, route, (*grid)(source_coord)->pinSetId(),
         grid, records);
+    pair_scope.arg("success", true);
     return true;
   }
 
@@ -245,13 +483,17 @@ bool Router::routePinPair(RoutingAlg *alg, const sp::PinPair &pin_pair,
         grid, records);
   } else if (settings.rip_and_reroute) {
     // attempt rip and reroute
+    RT_TIME_SCOPE(records->instrumentation(), RipRerouteTimer);
     int rip_attempts_left = settings.rip_and_rerout_count;
 
     // save the grid before doing anything
     grid->clearWorkingValues();
-    sp::Grid grid_pre_rip(grid);
+    QSharedPointer<sp::Grid> grid_pre_rip(new sp::Grid(grid));
+    RT_COUNT(records->instrumentation(), GridCopies);
 
     while (rip_attempts_left > 0 && !result.route_coords.isEmpty()) {
+      RT_COUNT(records->instrumentation(), RipAttempts);
+      TraceScope rip_scope(trace.data(), "rip", "router");
       // get the connections that need to be ripped to make the route
       QList<sp::PinPair> pairs_to_reroute;
       QSet<sp::Connection*> conns = existingConnections(result.route_coords,
@@ -261,7 +503,7 @@ bool Router::routePinPair(RoutingAlg *alg, const sp::PinPair &pin_pair,
       for (sp::Connection *conn : conns) {
         pairs_to_reroute.append(conn->pinPair());
         ripConnection(conn, grid, records);
-        delete conn;
+        grid->releaseConnection(conn);
         records->logCellGrid(grid, LogCoarseIntermediate, VisualizeCoarseIntermediate);
       }
 
@@ -273,6 +515,9 @@ bool Router::routePinPair(RoutingAlg *alg, const sp::PinPair &pin_pair,
       bool all_rerouted = true;
       for (const sp::PinPair &reroute_pair : pairs_to_reroute) {
         RouteResult reroute_result;
+        RT_COUNT(records->instrumentation(), Reroutes);
+        TraceScope reroute_scope(trace.data(), "reroute", "router");
+        reroute_scope.arg("net", (*grid)(reroute_pair.first)->pinSetId());
         reroute_result = alg->findRoute(reroute_pair.first, reroute_pair.second,
             grid, settings.routed_cells_lower_cost, false, false,
             &rip_blacklist, records);
@@ -297,7 +542,12 @@ bool Router::routePinPair(RoutingAlg *alg, const sp::PinPair &pin_pair,
       // then these routes won't be reused
       if (!all_rerouted) {
         qDebug() << "Reverting to state prior to rerouting";
-        grid->copyState(&grid_pre_rip);
+        {
+          TraceScope restore_scope(trace.data(), "restore", "router");
+          grid->copyState(grid_pre_rip.data());
+        }
+        RT_COUNT(records->instrumentation(), GridCopies);
+        records->gridReplaced(grid_pre_rip);
         records->logCellGrid(grid, LogCoarseIntermediate, VisualizeCoarseIntermediate);
         rip_blacklist = QList<sp::Connection*>::fromSet(existingConnections(
               all_routed_coords.toList(), grid, (*grid)(source_coord)->pinSetId()));
@@ -317,6 +567,6 @@ bool Router::routePinPair(RoutingAlg *alg, const sp::PinPair &pin_pair,
   grid->clearWorkingValues();
   records->logCellGrid(grid, LogResultsOnly, VisualizeResultsOnly);
 
-
+  pair_scope.arg("success", success);
   return success;
 }
@@ -9,8 +9,12 @@
 #define _RT_ROUTER_H_
 
 #include <QObject>
+#include <QScopedPointer>
 #include "problem.h"
 #include "routing_records.h"
+#include "step_log.h"
+#include "trace_writer.h"
+#include "route_budget.h"
 #include "algs/alg.h"
 #include "algs/a_star.h"
 #include "algs/lee_moore.h"
@@ -30,9 +34,26 @@ namespace rt {
     bool rip_and_reroute=true;          //!< enable rip and reroute
     int rip_and_rerout_count=2;         //!< maximum rip and reroute attempts for a route
 
+    // budget settings
+    qint64 time_budget_ms=-1;           //!< wall-clock limit for routeSuite in ms (-1 for unlimited)
+    qint64 expansion_budget=-1;         //!< maximum cells expanded by searches (-1 for unlimited)
+
     // verbosity settings
     LogVerbosity log_level=LogCoarseIntermediate;
     GuiUpdateVerbosity gui_update_level=VisualizeCoarseIntermediate;
+    bool async_step_recording=true;     //!< record logged steps on a background thread
+    QString step_log_path;              //!< stream logged steps to this file instead of memory (none if empty)
+    int step_memory_budget_mb=512;      //!< memory for logged steps in MB, older steps are thinned out beyond it (0 for unlimited)
+    QString trace_path;                 //!< write a Chrome trace-event timeline of router phases to this file (none if empty)
+  };
+
+  //! Summary of how much of a prior solution could be reused by
+  //! Router::routeIncremental.
+  struct IncrementalSummary
+  {
+    int kept_connections=0;         //!< Prior connections seeded as they were.
+    int invalidated_connections=0;  //!< Prior connections that had to be ripped.
+    int pairs_to_route=0;           //!< Pin pairs queued for routing.
   };
 
   //! A router attempts to create connections between all pins in a provided 
@@ -47,14 +68,33 @@ namespace rt {
     Router(const Problem &problem, RouterSettings settings);
 
     //! Destructor.
-    ~Router() {};
+    ~Router();
 
     //! Return a pointer to the current record keeping helper class.
     RoutingRecords *recordKeeper() {return records;}
 
-    //! Attempt to route with rip and reroute.
+    //! Return a pointer to the budget consumed by the current or last run.
+    RouteBudget *budget() {return &run_budget;}
+
+    //! Attempt to route with rip and reroute. Routing stops early when the
+    //! soft_halt token is cancelled or the time/expansion budget in the router
+    //! settings runs out. If not all pins could be routed, cell_grid is left
+    //! with the best grid found so far (most segments, then fewest routed 
+    //! cells).
     bool routeSuite(QList<sp::PinSet> pin_sets, sp::Grid *cell_grid, 
-        bool *soft_halt, SolveCollection *solve_col);
+        CancelToken *soft_halt, SolveCollection *solve_col);
+
+    //! Route incrementally on top of the connections of a prior solution, e.g.
+    //! after a few obstacles or pins have been edited. Prior connections are
+    //! kept if their pins are still pins of the same net and all of their 
+    //! cells are free or belong to that net in cell_grid, which should hold
+    //! the unrouted (edited) problem. The rest are invalidated and only pin
+    //! pairs that aren't connected by the kept connections are routed, with
+    //! the same budget, rip and reroute and best-so-far handling as 
+    //! routeSuite.
+    bool routeIncremental(QList<sp::PinSet> pin_sets, sp::Grid *cell_grid,
+        const QList<sp::Connection> &prior_conns, CancelToken *soft_halt,
+        SolveCollection *solve_col, IncrementalSummary *summary=nullptr);
 
     //! Create a routed connection with the provided list of coordinates and 
     //! settings.
@@ -82,6 +122,19 @@ namespace rt {
         QMultiMap<int,sp::PinPair> &map_pin_sets, QSet<sp::Coord> &unrouted_pins,
         RoutingAlg **alg);
 
+    //! Start the routing budget and record keeping of a new run.
+    void startRun(CancelToken *soft_halt, SolveCollection *solve_col,
+        sp::Grid *cell_grid);
+
+    //! Wait for step recording to complete and close the step log and trace,
+    //! if any.
+    void finishRun();
+
+    //! Main routing loop shared by routeSuite and routeIncremental, routing
+    //! the provided pin pairs (keyed by distance) on top of cell_grid.
+    bool routePairs(QMultiMap<int,sp::PinPair> map_pin_sets,
+        const QSet<sp::Coord> &unrouted_pins, RoutingAlg *alg, sp::Grid *cell_grid);
+
     //! Go through a routine that attempts to route the source to the sink.
     //! If the route is only available by rip and reroute and if it is allowed,
     //! attempt rip and reroute. Returns whether it is successful or not.
@@ -91,6 +144,9 @@ namespace rt {
     RoutingRecords *records;  //!< class that keeps record of routing progress
     Problem problem;          //!< the problem to be routed
     RouterSettings settings;  //!< router settings
+    RouteBudget run_budget;   //!< budget for the current routing run
+    QScopedPointer<StepLogWriter> step_log; //!< on-disk step log of the current run
+    QScopedPointer<TraceWriter> trace;      //!< trace-event timeline of the current run
 
   };
 
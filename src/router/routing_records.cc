@@ -6,17 +6,179 @@
 // @desc:     Implementation of classes relevant to storing routing records.
 
 #include "routing_records.h"
+#include "step_recorder.h"
+#include "step_log.h"
 
 using namespace rt;
 
+// StepMetrics struct implementations
+
+StepMetrics StepMetrics::measure(sp::Grid *grid)
+{
+  StepMetrics metrics;
+  metrics.segments = grid->countSegments();
+  metrics.routed_cells = grid->cellCount(sp::RoutedCell);
+  metrics.wirelength = grid->wirelength();
+  return metrics;
+}
+
+// SolveSteps class implementations
+
+qint64 SolveSteps::append(const QSharedPointer<sp::Grid> &grid,
+    const StepMetrics &metrics)
+{
+  SolveStep step;
+  step.index = logged_count++;
+  step.grid = grid;
+  step.bytes = grid->memoryFootprint();
+  step.metrics = metrics;
+  steps.append(step);
+  bytes_used += step.bytes;
+  return step.bytes;
+}
+
+qint64 SolveSteps::thinKeyframes(int ring_size)
+{
+  qint64 freed = 0;
+  int older_count = steps.size() - ring_size;
+  // walk backwards so that removals don't shift the steps still to visit
+  for (int i=older_count-1; i>0; i--) {
+    if (i % 2 == 1) {
+      freed += steps[i].bytes;
+      steps.removeAt(i);
+    }
+  }
+  bytes_used -= freed;
+  return freed;
+}
+
+qint64 SolveSteps::dropOldest()
+{
+  if (steps.size() < 2) {
+    return 0;
+  }
+  qint64 freed = steps.takeFirst().bytes;
+  bytes_used -= freed;
+  return freed;
+}
+
+// SolveCollection class implementations
+
+void SolveCollection::appendStep(SolveSteps *steps,
+    const QSharedPointer<sp::Grid> &grid)
+{
+  // measured once here so that scrubbing through steps doesn't have to
+  appendStep(steps, grid, StepMetrics::measure(grid.data()));
+}
+
+void SolveCollection::appendStep(SolveSteps *steps,
+    const QSharedPointer<sp::Grid> &grid, const StepMetrics &metrics)
+{
+  bytes_used += steps->append(grid, metrics);
+  while (budget > 0 && bytes_used > budget && evictSteps(steps)) {}
+}
+
+bool SolveCollection::evictSteps(SolveSteps *protect)
+{
+  // thin out keyframes first, leaving the recent ring of every attempt alone
+  for (SolveSteps &steps : solve_steps) {
+    qint64 freed = steps.thinKeyframes(ring_size);
+    if (freed > 0) {
+      bytes_used -= freed;
+      return true;
+    }
+  }
+  // then give up older attempts' steps except for their final results, and
+  // finally the oldest steps of the attempt being recorded
+  for (SolveSteps &steps : solve_steps) {
+    if (&steps == protect) {
+      continue;
+    }
+    qint64 freed = steps.dropOldest();
+    if (freed > 0) {
+      bytes_used -= freed;
+      return true;
+    }
+  }
+  qint64 freed = protect->dropOldest();
+  bytes_used -= freed;
+  return freed > 0;
+}
+
+// RoutingRecords class implementations
+
+RoutingRecords::~RoutingRecords()
+{
+  finishRecording();
+}
+
+void RoutingRecords::startRecording(sp::Grid *grid)
+{
+  finishRecording();
+  if (async_recording && (solve_col != nullptr || step_log != nullptr)
+      && log_verbosity != LogNone && grid != nullptr) {
+    recorder = new StepRecorder(solve_col, step_log);
+    recorder->start();
+    gridReplaced(grid);
+  }
+  newSolveSteps();
+}
+
+void RoutingRecords::finishRecording()
+{
+  if (recorder != nullptr) {
+    recorder->finish();
+    delete recorder;
+    recorder = nullptr;
+  }
+}
+
 SolveSteps *RoutingRecords::newSolveSteps()
 {
-  curr_solve_steps = solve_col->newSolveSteps();
+  if (recorder != nullptr) {
+    StepRecord record;
+    record.kind = StepRecord::NewAttempt;
+    recorder->post(record);
+    curr_solve_steps = nullptr;
+  } else if (step_log != nullptr) {
+    step_log->beginAttempt();
+    curr_solve_steps = nullptr;
+  } else {
+    curr_solve_steps = (solve_col != nullptr) ? solve_col->newSolveSteps() : nullptr;
+  }
   return curr_solve_steps;
 }
 
-void RoutingRecords::logCellGrid(sp::Grid *cell_grid, LogVerbosity detail,
-    GuiUpdateVerbosity gui_detail)
+void RoutingRecords::gridReplaced(const QSharedPointer<sp::Grid> &snapshot)
+{
+  if (recorder != nullptr) {
+    StepRecord record;
+    record.kind = StepRecord::Reset;
+    record.grid = snapshot;
+    recorder->post(record);
+  }
+}
+
+void RoutingRecords::gridReplaced(sp::Grid *grid)
+{
+  if (recorder != nullptr) {
+    gridReplaced(QSharedPointer<sp::Grid>(new sp::Grid(grid)));
+  }
+}
+
+void RoutingRecords::postCellChange(const sp::Coord &coord, sp::CellType type,
+    int pin_set_id)
+{
+  StepRecord record;
+  record.kind = StepRecord::CellChange;
+  record.coord = coord;
+  record.type = type;
+  record.pin_set_id = pin_set_id;
+  recorder->post(record);
+}
+
+void RoutingRecords::recordCellGrid(sp::Grid *cell_grid, LogVerbosity detail,
+    GuiUpdateVerbosity gui_detail, bool working_values)
 {
   if (gui_detail >= gui_verbosity) {
     emit routerStep(cell_grid);
@@ -24,8 +186,32 @@ void RoutingRecords::logCellGrid(sp::Grid *cell_grid, LogVerbosity detail,
   if (detail < log_verbosity) {
     return;
   }
+  if (recorder != nullptr && cell_grid != nullptr) {
+    // the recorder already follows the cells, only copy if it can't, i.e. if
+    // working values have to be kept (the step log drops them anyway). The
+    // replica has no connections, so the metrics are measured here.
+    bool snapshot = working_values && step_log == nullptr;
+    StepRecord record;
+    record.kind = snapshot ? StepRecord::Snapshot : StepRecord::Step;
+    if (step_log == nullptr) {
+      record.metrics = StepMetrics::measure(cell_grid);
+    }
+    if (snapshot) {
+      record.grid = QSharedPointer<sp::Grid>(new sp::Grid(cell_grid));
+    }
+    recorder->post(record);
+    return;
+  }
+  if (step_log != nullptr && cell_grid != nullptr) {
+    // the log only stores what changed, no need to copy the grid
+    step_log->writeStep(cell_grid);
+    return;
+  }
   // log the provided cell grid if both provided pointers are not nullptrs.
   if (cell_grid != nullptr && curr_solve_steps != nullptr) {
-    curr_solve_steps->step_grids.append(new sp::Grid(cell_grid));
+    // measured on the routed grid, which keeps its statistics current
+    solve_col->appendStep(curr_solve_steps,
+        QSharedPointer<sp::Grid>(new sp::Grid(cell_grid)),
+        StepMetrics::measure(cell_grid));
   }
 };
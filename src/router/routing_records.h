@@ -9,29 +9,104 @@
 #define _RT_ROUTING_RECORDS_H_
 
 #include <QObject>
+#include <QSharedPointer>
 #include "spatial.h"
+#include "instrumentation.h"
 
 namespace rt {
 
-  //! Store information related to a solve attempt within a collection.
-  struct SolveSteps
+  class StepRecorder;
+  struct StepRecord;
+  class StepLogWriter;
+
+  //! Quality metrics of a routed grid.
+  struct StepMetrics
   {
-    ~SolveSteps() {step_grids.clear();}
+    //! Measure the provided grid from its running statistics.
+    static StepMetrics measure(sp::Grid *grid);
+
+    int segments=0;         //!< Connected pin pairs, see Grid::countSegments().
+    int routed_cells=0;     //!< Cells of type RoutedCell.
+    qint64 wirelength=0;    //!< Wire length of all nets, see Grid::wirelength().
+  };
+
+  //! A recorded step grid along with its position in the solve attempt.
+  struct SolveStep
+  {
+    int index=-1;                   //!< Step index within the solve attempt.
+    QSharedPointer<sp::Grid> grid;  //!< Grid at this step.
+    qint64 bytes=0;                 //!< Estimated memory used by the grid.
+    StepMetrics metrics;            //!< Metrics measured when recorded.
+  };
+
+  //! Store information related to a solve attempt within a collection. Steps
+  //! are owned through shared pointers, so copies of SolveSteps share grids
+  //! and nothing leaks when steps are dropped. Once a SolveCollection runs
+  //! out of memory budget, older steps are thinned out and only every so
+  //! often a keyframe is kept, so step indices may have gaps.
+  class SolveSteps
+  {
+  public:
+
+    //! Return the number of recorded steps.
+    int size() const {return steps.size();}
+
+    //! Return whether no steps have been recorded.
+    bool isEmpty() const {return steps.isEmpty();}
 
     //! Convenient index operator to access a step grid.
-    sp::Grid *operator[](int i) {return step_grids.value(i);}
-    QList<sp::Grid*> step_grids;  //!< A list of grids containing every step in the solve attempt
+    sp::Grid *operator[](int i) const {return grid(i).data();}
+
+    //! Return the i-th recorded step grid (null if out of range).
+    QSharedPointer<sp::Grid> grid(int i) const {return steps.value(i).grid;}
+
+    //! Return the last recorded step grid (nullptr if there's none).
+    sp::Grid *last() const {return isEmpty() ? nullptr : steps.last().grid.data();}
+
+    //! Return the metrics of the i-th recorded step, measured once when the
+    //! step was recorded.
+    StepMetrics metrics(int i) const {return steps.value(i).metrics;}
+
+    //! Return the step index of the i-th recorded step within the attempt.
+    int stepIndex(int i) const {return steps.value(i).index;}
+
+    //! Return the number of steps logged during the attempt, including the 
+    //! ones that have been dropped.
+    int loggedCount() const {return logged_count;}
+
+    //! Return the estimated memory used by the recorded steps.
+    qint64 memoryUsed() const {return bytes_used;}
+
+  private:
+
+    //! Append a step grid with its metrics, return its estimated size.
+    qint64 append(const QSharedPointer<sp::Grid> &grid, const StepMetrics &metrics);
+
+    //! Drop every other step older than the most recent ring_size steps, 
+    //! always keeping the first one. Return the memory freed.
+    qint64 thinKeyframes(int ring_size);
+
+    //! Drop the oldest step unless it's the only one. Return the memory freed.
+    qint64 dropOldest();
+
+    QList<SolveStep> steps;   //!< Recorded steps in order.
+    int logged_count=0;       //!< Steps logged, including dropped ones.
+    qint64 bytes_used=0;      //!< Estimated memory used by steps.
+
+    friend class SolveCollection;
   };
 
-  //! Store information on a collection of solve attempts.
-  struct SolveCollection
+  //! Store information on a collection of solve attempts with an optional
+  //! memory budget shared by all of them.
+  class SolveCollection
   {
+  public:
 
     //! Clear the collection
-    void clear() {solve_steps.clear();}
+    void clear() {solve_steps.clear(); bytes_used = 0;}
 
     //! Convenient index operator to access a particular collection of SolveSteps
-    SolveSteps operator[](int i) {return solve_steps.value(i);}
+    SolveSteps operator[](int i) const {return solve_steps.value(i);}
 
     //! Add a new SolveSteps object and return its pointer
     SolveSteps *newSolveSteps()
@@ -39,15 +114,50 @@ namespace rt {
       solve_steps.append(SolveSteps());
       return &solve_steps.back();
     }
+
+    //! Append a step grid to the provided solve steps, which must belong to
+    //! this collection. If that exceeds the memory budget, older steps are
+    //! dropped until the collection fits again.
+    void appendStep(SolveSteps *steps, const QSharedPointer<sp::Grid> &grid);
+
+    //! Overloaded version taking metrics that have already been measured,
+    //! e.g. on the grid that the step grid was copied from.
+    void appendStep(SolveSteps *steps, const QSharedPointer<sp::Grid> &grid,
+        const StepMetrics &metrics);
+
+    //! Set the memory budget in bytes (0 or less for unlimited).
+    void setMemoryBudget(qint64 bytes) {budget = bytes;}
+
+    //! Return the memory budget in bytes (0 or less for unlimited).
+    qint64 memoryBudget() const {return budget;}
+
+    //! Return the estimated memory used by all recorded steps.
+    qint64 memoryUsed() const {return bytes_used;}
+
+    //! Set the number of most recent steps per attempt that are never thinned
+    //! out when the budget is exceeded.
+    void setRingSize(int size) {ring_size = qMax(1, size);}
+
     QList<SolveSteps> solve_steps;  //!< A list of solve steps.
+
+  private:
+
+    //! Drop steps to free memory, oldest attempts first. Return false if
+    //! there is nothing left to drop.
+    bool evictSteps(SolveSteps *protect);
+
+    qint64 budget=0;      //!< Memory budget in bytes (0 or less for unlimited).
+    qint64 bytes_used=0;  //!< Estimated memory used by all steps.
+    int ring_size=64;     //!< Recent steps per attempt kept at full resolution.
   };
 
-  //! Solve step storage detail level
-  enum LogVerbosity{LogAllIntermediate, LogCoarseIntermediate, LogResultsOnly};
+  //! Solve step storage detail level (LogNone disables step logging).
+  enum LogVerbosity{LogAllIntermediate, LogCoarseIntermediate, LogResultsOnly,
+    LogNone};
 
-  //! Real time update verbosity
+  //! Real time update verbosity (VisualizeNone disables real time updates).
   enum GuiUpdateVerbosity{VisualizeAllIntermediate, VisualizeCoarseIntermediate,
-    VisualizeResultsOnly};
+    VisualizeResultsOnly, VisualizeNone};
 
   //! A class that fascilitates the recording keeping of routing steps.
   class RoutingRecords : public QObject
@@ -62,8 +172,8 @@ namespace rt {
         SolveCollection *solve_col=nullptr)
       : log_verbosity(log_vb), gui_verbosity(gui_vb), solve_col(solve_col) {};
 
-    //! Destructor.
-    ~RoutingRecords() {};
+    //! Destructor, finishes recording.
+    ~RoutingRecords();
 
     //! Set the log verbosity.
     void setLogVerbosity(LogVerbosity log_vb) {log_verbosity = log_vb;}
@@ -83,15 +193,69 @@ namespace rt {
     //! Return the current solve collection.
     SolveCollection *setSolveCollection() {return solve_col;}
 
-    //! Create a new set of solve steps in the collection.
+    //! Set a step log that logged steps are streamed to instead of being kept
+    //! in the solve collection (nullptr to stop). The log must stay open 
+    //! until finishRecording() returns.
+    void setStepLog(StepLogWriter *log) {step_log = log;}
+
+    //! Set whether steps are recorded on a background thread. This applies
+    //! from the next startRecording() call.
+    void setAsyncRecording(bool async) {async_recording = async;}
+
+    //! Start recording a routing run on the provided grid and create its 
+    //! first set of solve steps. If asynchronous recording is enabled and 
+    //! there is a collection or step log to log to, a StepRecorder thread is started and
+    //! fed with the changes reported through cellChanged() and gridReplaced()
+    //! from here on, instead of copying the grid on every logged step.
+    void startRecording(sp::Grid *grid);
+
+    //! Wait for the recorder thread (if any) to write all remaining steps to
+    //! the collection. Must be called before the collection is read.
+    void finishRecording();
+
+    //! Return the counters and timers of the current run. They are only
+    //! filled in when built with PINROUTER_INSTRUMENT.
+    RouteInstrumentation *instrumentation() {return &instr;}
+
+    //! Return whether cell changes are being tracked by a recorder thread.
+    bool tracksChanges() const {return recorder != nullptr;}
+
+    //! Create a new set of solve steps in the collection. Returns nullptr if
+    //! there is no collection to log to or if steps are recorded 
+    //! asynchronously, in which case the recorder creates them.
     SolveSteps *newSolveSteps();
 
+    //! Report that a cell of the recorded grid has changed type or pin set.
+    void cellChanged(const sp::Coord &coord, sp::CellType type, int pin_set_id)
+    {
+      if (recorder != nullptr) {
+        postCellChange(coord, type, pin_set_id);
+      }
+    }
+
+    //! Report that the recorded grid has been replaced with the state of the
+    //! provided snapshot, which must not be modified anymore.
+    void gridReplaced(const QSharedPointer<sp::Grid> &snapshot);
+
+    //! Report that the recorded grid has been replaced wholesale. A copy of
+    //! it is handed to the recorder, if there is one.
+    void gridReplaced(sp::Grid *grid);
+
     //! Log the provided cell grid to the latest solve step in the collection. 
     //! The caller must also indicate the intended verbosity level of the event.
     //! If the indicated verbosity is higher than the internal settings, the
-    //! event won't be logged.
+    //! event won't be logged. Events filtered out by both verbosity settings
+    //! return right here without a function call. When recording 
+    //! asynchronously, only cell types are logged unless working_values is 
+    //! set, in which case the grid is copied to keep its working values.
     void logCellGrid(sp::Grid *cell_grid, LogVerbosity log_vb,
-        GuiUpdateVerbosity gui_vb);
+        GuiUpdateVerbosity gui_vb, bool working_values=false)
+    {
+      if (log_vb < log_verbosity && gui_vb < gui_verbosity) {
+        return;
+      }
+      recordCellGrid(cell_grid, log_vb, gui_vb, working_values);
+    }
 
   signals:
 
@@ -101,10 +265,21 @@ namespace rt {
 
   private:
 
+    //! Emit and/or store the provided cell grid according to verbosities.
+    void recordCellGrid(sp::Grid *cell_grid, LogVerbosity log_vb,
+        GuiUpdateVerbosity gui_vb, bool working_values);
+
+    //! Post a cell change to the recorder.
+    void postCellChange(const sp::Coord &coord, sp::CellType type, int pin_set_id);
+
     LogVerbosity log_verbosity;             //!< The verbosity of logged steps.
     GuiUpdateVerbosity gui_verbosity;       //!< The verbosity of steps shown in real time.
     SolveCollection *solve_col=nullptr;     //!< SolveCollection to log to.
     SolveSteps *curr_solve_steps=nullptr;   //!< Current solve steps (from solve_col)
+    bool async_recording=false;             //!< Record steps on a background thread.
+    StepRecorder *recorder=nullptr;         //!< Recorder thread of the current run.
+    StepLogWriter *step_log=nullptr;        //!< On-disk log that steps are streamed to.
+    RouteInstrumentation instr;             //!< Counters and timers of the current run.
   };
 
 }
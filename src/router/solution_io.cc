@@ -0,0 +1,364 @@
+// @file:     solution_io.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the solution file writer and reader.
+
+#include <QtEndian>
+#include <QHash>
+#include <QDebug>
+#include <cstring>
+#include "solution_io.h"
+
+using namespace rt;
+
+namespace {
+  const char sol_magic[4] = {'P', 'S', 'O', 'L'};  //!< File magic.
+  const qint32 sol_version = 1;                     //!< Format version.
+  const qint32 sol_end_marker = -1;                 //!< Ends the connection records.
+  const int sol_buf_size = 1 << 16;                 //!< Writer buffer size.
+}
+
+// SolutionWriter class implementations
+
+SolutionWriter::~SolutionWriter()
+{
+  if (file.isOpen()) {
+    finish();
+  }
+}
+
+bool SolutionWriter::open(const QString &path, const SolutionInfo &info)
+{
+  file.setFileName(path);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+    qDebug() << QObject::tr("Unable to open %1 for writing.").arg(path);
+    ok = false;
+    return false;
+  }
+  ok = true;
+  buf.clear();
+  buf.reserve(sol_buf_size);
+
+  // header
+  buf.append(sol_magic, 4);
+  writeInt(sol_version);
+  writeInt(info.dim_x);
+  writeInt(info.dim_y);
+  writeInt(info.pin_sets.size());
+  for (const sp::PinSet &pin_set : info.pin_sets) {
+    writeInt(pin_set.size());
+    for (const sp::Coord &pin : pin_set) {
+      writeInt(pin.x);
+      writeInt(pin.y);
+    }
+  }
+
+  // run metadata
+  writeInt(info.alg);
+  writeInt(info.stats.success);
+  writeInt(info.stats.segments);
+  writeInt(info.stats.routed_cells);
+  writeInt((qint32)(info.stats.time_ms & 0xffffffff));
+  writeInt((qint32)(info.stats.time_ms >> 32));
+  writeInt((qint32)(info.stats.expansions & 0xffffffff));
+  writeInt((qint32)(info.stats.expansions >> 32));
+  writeInt(info.stats.budget_exhausted);
+  return true;
+}
+
+void SolutionWriter::writeConnection(const SolutionConnection &conn)
+{
+  writeInt(conn.pin_set_id);
+  writeInt(conn.pin_pair.first.x);
+  writeInt(conn.pin_pair.first.y);
+  writeInt(conn.pin_pair.second.x);
+  writeInt(conn.pin_pair.second.y);
+  writeInt(conn.segments.size());
+  for (const sp::Segment &seg : conn.segments) {
+    writeInt(seg.start.x);
+    writeInt(seg.start.y);
+    writeInt((seg.length << 2) | seg.dir);
+  }
+}
+
+bool SolutionWriter::finish()
+{
+  if (!file.isOpen()) {
+    return false;
+  }
+  writeInt(sol_end_marker);
+  flushBuffer();
+  file.close();
+  return ok;
+}
+
+bool SolutionWriter::writeGrid(const QString &path, const SolutionInfo &info,
+    sp::Grid *grid)
+{
+  SolutionWriter writer;
+  if (!writer.open(path, info)) {
+    return false;
+  }
+  QSet<sp::Connection*> written;
+  for (auto it=grid->connMap()->constBegin(); it!=grid->connMap()->constEnd(); ++it) {
+    sp::Connection *conn = it.value();
+    if (!written.contains(conn)) {
+      written.insert(conn);
+      SolutionConnection sol_conn;
+      sol_conn.pin_set_id = conn->pinSetId();
+      sol_conn.pin_pair = conn->pinPair();
+      sol_conn.segments = conn->segments();
+      writer.writeConnection(sol_conn);
+    }
+  }
+  return writer.finish();
+}
+
+void SolutionWriter::writeInt(qint32 val)
+{
+  uchar bytes[4];
+  qToLittleEndian(val, bytes);
+  buf.append((const char*)bytes, 4);
+  if (buf.size() >= sol_buf_size) {
+    flushBuffer();
+  }
+}
+
+void SolutionWriter::flushBuffer()
+{
+  if (!buf.isEmpty()) {
+    ok &= (file.write(buf) == buf.size());
+    buf.clear();
+  }
+}
+
+// SolutionFile class implementations
+
+bool SolutionFile::load(const QString &path, QString *error)
+{
+  close();
+  auto fail = [this, error](const QString &msg) -> bool
+  {
+    if (error != nullptr) {
+      *error = msg;
+    }
+    qDebug() << msg;
+    close();
+    return false;
+  };
+
+  // map the file, falling back to reading it if mapping isn't supported
+  file.setFileName(path);
+  if (!file.open(QFile::ReadOnly)) {
+    return fail(QObject::tr("Unable to open %1 for reading.").arg(path));
+  }
+  size = file.size();
+  data = file.map(0, size);
+  if (data == nullptr) {
+    fallback = file.readAll();
+    data = (const uchar*)fallback.constData();
+    size = fallback.size();
+  }
+
+  // header
+  qint64 offset = 0;
+  auto need = [this, &offset](qint64 ints) -> bool
+  {
+    return offset + 4*ints <= size;
+  };
+  if (size < 8 || memcmp(data, sol_magic, 4) != 0) {
+    return fail(QObject::tr("%1 is not a solution file.").arg(path));
+  }
+  offset = 4;
+  if (readInt(offset) != sol_version) {
+    return fail(QObject::tr("%1 has an unsupported solution file version.").arg(path));
+  }
+  if (!need(3)) {
+    return fail(QObject::tr("%1 has a truncated header.").arg(path));
+  }
+  sol_info = SolutionInfo();
+  sol_info.dim_x = readInt(offset);
+  sol_info.dim_y = readInt(offset);
+  int pin_set_count = readInt(offset);
+  for (int i=0; i<pin_set_count; i++) {
+    if (!need(1)) {
+      return fail(QObject::tr("%1 has a truncated header.").arg(path));
+    }
+    int pin_count = readInt(offset);
+    if (pin_count < 0 || !need(2*(qint64)pin_count)) {
+      return fail(QObject::tr("%1 has a truncated header.").arg(path));
+    }
+    sp::PinSet pin_set;
+    for (int j=0; j<pin_count; j++) {
+      int x = readInt(offset);
+      int y = readInt(offset);
+      pin_set.append(sp::Coord(x, y));
+    }
+    sol_info.pin_sets.append(pin_set);
+  }
+  if (!need(9)) {
+    return fail(QObject::tr("%1 has a truncated header.").arg(path));
+  }
+  sol_info.alg = (AvailAlg)readInt(offset);
+  sol_info.stats.success = readInt(offset);
+  sol_info.stats.segments = readInt(offset);
+  sol_info.stats.routed_cells = readInt(offset);
+  quint32 time_lo = readInt(offset);
+  qint64 time_hi = readInt(offset);
+  sol_info.stats.time_ms = (time_hi << 32) | time_lo;
+  quint32 exp_lo = readInt(offset);
+  qint64 exp_hi = readInt(offset);
+  sol_info.stats.expansions = (exp_hi << 32) | exp_lo;
+  sol_info.stats.budget_exhausted = readInt(offset);
+
+  // index the connection records without decoding them
+  while (true) {
+    if (!need(1)) {
+      return fail(QObject::tr("%1 is missing its end marker.").arg(path));
+    }
+    qint64 rec_offset = offset;
+    qint32 pin_set_id = readInt(offset);
+    if (pin_set_id == sol_end_marker) {
+      break;
+    }
+    if (!need(5)) {
+      return fail(QObject::tr("%1 has a truncated connection record.").arg(path));
+    }
+    // the connection must join two pins of a net in the header
+    int ax = readInt(offset);
+    int ay = readInt(offset);
+    int bx = readInt(offset);
+    int by = readInt(offset);
+    if (pin_set_id < 0 || pin_set_id >= sol_info.pin_sets.size()
+        || !sol_info.pin_sets[pin_set_id].contains(sp::Coord(ax, ay))
+        || !sol_info.pin_sets[pin_set_id].contains(sp::Coord(bx, by))) {
+      return fail(QObject::tr("%1 has a connection that doesn't join two pins "
+            "of its net.").arg(path));
+    }
+    qint32 seg_count = readInt(offset);
+    if (seg_count < 0 || !need(3*(qint64)seg_count)) {
+      return fail(QObject::tr("%1 has a truncated connection record.").arg(path));
+    }
+    offset += 4*3*(qint64)seg_count;
+    conn_offsets.append(rec_offset);
+  }
+  return true;
+}
+
+void SolutionFile::close()
+{
+  if (data != nullptr && fallback.isEmpty()) {
+    file.unmap(const_cast<uchar*>(data));
+  }
+  data = nullptr;
+  size = 0;
+  fallback.clear();
+  conn_offsets.clear();
+  if (file.isOpen()) {
+    file.close();
+  }
+}
+
+SolutionConnection SolutionFile::connection(int i) const
+{
+  SolutionConnection conn;
+  qint64 offset = conn_offsets.value(i, -1);
+  if (offset < 0) {
+    return conn;
+  }
+  conn.pin_set_id = readInt(offset);
+  int ax = readInt(offset);
+  int ay = readInt(offset);
+  int bx = readInt(offset);
+  int by = readInt(offset);
+  conn.pin_pair = qMakePair(sp::Coord(ax, ay), sp::Coord(bx, by));
+  int seg_count = readInt(offset);
+  conn.segments.reserve(seg_count);
+  for (int j=0; j<seg_count; j++) {
+    int x = readInt(offset);
+    int y = readInt(offset);
+    qint32 len_dir = readInt(offset);
+    conn.segments.append(sp::Segment(sp::Coord(x, y),
+          (sp::Segment::Direction)(len_dir & 0x3), len_dir >> 2));
+  }
+  return conn;
+}
+
+QList<sp::Connection> SolutionFile::connections() const
+{
+  QList<sp::Connection> conns;
+  conns.reserve(connectionCount());
+  for (int i=0; i<connectionCount(); i++) {
+    SolutionConnection sol_conn = connection(i);
+    conns.append(sp::Connection(sol_conn.pin_pair, sol_conn.segments,
+          sol_conn.pin_set_id));
+  }
+  return conns;
+}
+
+bool SolutionFile::applyToGrid(sp::Grid *grid, QString *error) const
+{
+  auto fail = [error](const QString &msg) -> bool
+  {
+    if (error != nullptr) {
+      *error = msg;
+    }
+    qDebug() << msg;
+    return false;
+  };
+
+  if (grid->dimensions() != sp::Coord(sol_info.dim_x, sol_info.dim_y)) {
+    return fail(QObject::tr("The solution's grid size doesn't match the problem."));
+  }
+
+  // check every connection before changing anything, so that a solution that
+  // doesn't fit leaves the grid untouched
+  QList<sp::Connection> decoded = connections();
+  QHash<sp::Coord, int> claimed;  // pin set ID of each routed cell
+  for (const sp::Connection &conn : decoded) {
+    // the pins must belong to the same net in the grid
+    for (const sp::Coord &pin : {conn.pinPair().first, conn.pinPair().second}) {
+      sp::Cell *cell = grid->cellAt(pin);
+      if (cell == nullptr || cell->getType() != sp::PinCell
+          || cell->pinSetId() != conn.pinSetId()) {
+        return fail(QObject::tr("Pin %1 doesn't belong to net %2 in the problem.")
+            .arg(pin.str()).arg(conn.pinSetId()));
+      }
+    }
+    // every cell must be free or already belong to the same net
+    for (const sp::Coord &coord : conn) {
+      if (!grid->isWithinBounds(coord)) {
+        return fail(QObject::tr("Routed cell %1 is out of bounds.").arg(coord.str()));
+      }
+      sp::Cell *cell = grid->cellAt(coord);
+      if ((cell->getType() != sp::BlankCell && cell->pinSetId() != conn.pinSetId())
+          || claimed.value(coord, conn.pinSetId()) != conn.pinSetId()) {
+        return fail(QObject::tr("Routed cell %1 clashes with the problem.").arg(coord.str()));
+      }
+      claimed.insert(coord, conn.pinSetId());
+    }
+  }
+
+  // create the connections
+  for (const sp::Connection &decoded_conn : decoded) {
+    sp::Connection *conn = grid->newConnection(decoded_conn.pinPair(),
+        decoded_conn.segments(), decoded_conn.pinSetId());
+    for (const sp::Coord &coord : *conn) {
+      grid->connMap()->insert(coord, conn);
+      sp::Cell *cell = grid->cellAt(coord);
+      if (cell->getType() == sp::BlankCell) {
+        grid->setCellType(coord, sp::RoutedCell, conn->pinSetId());
+      }
+    }
+  }
+  return true;
+}
+
+qint32 SolutionFile::readInt(qint64 &offset) const
+{
+  qint32 val = qFromLittleEndian<qint32>(data + offset);
+  offset += 4;
+  return val;
+}
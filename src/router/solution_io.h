@@ -0,0 +1,132 @@
+// @file:     solution_io.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Reading and writing of routed solution files.
+
+#ifndef _RT_SOLUTION_IO_H_
+#define _RT_SOLUTION_IO_H_
+
+#include <QFile>
+#include "route_api.h"
+
+namespace rt {
+
+  //! Problem description and run metadata stored in a solution file.
+  struct SolutionInfo
+  {
+    int dim_x=0;                  //!< x size of the routed grid.
+    int dim_y=0;                  //!< y size of the routed grid.
+    QList<sp::PinSet> pin_sets;   //!< Pin sets of the routed problem.
+    AvailAlg alg=AStar;           //!< Algorithm that produced the solution.
+    RouteStats stats;             //!< Statistics of the routing run.
+  };
+
+  //! A routed connection as stored in a solution file.
+  struct SolutionConnection
+  {
+    int pin_set_id=-1;                //!< Net that the connection belongs to.
+    sp::PinPair pin_pair;             //!< Pins that the connection joins.
+    QVector<sp::Segment> segments;    //!< Routed cells as run-length segments.
+  };
+
+  //! Streams a solution file to disk. The file consists of a little-endian
+  //! header (magic, version, grid size, pin sets and run metadata) followed
+  //! by one record per connection, each storing its net, pin pair and routed
+  //! cells as run-length segments, and an end marker.
+  class SolutionWriter
+  {
+  public:
+
+    //! Empty constructor.
+    SolutionWriter() {};
+
+    //! Destructor, finishes the file if that hasn't been done.
+    ~SolutionWriter();
+
+    //! Open the file at the provided path and write the header. Return false
+    //! if the file can't be opened.
+    bool open(const QString &path, const SolutionInfo &info);
+
+    //! Append a connection record.
+    void writeConnection(const SolutionConnection &conn);
+
+    //! Write the end marker and close the file. Return whether everything
+    //! has been written successfully.
+    bool finish();
+
+    //! Convenience function that writes all connections in the provided grid
+    //! to a solution file at the provided path.
+    static bool writeGrid(const QString &path, const SolutionInfo &info,
+        sp::Grid *grid);
+
+  private:
+
+    //! Append an int to the write buffer, flushing it if it's full.
+    void writeInt(qint32 val);
+
+    //! Write out the buffer.
+    void flushBuffer();
+
+    // Private variables
+    QFile file;         //!< The file being written.
+    QByteArray buf;     //!< Write buffer.
+    bool ok=false;      //!< Whether all writes have succeeded.
+  };
+
+  //! Reads a solution file by memory-mapping it. The header is parsed on load
+  //! while connection records are only indexed, they are decoded on demand.
+  class SolutionFile
+  {
+  public:
+
+    //! Empty constructor.
+    SolutionFile() {};
+
+    //! Destructor, unmaps the file.
+    ~SolutionFile() {close();}
+
+    //! Load the solution file at the provided path. Return false if it can't
+    //! be read or is malformed, e.g. a connection doesn't join two pins of
+    //! its net, in which case error (if provided) says why.
+    bool load(const QString &path, QString *error=nullptr);
+
+    //! Unmap and close the file.
+    void close();
+
+    //! Return the problem description and run metadata.
+    const SolutionInfo &info() const {return sol_info;}
+
+    //! Return the number of connections in the file.
+    int connectionCount() const {return conn_offsets.size();}
+
+    //! Decode and return the i-th connection.
+    SolutionConnection connection(int i) const;
+
+    //! Decode all connections, e.g. to seed incremental rerouting.
+    QList<sp::Connection> connections() const;
+
+    //! Create the connections of this solution in the provided grid, which
+    //! should contain the unrouted problem. Return false if the solution
+    //! doesn't fit the grid, in which case the grid is left unchanged and
+    //! error (if provided) says why.
+    bool applyToGrid(sp::Grid *grid, QString *error=nullptr) const;
+
+  private:
+
+    //! Read an int at the provided offset, advancing the offset.
+    qint32 readInt(qint64 &offset) const;
+
+    // Private variables
+    QFile file;                     //!< The mapped file.
+    QByteArray fallback;            //!< File contents if mapping isn't possible.
+    const uchar *data=nullptr;      //!< Start of the file contents.
+    qint64 size=0;                  //!< Size of the file contents.
+    QVector<qint64> conn_offsets;   //!< Offsets of the connection records.
+    SolutionInfo sol_info;          //!< Header contents.
+  };
+
+}
+
+#endif
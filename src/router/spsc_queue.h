@@ -0,0 +1,78 @@
+// @file:     spsc_queue.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Bounded lock-free single-producer single-consumer queue.
+
+#ifndef _RT_SPSC_QUEUE_H_
+#define _RT_SPSC_QUEUE_H_
+
+#include <QVector>
+#include <atomic>
+
+namespace rt {
+
+  //! Bounded lock-free queue for handing items from exactly one producer 
+  //! thread to exactly one consumer thread. Neither side ever blocks: pushing
+  //! to a full queue or popping from an empty one just fails.
+  template<typename T>
+  class SpscQueue
+  {
+  public:
+
+    //! Constructor taking the capacity, rounded up to a power of two.
+    explicit SpscQueue(int min_capacity)
+    {
+      int capacity = 1;
+      while (capacity < min_capacity) {
+        capacity <<= 1;
+      }
+      buf.resize(capacity);
+      slots = buf.data();
+      mask = capacity - 1;
+    }
+
+    //! Append an item. Return false if the queue is full. Producer only.
+    bool tryPush(const T &item)
+    {
+      size_t t = tail.load(std::memory_order_relaxed);
+      if (t - head.load(std::memory_order_acquire) > mask) {
+        return false;
+      }
+      slots[t & mask] = item;
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    //! Take the oldest item. Return false if the queue is empty. Consumer 
+    //! only.
+    bool tryPop(T &item)
+    {
+      size_t h = head.load(std::memory_order_relaxed);
+      if (h == tail.load(std::memory_order_acquire)) {
+        return false;
+      }
+      item = slots[h & mask];
+      // don't keep whatever the item holds on to alive in the slot
+      slots[h & mask] = T();
+      head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    //! Return the capacity of the queue.
+    int capacity() const {return (int)mask + 1;}
+
+  private:
+
+    // the buffer is allocated once, the threads only go through slots
+    QVector<T> buf;                   //!< Owns the slots.
+    T *slots;                         //!< Ring of slots.
+    size_t mask;                      //!< Capacity - 1, for wrapping indices.
+    alignas(64) std::atomic<size_t> head{0};  //!< Next slot to pop.
+    alignas(64) std::atomic<size_t> tail{0};  //!< Next slot to push.
+  };
+
+}
+
+#endif
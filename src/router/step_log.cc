@@ -0,0 +1,491 @@
+// @file:     step_log.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the step log writer and reader.
+
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include "step_log.h"
+
+using namespace rt;
+
+namespace {
+  const char log_magic[4] = {'P', 'S', 'L', 'G'};   //!< File magic.
+  const char index_magic[4] = {'P', 'S', 'L', 'I'}; //!< Keyframe index trailer magic.
+  const qint32 log_version = 1;                     //!< Format version.
+  const qint32 log_end_marker = -1;                 //!< Ends the step records.
+  const qint32 kind_keyframe = 0;                   //!< Record holds every cell.
+  const qint32 kind_delta = 1;                      //!< Record holds changed cells.
+  const int cell_bytes = 5;                         //!< Type and pin set ID.
+  const int change_bytes = 4 + cell_bytes;          //!< Cell index, type and pin set ID.
+  const int log_buf_size = 1 << 16;                 //!< Writer buffer size.
+  const int log_compression = 1;                    //!< zlib level, favour speed.
+  const qint64 max_cells = 100000000;               //!< Largest grid accepted on load.
+
+  //! Append a little-endian int to the provided bytes.
+  void appendInt(QByteArray &bytes, qint32 val)
+  {
+    uchar le[4];
+    qToLittleEndian(val, le);
+    bytes.append((const char*)le, 4);
+  }
+}
+
+// StepLogWriter class implementations
+
+StepLogWriter::~StepLogWriter()
+{
+  if (file.isOpen()) {
+    finish();
+  }
+}
+
+bool StepLogWriter::open(const QString &path, const sp::Coord &dims,
+    const QList<sp::PinSet> &pin_sets)
+{
+  file.setFileName(path);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+    qDebug() << QObject::tr("Unable to open %1 for writing.").arg(path);
+    ok = false;
+    return false;
+  }
+  ok = true;
+  buf.clear();
+  buf.reserve(log_buf_size);
+  offset = 0;
+  attempt_steps.clear();
+  step_total = 0;
+  keyframes.clear();
+  cell_count = dims.x * dims.y;
+  types.fill(sp::BlankCell, cell_count);
+  pin_ids.fill(-1, cell_count);
+
+  // header
+  writeBytes(QByteArray(log_magic, 4));
+  writeInt(log_version);
+  writeInt(dims.x);
+  writeInt(dims.y);
+  writeInt(pin_sets.size());
+  for (const sp::PinSet &pin_set : pin_sets) {
+    writeInt(pin_set.size());
+    for (const sp::Coord &pin : pin_set) {
+      writeInt(pin.x);
+      writeInt(pin.y);
+    }
+  }
+  return true;
+}
+
+void StepLogWriter::beginAttempt()
+{
+  attempt_steps.append(0);
+}
+
+void StepLogWriter::writeStep(const sp::Grid *grid)
+{
+  if (!file.isOpen()) {
+    return;
+  }
+  const QVector<sp::Cell> &cells = grid->cellStorage();
+  if (cells.size() != cell_count) {
+    qWarning() << "Step grid size doesn't match the step log.";
+    return;
+  }
+  if (attempt_steps.isEmpty()) {
+    beginAttempt();
+  }
+  int step = attempt_steps.last();
+
+  // try a delta against the previous step first
+  bool keyframe = (step % keyframe_interval == 0);
+  if (!keyframe) {
+    raw.clear();
+    appendInt(raw, 0);
+    int changes = 0;
+    for (int i=0; i<cell_count; i++) {
+      quint8 type = cells[i].getType();
+      qint32 pin_id = cells[i].pinSetId();
+      if (type != types[i] || pin_id != pin_ids[i]) {
+        types[i] = type;
+        pin_ids[i] = pin_id;
+        appendInt(raw, i);
+        raw.append((char)type);
+        appendInt(raw, pin_id);
+        changes++;
+      }
+    }
+    qToLittleEndian(changes, (uchar*)raw.data());
+    // a delta covering most of the grid is better stored as a keyframe
+    keyframe = ((qint64)changes * change_bytes > (qint64)cell_count * cell_bytes);
+  }
+  if (keyframe) {
+    raw.clear();
+    raw.reserve(cell_count * cell_bytes);
+    for (int i=0; i<cell_count; i++) {
+      types[i] = cells[i].getType();
+      pin_ids[i] = cells[i].pinSetId();
+      raw.append((char)types[i]);
+      appendInt(raw, pin_ids[i]);
+    }
+    keyframes.append({attempt_steps.size()-1, step, offset + buf.size()});
+  }
+
+  QByteArray payload = qCompress(raw, log_compression);
+  writeInt(attempt_steps.size()-1);
+  writeInt(step);
+  writeInt(keyframe ? kind_keyframe : kind_delta);
+  writeInt(payload.size());
+  writeBytes(payload);
+  attempt_steps.last()++;
+  step_total++;
+}
+
+bool StepLogWriter::finish()
+{
+  if (!file.isOpen()) {
+    return false;
+  }
+  writeInt(log_end_marker);
+
+  // keyframe index, found through the trailer at the very end
+  qint64 index_offset = offset + buf.size();
+  writeInt(attempt_steps.size());
+  for (qint32 steps : attempt_steps) {
+    writeInt(steps);
+  }
+  writeInt(keyframes.size());
+  for (const Keyframe &kf : keyframes) {
+    writeInt(kf.attempt);
+    writeInt(kf.step);
+    writeInt((qint32)(kf.offset & 0xffffffff));
+    writeInt((qint32)(kf.offset >> 32));
+  }
+  writeInt((qint32)(index_offset & 0xffffffff));
+  writeInt((qint32)(index_offset >> 32));
+  writeBytes(QByteArray(index_magic, 4));
+
+  flushBuffer();
+  file.close();
+  return ok;
+}
+
+void StepLogWriter::writeInt(qint32 val)
+{
+  appendInt(buf, val);
+  if (buf.size() >= log_buf_size) {
+    flushBuffer();
+  }
+}
+
+void StepLogWriter::writeBytes(const QByteArray &bytes)
+{
+  buf.append(bytes);
+  if (buf.size() >= log_buf_size) {
+    flushBuffer();
+  }
+}
+
+void StepLogWriter::flushBuffer()
+{
+  if (!buf.isEmpty()) {
+    ok &= (file.write(buf) == buf.size());
+    offset += buf.size();
+    buf.clear();
+  }
+}
+
+// StepLogFile class implementations
+
+bool StepLogFile::load(const QString &path, QString *error)
+{
+  close();
+  auto fail = [this, error](const QString &msg) -> bool
+  {
+    if (error != nullptr) {
+      *error = msg;
+    }
+    qDebug() << msg;
+    close();
+    return false;
+  };
+
+  // map the file, falling back to reading it if mapping isn't supported
+  file.setFileName(path);
+  if (!file.open(QFile::ReadOnly)) {
+    return fail(QObject::tr("Unable to open %1 for reading.").arg(path));
+  }
+  size = file.size();
+  data = file.map(0, size);
+  if (data == nullptr) {
+    fallback = file.readAll();
+    data = (const uchar*)fallback.constData();
+    size = fallback.size();
+  }
+
+  // header
+  qint64 offset = 0;
+  auto need = [this, &offset](qint64 ints) -> bool
+  {
+    return offset + 4*ints <= size;
+  };
+  if (size < 8 || memcmp(data, log_magic, 4) != 0) {
+    return fail(QObject::tr("%1 is not a step log.").arg(path));
+  }
+  offset = 4;
+  if (readInt(offset) != log_version) {
+    return fail(QObject::tr("%1 has an unsupported step log version.").arg(path));
+  }
+  if (!need(3)) {
+    return fail(QObject::tr("%1 has a truncated header.").arg(path));
+  }
+  dims.x = readInt(offset);
+  dims.y = readInt(offset);
+  if (dims.x <= 0 || dims.y <= 0 || (qint64)dims.x * dims.y > max_cells) {
+    return fail(QObject::tr("%1 has an invalid grid size.").arg(path));
+  }
+  int pin_set_count = readInt(offset);
+  for (int i=0; i<pin_set_count; i++) {
+    if (!need(1)) {
+      return fail(QObject::tr("%1 has a truncated header.").arg(path));
+    }
+    int pin_count = readInt(offset);
+    if (pin_count < 0 || !need(2*(qint64)pin_count)) {
+      return fail(QObject::tr("%1 has a truncated header.").arg(path));
+    }
+    sp::PinSet pin_set;
+    for (int j=0; j<pin_count; j++) {
+      int x = readInt(offset);
+      int y = readInt(offset);
+      pin_set.append(sp::Coord(x, y));
+    }
+    pin_sets.append(pin_set);
+  }
+
+  // use the keyframe index if the log was finished, otherwise index whatever
+  // made it to disk
+  if (!readIndex(offset)) {
+    scanRecords(offset);
+  }
+  types.fill(sp::BlankCell, dims.x * dims.y);
+  pin_ids.fill(-1, dims.x * dims.y);
+  return true;
+}
+
+void StepLogFile::close()
+{
+  if (data != nullptr && fallback.isEmpty()) {
+    file.unmap(const_cast<uchar*>(data));
+  }
+  data = nullptr;
+  size = 0;
+  fallback.clear();
+  dims = sp::Coord();
+  pin_sets.clear();
+  attempts.clear();
+  curr_attempt = -1;
+  curr_step = -1;
+  types.clear();
+  pin_ids.clear();
+  if (file.isOpen()) {
+    file.close();
+  }
+}
+
+bool StepLogFile::readStep(int attempt, int step, sp::Grid *grid)
+{
+  if (attempt < 0 || attempt >= attempts.size() || step < 0
+      || step >= attempts[attempt].step_count || grid->dimensions() != dims) {
+    return false;
+  }
+
+  // start from the nearest keyframe, or from the decoded step if it's closer
+  const AttemptIndex &index = attempts[attempt];
+  auto kf_it = std::upper_bound(index.kf_steps.constBegin(),
+      index.kf_steps.constEnd(), step);
+  if (kf_it == index.kf_steps.constBegin()) {
+    return false;
+  }
+  int kf = (kf_it - index.kf_steps.constBegin()) - 1;
+  int from_step = index.kf_steps[kf];
+  qint64 offset = index.kf_offsets[kf];
+  if (curr_attempt == attempt && curr_step >= from_step && curr_step <= step) {
+    from_step = curr_step + 1;
+    offset = curr_next;
+  }
+  for (int s=from_step; s<=step; s++) {
+    if (!applyRecord(offset)) {
+      curr_attempt = -1;
+      return false;
+    }
+  }
+  curr_attempt = attempt;
+  curr_step = step;
+  curr_next = offset;
+
+  // copy the decoded cells into the grid
+  for (int x=0; x<dims.x; x++) {
+    for (int y=0; y<dims.y; y++) {
+      int i = x * dims.y + y;
+      sp::Coord coord(x, y);
+      grid->setCellType(coord, (sp::CellType)types[i], pin_ids[i]);
+    }
+  }
+  grid->clearWorkingValues();
+  return true;
+}
+
+qint32 StepLogFile::readInt(qint64 &offset) const
+{
+  qint32 val = qFromLittleEndian<qint32>(data + offset);
+  offset += 4;
+  return val;
+}
+
+bool StepLogFile::applyRecord(qint64 &offset)
+{
+  if (offset + 16 > size) {
+    return false;
+  }
+  offset += 8;  // attempt and step, already known from the index
+  qint32 kind = readInt(offset);
+  qint32 len = readInt(offset);
+  if (len < 0 || offset + len > size) {
+    return false;
+  }
+  QByteArray raw = qUncompress(data + offset, len);
+  offset += len;
+
+  // cells go straight into a grid, so corrupt types and IDs are rejected
+  auto validCell = [this](quint8 type, qint32 pin_id) -> bool
+  {
+    return type <= sp::BlankCell && pin_id >= -1 && pin_id < pin_sets.size();
+  };
+  const char *bytes = raw.constData();
+  int cell_count = types.size();
+  if (kind == kind_keyframe) {
+    if (raw.size() != cell_count * cell_bytes) {
+      return false;
+    }
+    for (int i=0; i<cell_count; i++) {
+      types[i] = (quint8)bytes[i*cell_bytes];
+      pin_ids[i] = qFromLittleEndian<qint32>(bytes + i*cell_bytes + 1);
+      if (!validCell(types[i], pin_ids[i])) {
+        return false;
+      }
+    }
+  } else {
+    if (raw.size() < 4) {
+      return false;
+    }
+    qint32 changes = qFromLittleEndian<qint32>(bytes);
+    if (changes < 0 || raw.size() != 4 + (qint64)changes * change_bytes) {
+      return false;
+    }
+    for (int c=0; c<changes; c++) {
+      const char *change = bytes + 4 + c*change_bytes;
+      qint32 i = qFromLittleEndian<qint32>(change);
+      if (i < 0 || i >= cell_count) {
+        return false;
+      }
+      types[i] = (quint8)change[4];
+      pin_ids[i] = qFromLittleEndian<qint32>(change + 5);
+      if (!validCell(types[i], pin_ids[i])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool StepLogFile::scanRecords(qint64 offset)
+{
+  attempts.clear();
+  while (offset + 16 <= size) {
+    qint64 rec_offset = offset;
+    qint32 attempt = readInt(offset);
+    if (attempt == log_end_marker) {
+      break;
+    }
+    qint32 step = readInt(offset);
+    qint32 kind = readInt(offset);
+    qint32 len = readInt(offset);
+    if (attempt < 0 || attempt > attempts.size() || len < 0 || offset + len > size) {
+      // cut short while being written, or corrupt
+      break;
+    }
+    offset += len;
+    if (attempts.size() <= attempt) {
+      attempts.resize(attempt + 1);
+    }
+    if (step != attempts[attempt].step_count) {
+      break;
+    }
+    attempts[attempt].step_count++;
+    if (kind == kind_keyframe) {
+      addKeyframe(attempt, step, rec_offset);
+    }
+  }
+  return !attempts.isEmpty();
+}
+
+bool StepLogFile::readIndex(qint64 records_offset)
+{
+  if (size < records_offset + 12 || memcmp(data + size - 4, index_magic, 4) != 0) {
+    return false;
+  }
+  qint64 offset = size - 12;
+  quint32 lo = readInt(offset);
+  qint64 hi = readInt(offset);
+  qint64 index_offset = (hi << 32) | lo;
+  if (index_offset < records_offset || index_offset > size - 12) {
+    return false;
+  }
+  offset = index_offset;
+  auto need = [this, &offset](qint64 ints) -> bool
+  {
+    return offset + 4*ints <= size - 12;
+  };
+
+  if (!need(1)) {
+    return false;
+  }
+  int attempt_count = readInt(offset);
+  if (attempt_count < 0 || !need((qint64)attempt_count + 1)) {
+    return false;
+  }
+  attempts.clear();
+  attempts.resize(attempt_count);
+  for (int i=0; i<attempt_count; i++) {
+    attempts[i].step_count = qMax(0, readInt(offset));
+  }
+  int kf_count = readInt(offset);
+  if (kf_count < 0 || !need(4*(qint64)kf_count)) {
+    attempts.clear();
+    return false;
+  }
+  for (int i=0; i<kf_count; i++) {
+    int attempt = readInt(offset);
+    int step = readInt(offset);
+    quint32 kf_lo = readInt(offset);
+    qint64 kf_hi = readInt(offset);
+    qint64 kf_offset = (kf_hi << 32) | kf_lo;
+    if (attempt < 0 || attempt >= attempt_count || step < 0
+        || step >= attempts[attempt].step_count 
+        || kf_offset < records_offset || kf_offset >= index_offset) {
+      attempts.clear();
+      return false;
+    }
+    addKeyframe(attempt, step, kf_offset);
+  }
+  return true;
+}
+
+void StepLogFile::addKeyframe(int attempt, int step, qint64 offset)
+{
+  attempts[attempt].kf_steps.append(step);
+  attempts[attempt].kf_offsets.append(offset);
+}
@@ -0,0 +1,176 @@
+// @file:     step_log.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Append-only on-disk log of routing steps.
+
+#ifndef _RT_STEP_LOG_H_
+#define _RT_STEP_LOG_H_
+
+#include <QFile>
+#include "spatial.h"
+
+namespace rt {
+
+  //! Streams routing steps to an append-only step log on disk. Only cell 
+  //! types and pin set IDs are logged. The file consists of a little-endian 
+  //! header (magic, version, grid size and pin sets) followed by one record
+  //! per step, each holding the attempt and step index and a zlib compressed
+  //! payload that is either a keyframe (every cell) or a delta (the cells
+  //! that changed since the previous step of the same attempt). Each attempt
+  //! starts with a keyframe and keyframes recur at least every 
+  //! keyframe_interval steps. finish() appends an end marker and an index of
+  //! keyframes; logs cut short without it can still be read.
+  class StepLogWriter
+  {
+  public:
+
+    //! Empty constructor.
+    StepLogWriter() {};
+
+    //! Destructor, finishes the file if that hasn't been done.
+    ~StepLogWriter();
+
+    //! Open the file at the provided path and write the header. Return false
+    //! if the file can't be opened.
+    bool open(const QString &path, const sp::Coord &dims,
+        const QList<sp::PinSet> &pin_sets);
+
+    //! Start a new solve attempt.
+    void beginAttempt();
+
+    //! Append the provided grid as the next step of the current attempt.
+    void writeStep(const sp::Grid *grid);
+
+    //! Write the end marker and keyframe index and close the file. Return
+    //! whether everything has been written successfully.
+    bool finish();
+
+    //! Return the number of steps written.
+    int stepCount() const {return step_total;}
+
+    static const int keyframe_interval = 64;  //!< Maximum steps between keyframes.
+
+  private:
+
+    //! Append an int to the write buffer, flushing it if it's full.
+    void writeInt(qint32 val);
+
+    //! Append raw bytes to the write buffer, flushing it if it's full.
+    void writeBytes(const QByteArray &bytes);
+
+    //! Write out the buffer.
+    void flushBuffer();
+
+    //! A keyframe index entry.
+    struct Keyframe
+    {
+      qint32 attempt;   //!< Attempt index.
+      qint32 step;      //!< Step index within the attempt.
+      qint64 offset;    //!< File offset of the record.
+    };
+
+    // Private variables
+    QFile file;                 //!< The file being written.
+    QByteArray buf;             //!< Write buffer.
+    qint64 offset=0;            //!< File offset at the end of the buffer.
+    bool ok=false;              //!< Whether all writes have succeeded.
+    QVector<qint32> attempt_steps;  //!< Steps written per attempt.
+    int step_total=0;           //!< Steps written overall.
+    int cell_count=0;           //!< Cells per step.
+    QVector<quint8> types;      //!< Cell types as of the last step.
+    QVector<qint32> pin_ids;    //!< Pin set IDs as of the last step.
+    QByteArray raw;             //!< Scratch buffer for uncompressed payloads.
+    QVector<Keyframe> keyframes;//!< Keyframes written so far.
+  };
+
+  //! Reads a step log by memory-mapping it. Loading only indexes the records;
+  //! any step is decoded from the nearest keyframe before it, so scrubbing 
+  //! costs at most keyframe_interval deltas regardless of the log size.
+  class StepLogFile
+  {
+  public:
+
+    //! Empty constructor.
+    StepLogFile() {};
+
+    //! Destructor, unmaps the file.
+    ~StepLogFile() {close();}
+
+    //! Load the step log at the provided path. Return false if it can't be
+    //! read or is malformed, in which case error (if provided) says why.
+    bool load(const QString &path, QString *error=nullptr);
+
+    //! Unmap and close the file.
+    void close();
+
+    //! Return the grid size of the logged problem.
+    sp::Coord dimensions() const {return dims;}
+
+    //! Return the pin sets of the logged problem.
+    const QList<sp::PinSet> &pinSets() const {return pin_sets;}
+
+    //! Return the size of the log file in bytes.
+    qint64 fileSize() const {return size;}
+
+    //! Return the number of logged attempts.
+    int attemptCount() const {return attempts.size();}
+
+    //! Return the number of steps logged in the provided attempt.
+    int stepCount(int attempt) const {return attempts.value(attempt).step_count;}
+
+    //! Set the cells of the provided grid, which must have the logged grid
+    //! size, to the provided step. Return false if there's no such step or
+    //! its records are corrupt, e.g. hold unknown cell types or pin set IDs.
+    bool readStep(int attempt, int step, sp::Grid *grid);
+
+  private:
+
+    //! Read an int at the provided offset, advancing the offset.
+    qint32 readInt(qint64 &offset) const;
+
+    //! Decode the record at the provided offset into the current cells and
+    //! advance the offset to the next record. Return false if the record is
+    //! corrupt.
+    bool applyRecord(qint64 &offset);
+
+    //! Index the records by scanning the file from the provided offset, for
+    //! logs without a keyframe index. Return false if nothing was found.
+    bool scanRecords(qint64 offset);
+
+    //! Read the keyframe index at the end of the file. Return false if it's 
+    //! missing or malformed.
+    bool readIndex(qint64 records_offset);
+
+    //! Record the keyframe at the provided offset in the index.
+    void addKeyframe(int attempt, int step, qint64 offset);
+
+    //! Steps and keyframes of a logged attempt.
+    struct AttemptIndex
+    {
+      int step_count=0;             //!< Steps logged in the attempt.
+      QVector<int> kf_steps;        //!< Step index of each keyframe.
+      QVector<qint64> kf_offsets;   //!< File offset of each keyframe.
+    };
+
+    // Private variables
+    QFile file;                     //!< The mapped file.
+    QByteArray fallback;            //!< File contents if mapping isn't possible.
+    const uchar *data=nullptr;      //!< Start of the file contents.
+    qint64 size=0;                  //!< Size of the file contents.
+    sp::Coord dims;                 //!< Logged grid size.
+    QList<sp::PinSet> pin_sets;     //!< Logged pin sets.
+    QVector<AttemptIndex> attempts; //!< Index of each attempt.
+
+    // decoded state, kept to make scrubbing forward cheap
+    int curr_attempt=-1;            //!< Attempt of the decoded cells.
+    int curr_step=-1;               //!< Step of the decoded cells.
+    qint64 curr_next=0;             //!< Offset of the record after the decoded step.
+    QVector<quint8> types;          //!< Decoded cell types.
+    QVector<qint32> pin_ids;        //!< Decoded pin set IDs.
+  };
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+// @file:     step_recorder.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the StepRecorder class.
+
+#include "step_recorder.h"
+#include "step_log.h"
+
+using namespace rt;
+
+StepRecorder::StepRecorder(SolveCollection *solve_col, StepLogWriter *step_log,
+    int queue_capacity)
+  : queue(queue_capacity), solve_col(solve_col), step_log(step_log)
+{
+}
+
+StepRecorder::~StepRecorder()
+{
+  finish();
+}
+
+void StepRecorder::post(const StepRecord &record)
+{
+  if (!overflow.isEmpty()) {
+    flushOverflow();
+  }
+  // keep the order of records, nothing jumps ahead of the overflow
+  if (!overflow.isEmpty() || !queue.tryPush(record)) {
+    overflow.append(record);
+  }
+}
+
+void StepRecorder::finish()
+{
+  if (!isRunning()) {
+    return;
+  }
+  while (!overflow.isEmpty()) {
+    flushOverflow();
+    if (!overflow.isEmpty()) {
+      yieldCurrentThread();
+    }
+  }
+  stopping.store(true, std::memory_order_release);
+  wait();
+}
+
+void StepRecorder::run()
+{
+  StepRecord record;
+  while (true) {
+    if (queue.tryPop(record)) {
+      apply(record);
+      record = StepRecord();
+    } else if (stopping.load(std::memory_order_acquire)) {
+      // everything posted before stopping is visible by now
+      while (queue.tryPop(record)) {
+        apply(record);
+      }
+      break;
+    } else {
+      usleep(50);
+    }
+  }
+}
+
+void StepRecorder::flushOverflow()
+{
+  int pushed = 0;
+  while (pushed < overflow.size() && queue.tryPush(overflow.at(pushed))) {
+    pushed++;
+  }
+  overflow.erase(overflow.begin(), overflow.begin() + pushed);
+}
+
+void StepRecorder::apply(const StepRecord &record)
+{
+  switch (record.kind) {
+    case StepRecord::CellChange:
+      if (replica && replica->isWithinBounds(record.coord)) {
+        replica->setCellType(record.coord, record.type, record.pin_set_id);
+      }
+      break;
+    case StepRecord::Step:
+      if (replica && step_log != nullptr) {
+        step_log->writeStep(replica.data());
+      } else if (replica && curr_steps != nullptr) {
+        solve_col->appendStep(curr_steps,
+            QSharedPointer<sp::Grid>(new sp::Grid(replica.data())),
+            record.metrics);
+      }
+      break;
+    case StepRecord::Snapshot:
+      if (step_log != nullptr) {
+        step_log->writeStep(record.grid.data());
+      } else if (curr_steps != nullptr) {
+        solve_col->appendStep(curr_steps, record.grid, record.metrics);
+      }
+      break;
+    case StepRecord::Reset:
+      if (replica) {
+        replica->copyState(record.grid.data());
+      } else {
+        replica.reset(new sp::Grid(record.grid.data()));
+      }
+      break;
+    case StepRecord::NewAttempt:
+      if (step_log != nullptr) {
+        step_log->beginAttempt();
+      } else {
+        curr_steps = solve_col->newSolveSteps();
+      }
+      break;
+  }
+}
@@ -0,0 +1,88 @@
+// @file:     step_recorder.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Records routing steps on a background thread from a stream of
+//            cell changes.
+
+#ifndef _RT_STEP_RECORDER_H_
+#define _RT_STEP_RECORDER_H_
+
+#include <QThread>
+#include <QScopedPointer>
+#include "routing_records.h"
+#include "spsc_queue.h"
+
+namespace rt {
+
+  //! A change record sent from the router to the StepRecorder.
+  struct StepRecord
+  {
+    //! What the record describes.
+    enum Kind{
+      CellChange, //!< A cell's type and pin set changed.
+      Step,       //!< A step to be logged with the cells as they are now.
+      Snapshot,   //!< A step to be logged as the provided grid.
+      Reset,      //!< The grid was replaced by the provided grid.
+      NewAttempt  //!< Start a new set of solve steps.
+    };
+
+    Kind kind=Step;                 //!< Record kind.
+    sp::Coord coord;                //!< Changed cell (CellChange).
+    sp::CellType type=sp::BlankCell;//!< New cell type (CellChange).
+    int pin_set_id=-1;              //!< New pin set ID (CellChange).
+    QSharedPointer<sp::Grid> grid;  //!< Grid that isn't modified anymore (Snapshot, Reset).
+    StepMetrics metrics;            //!< Metrics measured by the router (Step, Snapshot).
+  };
+
+  //! Background thread that rebuilds the routed grid from change records and
+  //! writes step grids to a SolveCollection or StepLogWriter at its own pace. The router posts
+  //! records through a lock-free queue and never waits for the recorder; if
+  //! the queue is full, records are kept in an overflow buffer on the router
+  //! side and handed over on later posts.
+  class StepRecorder : public QThread
+  {
+  public:
+
+    //! Constructor taking the collection to write steps to, or the step log
+    //! to write them to instead if one is provided. Neither may be touched by
+    //! anything else until finish() returns.
+    StepRecorder(SolveCollection *solve_col, StepLogWriter *step_log=nullptr,
+        int queue_capacity=1<<16);
+
+    //! Destructor, finishes recording if that hasn't been done.
+    ~StepRecorder();
+
+    //! Post a record. Producer only.
+    void post(const StepRecord &record);
+
+    //! Hand over all remaining records and wait for the recorder to process
+    //! them and exit. Producer only.
+    void finish();
+
+  protected:
+
+    //! Recorder thread loop.
+    void run() override;
+
+  private:
+
+    //! Move as much of the overflow buffer into the queue as fits.
+    void flushOverflow();
+
+    //! Apply a record to the replica grid or solve collection. Consumer only.
+    void apply(const StepRecord &record);
+
+    SpscQueue<StepRecord> queue;          //!< Records from the router.
+    QList<StepRecord> overflow;           //!< Records that didn't fit into the queue.
+    std::atomic<bool> stopping{false};    //!< Set once no more records are posted.
+    SolveCollection *solve_col;           //!< Where steps are written to.
+    StepLogWriter *step_log;              //!< Where steps are written to instead.
+    SolveSteps *curr_steps=nullptr;       //!< Current solve steps.
+    QScopedPointer<sp::Grid> replica;     //!< Grid rebuilt from the records.
+  };
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+// @file:     trace_writer.cc
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Implementation of the TraceWriter class.
+
+#include <QJsonDocument>
+#include <QDebug>
+#include "trace_writer.h"
+
+using namespace rt;
+
+TraceWriter::~TraceWriter()
+{
+  if (file.isOpen()) {
+    finish();
+  }
+}
+
+bool TraceWriter::open(const QString &path)
+{
+  file.setFileName(path);
+  if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+    qDebug() << QObject::tr("Unable to open %1 for writing.").arg(path);
+    ok = false;
+    return false;
+  }
+  ok = true;
+  first_event = true;
+  buf.clear();
+  buf.reserve(buf_limit + 256);
+  buf.append("[\n");
+  clock.start();
+
+  // name the process and thread that events are attributed to
+  QJsonObject event;
+  event["name"] = QString("process_name");
+  event["ph"] = QString("M");
+  event["pid"] = 1;
+  event["tid"] = 1;
+  event["args"] = QJsonObject{{"name", QString("pinrouter")}};
+  buf.append(QJsonDocument(event).toJson(QJsonDocument::Compact));
+  first_event = false;
+  return true;
+}
+
+void TraceWriter::begin(const QString &name, const QString &cat,
+    const QJsonObject &args)
+{
+  append("B", name, cat, args);
+}
+
+void TraceWriter::end(const QString &name, const QString &cat,
+    const QJsonObject &args)
+{
+  append("E", name, cat, args);
+}
+
+bool TraceWriter::finish()
+{
+  if (!file.isOpen()) {
+    return false;
+  }
+  buf.append("\n]\n");
+  flushBuffer();
+  file.close();
+  return ok;
+}
+
+void TraceWriter::append(const char *phase, const QString &name,
+    const QString &cat, const QJsonObject &args)
+{
+  if (!file.isOpen()) {
+    return;
+  }
+  QJsonObject event;
+  event["name"] = name;
+  event["cat"] = cat;
+  event["ph"] = QLatin1String(phase);
+  event["ts"] = clock.nsecsElapsed() / 1000.0;  // in microseconds
+  event["pid"] = 1;
+  event["tid"] = 1;
+  if (!args.isEmpty()) {
+    event["args"] = args;
+  }
+  if (!first_event) {
+    buf.append(",\n");
+  }
+  first_event = false;
+  buf.append(QJsonDocument(event).toJson(QJsonDocument::Compact));
+  if (buf.size() >= buf_limit) {
+    flushBuffer();
+  }
+}
+
+void TraceWriter::flushBuffer()
+{
+  if (!buf.isEmpty()) {
+    ok &= (file.write(buf) == buf.size()) && file.flush();
+    buf.clear();
+  }
+}
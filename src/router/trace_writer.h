@@ -0,0 +1,119 @@
+// @file:     trace_writer.h
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     Streaming writer of Chrome trace-event files of router phases.
+
+#ifndef _RT_TRACE_WRITER_H_
+#define _RT_TRACE_WRITER_H_
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+
+namespace rt {
+
+  //! Streams duration events in the Chrome trace-event JSON array format to a
+  //! file, to be loaded into chrome://tracing or Perfetto. Events are
+  //! serialized into a buffer that is written out whenever it reaches the
+  //! buffer size, so memory use stays bounded however long the run. Files of
+  //! runs that were cut short (without the closing bracket) can still be
+  //! loaded by both viewers.
+  class TraceWriter
+  {
+  public:
+
+    //! Constructor taking the size in bytes at which the buffer is written
+    //! out.
+    TraceWriter(int buffer_size=1<<16) : buf_limit(buffer_size) {};
+
+    //! Destructor, finishes the file if that hasn't been done.
+    ~TraceWriter();
+
+    //! Open the file at the provided path and start the clock. Return false
+    //! if the file can't be opened.
+    bool open(const QString &path);
+
+    //! Return whether a file is open.
+    bool isOpen() const {return file.isOpen();}
+
+    //! Begin a duration event of the provided name and category. Events must
+    //! be ended in reverse order of beginning.
+    void begin(const QString &name, const QString &cat,
+        const QJsonObject &args=QJsonObject());
+
+    //! End the most recent duration event of the provided name and category.
+    //! Viewers merge the provided args into those of the begin event.
+    void end(const QString &name, const QString &cat,
+        const QJsonObject &args=QJsonObject());
+
+    //! Close the event array and the file. Return whether everything has been
+    //! written successfully.
+    bool finish();
+
+    //! Return the number of serialized bytes not yet written to the file.
+    int bufferedBytes() const {return buf.size();}
+
+  private:
+
+    //! Serialize an event of the provided phase into the buffer, writing the
+    //! buffer out if it's full.
+    void append(const char *phase, const QString &name, const QString &cat,
+        const QJsonObject &args);
+
+    //! Write out the buffer.
+    void flushBuffer();
+
+    // Private variables
+    int buf_limit;          //!< Buffer size at which it's written out.
+    QFile file;             //!< The file being written.
+    QByteArray buf;         //!< Serialized events not yet written.
+    QElapsedTimer clock;    //!< Clock that timestamps are taken from.
+    bool first_event=true;  //!< Whether no event has been serialized yet.
+    bool ok=false;          //!< Whether all writes have succeeded.
+  };
+
+  //! Emits a duration event spanning the lifetime of this object, if a trace
+  //! writer is provided. Arguments added along the way are attached when the
+  //! event ends. Without a writer, nothing but a null check is done.
+  class TraceScope
+  {
+  public:
+
+    //! Constructor beginning the event on the provided writer (if any).
+    TraceScope(TraceWriter *trace, const char *name, const char *cat)
+      : trace(trace), name(name), cat(cat)
+    {
+      if (trace != nullptr) {
+        trace->begin(QLatin1String(name), QLatin1String(cat));
+      }
+    }
+
+    //! Destructor ending the event with the added arguments.
+    ~TraceScope()
+    {
+      if (trace != nullptr) {
+        trace->end(QLatin1String(name), QLatin1String(cat), args);
+      }
+    }
+
+    //! Add an argument to the event.
+    void arg(const char *key, const QJsonValue &value)
+    {
+      if (trace != nullptr) {
+        args[QString::fromLatin1(key)] = value;
+      }
+    }
+
+  private:
+
+    TraceWriter *trace;   //!< Writer to emit to, nullptr for none.
+    const char *name;     //!< Event name.
+    const char *cat;      //!< Event category.
+    QJsonObject args;     //!< Arguments attached when the event ends.
+  };
+
+}
+
+#endif
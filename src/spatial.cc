@@ -6,6 +6,9 @@
 // @desc:     Implementation of spatial classes.
 
 #include <QDebug>
+#include <QHash>
+#include <algorithm>
+#include <limits>
 #include "spatial.h"
 
 using namespace sp;
@@ -29,19 +32,180 @@ bool Coord::isWithinBounds(int x_max, int y_max) const
   return (!is_blank) && (x >= 0 && x < x_max && y >=0 && y < y_max);
 }
 
-Grid::Grid(int dim_x, int dim_y, const QList<Coord> &obs_coords, 
+// Segment class implementations
+
+Coord Segment::cellAt(int i) const
+{
+  switch (dir) {
+    case PosX:
+      return Coord(start.x+i, start.y);
+    case NegX:
+      return Coord(start.x-i, start.y);
+    case PosY:
+      return Coord(start.x, start.y+i);
+    case NegY:
+    default:
+      return Coord(start.x, start.y-i);
+  }
+}
+
+QVector<Segment> Segment::encode(const QList<Coord> &cells)
+{
+  QVector<Segment> segments;
+  for (const Coord &cell : cells) {
+    if (!segments.isEmpty()) {
+      Segment &seg = segments.last();
+      if (seg.length == 1) {
+        // a single cell segment can extend in any direction
+        Coord prev = seg.start;
+        Direction dir = PosX;
+        bool adjacent = true;
+        if (cell == prev.right()) {
+          dir = PosX;
+        } else if (cell == prev.left()) {
+          dir = NegX;
+        } else if (cell == prev.below()) {
+          dir = PosY;
+        } else if (cell == prev.above()) {
+          dir = NegY;
+        } else {
+          adjacent = false;
+        }
+        if (adjacent) {
+          seg.dir = dir;
+          seg.length = 2;
+          continue;
+        }
+      } else if (cell == seg.cellAt(seg.length)) {
+        // continues in the same direction
+        seg.length++;
+        continue;
+      }
+    }
+    segments.append(Segment(cell, PosX, 1));
+  }
+  return segments;
+}
+
+QList<Coord> Segment::decode(const QVector<Segment> &segments)
+{
+  QList<Coord> cells;
+  for (const Segment &seg : segments) {
+    for (int i=0; i<seg.length; i++) {
+      cells.append(seg.cellAt(i));
+    }
+  }
+  return cells;
+}
+
+// Connection class implementations
+
+void Connection::setSegments(const PinPair &t_pin_pair, 
+    const QVector<Segment> &t_segs, int t_pin_set_id)
+{
+  pin_pair = t_pin_pair;
+  pin_set_id = t_pin_set_id;
+  segs = t_segs;
+  cell_count = 0;
+  for (int i=segs.size()-1; i>=0; i--) {
+    if (segs[i].length <= 0) {
+      // the cell iterator can't step over empty segments
+      segs.remove(i);
+    } else {
+      cell_count += segs[i].length;
+    }
+  }
+}
+
+// ConnectionPool class implementations
+
+ConnectionPool::~ConnectionPool()
+{
+  for (Connection *block : blocks) {
+    delete[] block;
+  }
+}
+
+Connection *ConnectionPool::create(const PinPair &pin_pair,
+    const QList<Coord> &coords, int pin_set_id)
+{
+  Connection *conn = take();
+  conn->setRoutedCells(pin_pair, coords, pin_set_id);
+  return conn;
+}
+
+Connection *ConnectionPool::create(const PinPair &pin_pair,
+    const QVector<Segment> &segs, int pin_set_id)
+{
+  Connection *conn = take();
+  conn->setSegments(pin_pair, segs, pin_set_id);
+  return conn;
+}
+
+Connection *ConnectionPool::create(const Connection &other)
+{
+  Connection *conn = take();
+  *conn = other;
+  return conn;
+}
+
+void ConnectionPool::release(Connection *conn)
+{
+  *conn = Connection();
+  free_list.append(conn);
+}
+
+void ConnectionPool::releaseAll()
+{
+  free_list.clear();
+  for (Connection *block : blocks) {
+    for (int i=0; i<block_size; i++) {
+      block[i] = Connection();
+      free_list.append(block + i);
+    }
+  }
+}
+
+Connection *ConnectionPool::take()
+{
+  if (free_list.isEmpty()) {
+    Connection *block = new Connection[block_size];
+    blocks.append(block);
+    // make room for every slot so that releasing never reallocates
+    free_list.reserve(blocks.size() * block_size);
+    for (int i=block_size-1; i>=0; i--) {
+      free_list.append(block + i);
+    }
+  }
+  return free_list.takeLast();
+}
+
+// ChangedCells struct implementations
+
+void ChangedCells::merge(const ChangedCells &later)
+{
+  if (all || later.all) {
+    all = true;
+    coords.clear();
+  } else {
+    coords += later.coords;
+  }
+}
+
+// Grid class implementations
+
+Grid::Grid(int dim_x, int dim_y, const QVector<Coord> &obs_coords, 
     const QList<PinSet> &pin_sets)
   : dim_x(dim_x), dim_y(dim_y)
 {
-  // initiate the cell grid
-  cell_grid.resize(dim_x);
+  // initiate the cell grid with blank cells
+  cells.resize(dim_x * dim_y);
   for (int i=0; i<dim_x; i++) {
-    cell_grid[i].resize(dim_y);
     for (int j=0; j<dim_y; j++) {
-      // init grid cell to blank cell
-      cell_grid[i][j] = new Cell(Coord(i,j), BlankCell);
+      cells[i*dim_y+j].setCoord(Coord(i,j));
     }
   }
+  type_counts[BlankCell] = cells.size();
 
   // set cell properties
   setObsCells(obs_coords);
@@ -51,6 +215,7 @@ Grid::Grid(int dim_x, int dim_y, const QList<Coord> &obs_coords,
 }
 
 Grid::Grid(Grid *other)
+  : dim_x(0), dim_y(0)
 {
   copyState(other);
 }
@@ -62,42 +227,81 @@ Grid::~Grid()
 
 void Grid::copyState(Grid *other)
 {
+  if (other == this) {
+    return;
+  }
   dim_x = other->dim_x;
   dim_y = other->dim_y;
   pin_sets = other->pin_sets;
-  cell_grid.clear();
-  cell_grid.resize(other->cell_grid.size());
-  for (int i=0; i<cell_grid.size(); i++) {
-    cell_grid[i].resize(other->cell_grid[i].size());
-    for (int j=0; j<cell_grid[i].size(); j++) {
-      cell_grid[i][j] = new Cell(*other->cell_grid[i][j]);
-    }
+  // copy cells into the existing storage if the size matches
+  cells.resize(other->cells.size());
+  std::copy(other->cells.constBegin(), other->cells.constEnd(), cells.begin());
+  if (!other->working_vals.isEmpty()) {
+    working_vals.resize(other->working_vals.size());
+    std::copy(other->working_vals.constBegin(), other->working_vals.constEnd(),
+        working_vals.begin());
+  } else if (!working_vals.isEmpty()) {
+    working_vals.fill(-1, cells.size());
   }
+  // search bookkeeping isn't part of the grid state
+  if (!search_nodes.isEmpty()) {
+    search_nodes.fill(SearchNode(), cells.size());
+  }
+
+  // roll back all connections at once, then recreate the other grid's
   conn.clear();
-  QMap<sp::Connection*,sp::Connection*> old_to_new_ptr;
-  for (auto it=other->conn.begin(); it!=other->conn.end(); it++) {
+  conn_pool.releaseAll();
+  QHash<sp::Connection*,sp::Connection*> old_to_new_ptr;
+  for (auto it=other->conn.constBegin(); it!=other->conn.constEnd(); it++) {
     auto find_ptr = old_to_new_ptr.constFind(it.value());
     if (find_ptr != old_to_new_ptr.constEnd()) {
       // re-insert the pointer if it had been created
       conn.insert(it.key(), find_ptr.value());
     } else {
       // create the pointer and keep track of it
-      sp::Connection *nconn = new sp::Connection(it.value());
+      sp::Connection *nconn = conn_pool.create(*it.value());
       old_to_new_ptr[it.value()] = nconn;
       conn.insert(it.key(), nconn);
     }
   }
+
+  // statistics carry over, segment components are rebuilt when needed
+  std::copy(other->type_counts, other->type_counts + BlankCell + 1, type_counts);
+  net_wirelength = other->net_wirelength;
+  total_wirelength = other->total_wirelength;
+  segment_count = other->segment_count;
+  net_segments = other->net_segments;
+  segments_valid = other->segments_valid;
+  seg_comps_valid = false;
+  net_dirty.fill(false, net_segments.size());
+  dirty_nets.clear();
+  dirty_cells.clear();
+  markAllChanged();
 }
 
-void Grid::setObsCells(const QList<Coord> &obs_coords, bool check_clash)
+void Grid::setObsCells(const QVector<Coord> &obs_coords, bool check_clash)
 {
-  for (Coord coord : obs_coords) {
+  for (const Coord &coord : obs_coords) {
     Cell *cell = cellAt(coord);
     if (check_clash && cell->getType() != BlankCell) {
       qWarning() << QObject::tr("Potential cell clash detected at (%1, %2)")
         .arg(coord.x).arg(coord.y);
     }
-    cellAt(coord)->setType(ObsCell);
+    setCellType(coord, ObsCell);
+  }
+}
+
+void Grid::setObsSpans(const QVector<Segment> &obs_spans)
+{
+  for (const Segment &span : obs_spans) {
+    if (span.length <= 0 || !isWithinBounds(span.start) || !isWithinBounds(span.end())) {
+      qWarning() << QObject::tr("Skipping out of bound obstruction span at %1")
+        .arg(span.start.str());
+      continue;
+    }
+    for (int i=0; i<span.length; i++) {
+      setCellType(span.cellAt(i), ObsCell);
+    }
   }
 }
 
@@ -114,8 +318,7 @@ void Grid::setPinCells(const QList<Coord> &pin_coords, int pin_set_id,
       qWarning() << QObject::tr("Potential cell clash detected at (%1, %2)")
         .arg(coord.x).arg(coord.y);
     }
-    cell->setType(PinCell);
-    cell->setPinSetId(pin_set_id);
+    setCellType(coord, PinCell, pin_set_id);
   }
 }
 
@@ -139,16 +342,62 @@ QList<Coord> Grid::neighborCoordsOf(const Coord &coord)
   return neighbors;
 }
 
+void Grid::setWorkingValue(const Coord &coord, int val)
+{
+  if (working_vals.isEmpty()) {
+    working_vals.fill(-1, cells.size());
+  }
+  working_vals[cellIndex(coord)] = val;
+}
+
+SearchNode &Grid::searchNode(const Coord &coord)
+{
+  if (search_nodes.size() != cells.size()) {
+    search_nodes.fill(SearchNode(), cells.size());
+  }
+  return search_nodes[cellIndex(coord)];
+}
+
 void Grid::clearWorkingValues()
 {
-  for (auto x_cells : cell_grid) {
-    for (Cell *cell : x_cells) {
-      cell->resetWorkingValue();
-      cell->extraProps().clear();
+  // search bookkeeping is only ever set along with a working value
+  bool clear_nodes = search_nodes.size() == working_vals.size();
+  for (int i=0; i<working_vals.size(); i++) {
+    if (working_vals[i] != -1) {
+      markChanged(cells[i].getCoord());
+      working_vals[i] = -1;
+      if (clear_nodes) {
+        search_nodes[i] = SearchNode();
+      }
     }
   }
 }
 
+qint64 Grid::maxCells()
+{
+  // Qt containers are limited to INT_MAX bytes including their header
+  const qint64 max_bytes = std::numeric_limits<int>::max() - 64;
+  return max_bytes / (qint64)qMax(sizeof(Cell), sizeof(SearchNode));
+}
+
+void Grid::setChangeTracking(bool track)
+{
+  track_changes = track;
+  changed_cells = ChangedCells();
+  markAllChanged();
+}
+
+ChangedCells Grid::takeChangedCells()
+{
+  ChangedCells taken;
+  if (!track_changes) {
+    taken.all = true;
+    return taken;
+  }
+  std::swap(taken, changed_cells);
+  return taken;
+}
+
 bool Grid::isWithinBounds(const Coord &coord)
 {
   return (coord.x >= 0 && coord.y >= 0 && coord.x < dim_x && coord.y < dim_y);
@@ -163,40 +412,61 @@ bool Grid::routeExistsBetweenPins(const Coord &a, const Coord &b,
         "to the same wire.");
   }
 
-  // operate on a copy of the grid
-  Grid grid_cp(this);
-  grid_cp.clearWorkingValues();
-  grid_cp(a)->setWorkingValue(1); // prevent coord a from being revisited
-
-  // recursively look at neighboring RoutedCells/Pins starting from point a
-  // until point b is found.
-  std::function<bool(const Coord &curr_coord)> findB;
-  findB = [this, &a, &b, &grid_cp, &pin_set_id, route, &findB](const Coord &curr_coord)->bool
-  {
-    if (curr_coord == b) {
-      return true;
-    } else {
-      QList<Coord> neighbors = neighborCoordsOf(curr_coord);
-      for (Coord neighbor : neighbors) {
-        Cell *nc = grid_cp(neighbor);
-        CellType type = nc->getType();
-        if (nc->workingValue() < 0 && nc->pinSetId() == pin_set_id
-            && (type == RoutedCell || type == PinCell)) {
-          nc->setWorkingValue(1);
-          bool success = findB(neighbor);
-          if (success) {
-            if (route != nullptr && a != curr_coord) {
-              route->append(curr_coord);
-            }
-            return true;
-          }
+  // depth-first search through RoutedCells/Pins of the same pin set from a 
+  // until b is found, marking visited cells with a stamp instead of copying
+  // the grid
+  quint32 stamp = newVisitStamp();
+  int a_i = cellIndex(a);
+  int b_i = cellIndex(b);
+  visit_stack.clear();
+  visit_stack.append(a_i);
+  visit_stamps[a_i] = stamp;
+  visit_from[a_i] = -1;
+  bool found = (a_i == b_i);
+  while (!found && !visit_stack.isEmpty()) {
+    int curr_i = visit_stack.takeLast();
+    Coord curr = cells[curr_i].getCoord();
+    for (const Coord &neighbor : {curr.above(), curr.right(), curr.below(), curr.left()}) {
+      if (!isWithinBounds(neighbor)) {
+        continue;
+      }
+      int n_i = cellIndex(neighbor);
+      const Cell &nc = cells[n_i];
+      if (visit_stamps[n_i] != stamp && nc.pinSetId() == pin_set_id
+          && (nc.getType() == RoutedCell || nc.getType() == PinCell)) {
+        visit_stamps[n_i] = stamp;
+        visit_from[n_i] = curr_i;
+        if (n_i == b_i) {
+          found = true;
+          break;
         }
+        visit_stack.append(n_i);
       }
     }
-    return false;
-  };
+  }
+
+  // the route excludes a and b and runs from b back to a
+  if (found && route != nullptr) {
+    for (int i=visit_from[b_i]; i>=0 && i!=a_i; i=visit_from[i]) {
+      route->append(cells[i].getCoord());
+    }
+  }
+  return found;
+}
 
-  return findB(a);
+quint32 Grid::newVisitStamp()
+{
+  if (visit_stamps.size() != cells.size()) {
+    visit_stamps.fill(0, cells.size());
+    visit_from.resize(cells.size());
+    visit_stamp = 0;
+  }
+  if (++visit_stamp == 0) {
+    // the stamp wrapped around, forget all previous visits
+    visit_stamps.fill(0);
+    visit_stamp = 1;
+  }
+  return visit_stamp;
 }
 
 QList<Coord> Grid::connectedPins(const Coord &coord)
@@ -257,49 +527,269 @@ bool Grid::allPinsRouted()
 
 int Grid::countSegments()
 {
-  int segments=0;
-  QSet<Coord> visited;
+  if (!segments_valid && seg_comps_valid) {
+    recountDirtyNets();
+  } else if (!segments_valid) {
+    recountSegments();
+  }
+  return segment_count;
+}
 
-  for (const PinSet &pin_set : pin_sets.values()) {
-    for (const Coord &pin : pin_set) {
-      if (!visited.contains(pin)) {
-        QList<Coord> cpins = connectedPins(pin);
-        segments += std::max(cpins.size()-1, 0);
-        for (const Coord &cpin : cpins) {
-          visited.insert(cpin);
-        }
+int Grid::countCells(const QSet<CellType> &types) const
+{
+  if (types.isEmpty()) {
+    return dim_x * dim_y;
+  }
+  int t_count = 0;
+  for (CellType type : types) {
+    t_count += type_counts[type];
+  }
+  return t_count;
+}
+
+void Grid::setCellType(const Coord &coord, CellType type, int pin_set_id)
+{
+  if (!isWithinBounds(coord)) {
+    return;
+  }
+  int i = cellIndex(coord);
+  Cell &cell = cells[i];
+  if (cell.getType() == type && cell.pinSetId() == pin_set_id) {
+    return;
+  }
+
+  // leaving a net, components can't be split so the net's segments are
+  // recounted later from the neighbors left behind
+  if (isNetCell(cell)) {
+    int net = cell.pinSetId();
+    int neighbors[4];
+    int neighbor_count = netNeighbors(coord, net, neighbors);
+    net_wirelength[net] -= neighbor_count;
+    total_wirelength -= neighbor_count;
+    if (seg_comps_valid) {
+      if (!net_dirty[net]) {
+        net_dirty[net] = true;
+        dirty_nets.append(net);
+      }
+      for (int n=0; n<neighbor_count; n++) {
+        dirty_cells.append(neighbors[n]);
       }
     }
+    segments_valid = false;
   }
+  type_counts[cell.getType()]--;
+  type_counts[type]++;
+  cell.setType(type);
+  cell.setPinSetId(pin_set_id);
+
+  // joining a net
+  if (isNetCell(cell)) {
+    int neighbors[4];
+    int neighbor_count = netNeighbors(coord, pin_set_id, neighbors);
+    if (net_wirelength.size() <= pin_set_id) {
+      net_wirelength.resize(pin_set_id + 1);
+    }
+    if (net_segments.size() <= pin_set_id) {
+      net_segments.resize(pin_set_id + 1);
+      net_dirty.resize(pin_set_id + 1);
+    }
+    net_wirelength[pin_set_id] += neighbor_count;
+    total_wirelength += neighbor_count;
+    if (!seg_comps_valid) {
+      segments_valid = false;
+    } else if (net_dirty[pin_set_id]) {
+      // joined when the net's components are rebuilt
+      dirty_cells.append(i);
+    } else {
+      seg_parent[i] = i;
+      seg_pins[i] = (type == PinCell) ? 1 : 0;
+      for (int n=0; n<neighbor_count; n++) {
+        joinSegments(i, neighbors[n]);
+      }
+    }
+  }
+}
 
-  return segments;
+int Grid::netNeighbors(const Coord &coord, int pin_set_id, int *indices) const
+{
+  int count = 0;
+  const Coord ncoords[4] = {coord.above(), coord.right(), coord.below(), coord.left()};
+  for (const Coord &ncoord : ncoords) {
+    if (ncoord.x < 0 || ncoord.y < 0 || ncoord.x >= dim_x || ncoord.y >= dim_y) {
+      continue;
+    }
+    const Cell &ncell = cells[cellIndex(ncoord)];
+    if (isNetCell(ncell) && ncell.pinSetId() == pin_set_id) {
+      if (indices != nullptr) {
+        indices[count] = cellIndex(ncoord);
+      }
+      count++;
+    }
+  }
+  return count;
 }
 
-int Grid::countCells(const QSet<CellType> &types)
+void Grid::recountSegments()
 {
-  if (types.isEmpty()) {
-    return dim_x * dim_y;
+  seg_parent.resize(cells.size());
+  seg_pins.resize(cells.size());
+  int net_count = net_wirelength.size();
+  for (int i=0; i<cells.size(); i++) {
+    seg_parent[i] = isNetCell(cells[i]) ? i : -1;
+    seg_pins[i] = (cells[i].getType() == PinCell) ? 1 : 0;
+    if (seg_parent[i] >= 0) {
+      net_count = qMax(net_count, cells[i].pinSetId() + 1);
+    }
   }
-  int t_count = 0;
-  for (QVector<Cell*> cells : cell_grid) {
-    for (Cell *cell : cells) {
-      if (types.contains(cell->getType())) {
-        t_count++;
+  net_segments.fill(0, net_count);
+  net_dirty.fill(false, net_count);
+  dirty_nets.clear();
+  dirty_cells.clear();
+  // every adjacent pair of cells of the same net is joined once
+  segment_count = 0;
+  for (int x=0; x<dim_x; x++) {
+    for (int y=0; y<dim_y; y++) {
+      int i = x * dim_y + y;
+      if (seg_parent[i] < 0) {
+        continue;
+      }
+      int pin_set_id = cells[i].pinSetId();
+      if (x > 0 && seg_parent[i-dim_y] >= 0 && cells[i-dim_y].pinSetId() == pin_set_id) {
+        joinSegments(i, i-dim_y);
+      }
+      if (y > 0 && seg_parent[i-1] >= 0 && cells[i-1].pinSetId() == pin_set_id) {
+        joinSegments(i, i-1);
       }
     }
   }
-  return t_count;
+  segments_valid = true;
+  seg_comps_valid = true;
 }
 
-void Grid::clearGrid()
+void Grid::recountDirtyNets()
 {
-  // destroy all cells in the grid
-  for (auto x_cells : cell_grid) {
-    x_cells.clear();
+  for (int net : dirty_nets) {
+    if (!pin_sets.contains(net)) {
+      // without its pins the net's segments can't be found
+      recountSegments();
+      return;
+    }
+  }
+  for (int net : dirty_nets) {
+    segment_count -= net_segments[net];
+    net_segments[net] = 0;
+  }
+
+  // flood the dirty nets from their pins and from the cells next to where
+  // they changed, which reaches every component with stale links. Cells are
+  // reset when first reached and joined with their neighbors once taken.
+  quint32 stamp = newVisitStamp();
+  visit_stack.clear();
+  auto reach = [this, stamp](int i)
+  {
+    const Cell &cell = cells[i];
+    if (visit_stamps[i] != stamp && isNetCell(cell)
+        && cell.pinSetId() < net_dirty.size() && net_dirty[cell.pinSetId()]) {
+      visit_stamps[i] = stamp;
+      seg_parent[i] = i;
+      seg_pins[i] = (cell.getType() == PinCell) ? 1 : 0;
+      visit_stack.append(i);
+    }
+  };
+  for (int net : dirty_nets) {
+    for (const Coord &pin : pin_sets.value(net)) {
+      if (isWithinBounds(pin)) {
+        reach(cellIndex(pin));
+      }
+    }
+  }
+  for (int i : dirty_cells) {
+    reach(i);
   }
-  cell_grid.clear();
+  while (!visit_stack.isEmpty()) {
+    int curr_i = visit_stack.takeLast();
+    int neighbors[4];
+    int neighbor_count = netNeighbors(cells[curr_i].getCoord(),
+        cells[curr_i].pinSetId(), neighbors);
+    for (int n=0; n<neighbor_count; n++) {
+      reach(neighbors[n]);
+      joinSegments(curr_i, neighbors[n]);
+    }
+  }
+
+  for (int net : dirty_nets) {
+    net_dirty[net] = false;
+  }
+  dirty_nets.clear();
+  dirty_cells.clear();
+  segments_valid = true;
+}
+
+int Grid::segmentRoot(int i)
+{
+  while (seg_parent[i] != i) {
+    // path halving
+    seg_parent[i] = seg_parent[seg_parent[i]];
+    i = seg_parent[i];
+  }
+  return i;
+}
+
+void Grid::joinSegments(int a, int b)
+{
+  int root_a = segmentRoot(a);
+  int root_b = segmentRoot(b);
+  if (root_a == root_b) {
+    return;
+  }
+  // joining two groups that both contain pins connects one more pin pair
+  if (seg_pins[root_a] > 0 && seg_pins[root_b] > 0) {
+    segment_count++;
+    net_segments[cells[a].pinSetId()]++;
+  }
+  seg_parent[root_b] = root_a;
+  seg_pins[root_a] += seg_pins[root_b];
+}
+
+qint64 Grid::memoryFootprint() const
+{
+  // approximate a QMultiMap node as the key, value and three pointers
+  const qint64 conn_node_bytes = sizeof(Coord) + sizeof(Connection*) + 3 * sizeof(void*);
+  return sizeof(Grid)
+    + (qint64)cells.capacity() * sizeof(Cell)
+    + (qint64)conn.size() * conn_node_bytes
+    + conn_pool.memoryFootprint()
+    + (qint64)visit_stamps.capacity() * sizeof(quint32)
+    + (qint64)(visit_from.capacity() + visit_stack.capacity()) * sizeof(int)
+    + (qint64)(seg_parent.capacity() + seg_pins.capacity()) * sizeof(int)
+    + (qint64)(net_segments.capacity() + dirty_nets.capacity()
+        + dirty_cells.capacity()) * sizeof(int)
+    + (qint64)net_dirty.capacity() * sizeof(bool)
+    + (qint64)working_vals.capacity() * sizeof(int)
+    + (qint64)search_nodes.capacity() * sizeof(SearchNode)
+    + (qint64)net_wirelength.capacity() * sizeof(qint64);
+}
+
+void Grid::clearGrid()
+{
+  // destroy all cells and connections in the grid
+  cells.clear();
+  working_vals.clear();
+  search_nodes.clear();
+  conn.clear();
+  conn_pool.releaseAll();
 
   dim_x = 0;
   dim_y = 0;
   pin_sets.clear();
+  std::fill(type_counts, type_counts + BlankCell + 1, 0);
+  net_wirelength.clear();
+  total_wirelength = 0;
+  segment_count = 0;
+  net_segments.clear();
+  segments_valid = false;
+  seg_comps_valid = false;
+  net_dirty.clear();
+  dirty_nets.clear();
+  dirty_cells.clear();
 }
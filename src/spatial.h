@@ -13,6 +13,7 @@
 #include <QVector>
 #include <QMap>
 #include <functional>
+#include <iterator>
 
 // spatial namespace
 namespace sp {
@@ -85,17 +86,103 @@ namespace sp {
     return (h1 < h2);
   }
 
+  //! A straight run of cells, starting at a coordinate and extending in one
+  //! of the four grid directions. Handy for compactly describing routes.
+  class Segment
+  {
+  public:
+    //! Direction that a segment extends to from its start.
+    enum Direction{PosX, NegX, PosY, NegY};
+
+    //! Constructor taking the start coordinate, direction and length in cells.
+    Segment(const Coord &start, Direction dir, int length)
+      : start(start), dir(dir), length(length) {};
+
+    //! Empty segment.
+    Segment() : dir(PosX), length(0) {};
+
+    //! Return the i-th cell of this segment (0 being the start).
+    Coord cellAt(int i) const;
+
+    //! Return the last cell of this segment.
+    Coord end() const {return cellAt(length-1);}
+
+    //! Encode an ordered list of cells into segments. Consecutive cells that
+    //! continue in the same direction are merged into one segment, cells that
+    //! aren't adjacent to their predecessor start a new segment.
+    static QVector<Segment> encode(const QList<Coord> &cells);
+
+    //! Decode segments back into the ordered list of cells.
+    static QList<Coord> decode(const QVector<Segment> &segments);
+
+    // Public variables:
+    Coord start;    //!< first cell of the segment
+    Direction dir;  //!< direction the segment extends to
+    int length;     //!< number of cells in the segment
+  };
+
   //! Declare PinSet as an alias that stores sets of pins to be connected
   using PinSet = QList<Coord>;
 
   //! Declare PinPair as an alias that stores pairs of pins (useful for hashing)
   using PinPair = QPair<sp::Coord, sp::Coord>;
 
-  //! Handy class for keeping track of routed wires.
+  //! Forward iterator over the cells of a list of segments, expanding each 
+  //! segment into its cells only as the iterator advances.
+  class SegmentCellIterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Coord;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Coord*;
+    using reference = Coord;
+
+    //! Constructor taking the segment to start from and the index of the 
+    //! cell within it. Segments must not be empty.
+    SegmentCellIterator(const Segment *seg=nullptr, int i=0) : seg(seg), i(i) {};
+
+    //! Return the current cell.
+    Coord operator*() const {return seg->cellAt(i);}
+
+    //! Advance to the next cell.
+    SegmentCellIterator &operator++()
+    {
+      if (++i >= seg->length) {
+        ++seg;
+        i = 0;
+      }
+      return *this;
+    }
+
+    //! Advance to the next cell, returning the current position.
+    SegmentCellIterator operator++(int)
+    {
+      SegmentCellIterator prev(*this);
+      ++(*this);
+      return prev;
+    }
+
+    //! Equality operators.
+    bool operator==(const SegmentCellIterator &o) const {return seg == o.seg && i == o.i;}
+    bool operator!=(const SegmentCellIterator &o) const {return !(*this == o);}
+
+  private:
+    const Segment *seg; //!< Current segment.
+    int i;              //!< Index of the current cell within the segment.
+  };
+
+  //! Handy class for keeping track of routed wires. Routed cells are stored
+  //! as run-length segments, so straight runs cost one entry regardless of
+  //! their length and copies of a connection share the segment data. Iterate
+  //! over a connection to visit its cells in order without expanding them.
   class Connection
   {
   public:
 
+    //! Cell iterator type.
+    using const_iterator = SegmentCellIterator;
+
     //! Empty constructor.
     Connection() : pin_set_id(-1) {};
 
@@ -105,141 +192,252 @@ namespace sp {
       setRoutedCells(t_pin_pair, coords, t_pin_set_id);
     }
 
+    //! Construct with provided segments and pin set ID.
+    Connection(PinPair t_pin_pair, const QVector<Segment> &segs, int t_pin_set_id)
+    {
+      setSegments(t_pin_pair, segs, t_pin_set_id);
+    }
+
     //! Copy constructor given a pointer to another conneciton.
     Connection(Connection *other) : pin_pair(other->pin_pair), 
-      pin_set_id(other->pin_set_id), routed_cells(other->routed_cells) {};
+      pin_set_id(other->pin_set_id), segs(other->segs),
+      cell_count(other->cell_count) {};
 
     //! Set the provided coordinates to belong to this connecction.
     void setRoutedCells(const PinPair &t_pin_pair, const QList<sp::Coord> &cells,
         int t_pin_set_id)
     {
-      pin_pair = t_pin_pair;
-      routed_cells = cells;
-      pin_set_id = t_pin_set_id;
+      setSegments(t_pin_pair, Segment::encode(cells), t_pin_set_id);
     }
 
+    //! Set the provided segments to belong to this connection. Empty segments
+    //! are dropped.
+    void setSegments(const PinPair &t_pin_pair, const QVector<Segment> &t_segs,
+        int t_pin_set_id);
+
     //! Return the pin set id
     int pinSetId() const {return pin_set_id;}
 
-    //! Return the routed cells that belong to this connection.
-    QList<sp::Coord> routedCells() const {return routed_cells;}
+    //! Return the routed cells that belong to this connection. This expands
+    //! every segment, iterate over the connection instead where possible.
+    QList<sp::Coord> routedCells() const {return Segment::decode(segs);}
+
+    //! Return the routed cells as run-length segments.
+    const QVector<Segment> &segments() const {return segs;}
+
+    //! Return the number of routed cells.
+    int cellCount() const {return cell_count;}
+
+    //! Return an iterator to the first routed cell.
+    const_iterator begin() const {return const_iterator(segs.constData());}
+
+    //! Return an iterator past the last routed cell.
+    const_iterator end() const {return const_iterator(segs.constData() + segs.size());}
 
     //! Return the pair of pins this route connects.
-    PinPair pinPair() {return pin_pair;}
+    PinPair pinPair() const {return pin_pair;}
 
     //! Return whether this is connection is empty or not.
-    bool isEmpty() {return routed_cells.isEmpty();}
+    bool isEmpty() const {return cell_count == 0;}
 
   private:
 
     // Private variables
     PinPair pin_pair;               //! The pair of pins that this connection is for
     int pin_set_id = -1;            //! Pin set ID
-    QList<sp::Coord> routed_cells;  //! A list of routed cells that belong to this connection
+    QVector<Segment> segs;          //! Routed cells of this connection as segments
+    int cell_count = 0;             //! Number of routed cells in segs
   };
 
-  //! A cell that belongs to a grid data structure.
+  //! A cell that belongs to a grid data structure. Cells are kept small
+  //! since grids store millions of them, working values and search 
+  //! bookkeeping are kept by the grid instead.
   class Cell
   {
   public:
     //! Constructor taking the coordinates.
     Cell(const Coord &coord, CellType type, int pin_set_id=-1)
-      : coord(coord), type(type), pin_set_id(pin_set_id) {};
-
-    //! Copy constructor
-    Cell(const Cell &other)
-      : coord(other.coord), type(other.type), pin_set_id(other.pin_set_id),
-        working_val(other.working_val), extra_props(other.extra_props) {};
+      : x(coord.x), y(coord.y), pin_set_id(pin_set_id), type(type) {};
 
     //! Empty constructor defaulting to blank cell.
-    Cell() : coord(), type(BlankCell) {};
+    Cell() : type(BlankCell) {};
 
-    //! Destructor.
-    ~Cell() {};
+    //! Return the coordinates of this cell.
+    Coord getCoord() const {return Coord(x, y);}
 
-    //! Set the coordinates of this cell.
-    void setCoord(const Coord &t_coord) {coord = t_coord;}
+    //! Get the type of this cell.
+    CellType getType() const {return (CellType)type;}
 
-    //! Return the coordinates of this cell.
-    Coord getCoord() const {return coord;}
+    //! Return the pin set ID.
+    int pinSetId() const {return pin_set_id;}
+
+  private:
+
+    // only the grid changes its cells, through Grid::setCellType() which
+    // keeps the grid's statistics up to date
+    friend class Grid;
+
+    //! Set the coordinates of this cell.
+    void setCoord(const Coord &t_coord) {x = t_coord.x; y = t_coord.y;}
 
     //! Set the type of this cell.
     void setType(CellType t_type) {type = t_type;}
 
-    //! Get the type of this cell.
-    CellType getType() const {return type;}
-
     //! Set the pin set ID of this cell (if this belongs to a pin set or a 
     //! routed wire).
     void setPinSetId(int t_id) {pin_set_id = t_id;}
 
-    //! Return the pin set ID.
-    int pinSetId() const {return pin_set_id;}
+    // Private variables
+    int x=-1;             //!< x coordinate of this cell.
+    int y=-1;             //!< y coordinate of this cell.
+    int pin_set_id=-1;    //!< The pin set this belongs if (if it's a pin). Not a pin if -1.
+    quint8 type;          //!< The CellType of this cell.
+  };
 
-    //! Set the working value associated with this cell (intended for storing 
-    //! misc routing information when it's in progress).
-    void setWorkingValue(int val) {working_val = val;}
+  //! Bookkeeping of a route search for one cell, kept by the grid in a flat
+  //! array next to the working values.
+  struct SearchNode
+  {
+    Coord from;             //!< Cell that the search reached this cell from.
+    int d_from_source=0;    //!< Cost of the path from the source.
+    int ripped_conns=0;     //!< Connections that the path rips.
+  };
 
-    //! Reset the working value to some default invalid value (-1).
-    void resetWorkingValue() {working_val = -1;}
+  //! Pool of Connection objects owned by a Grid. Connections are allocated
+  //! in blocks whose addresses never change; released connections go back to
+  //! a free list and are reused, and all of them can be released at once
+  //! (e.g. when a grid is rolled back) without giving any memory back.
+  class ConnectionPool
+  {
+  public:
 
-    //! Return the working value.
-    int workingValue() const {return working_val;}
+    //! Empty constructor.
+    ConnectionPool() {};
 
-    //! Return a pointer to the extra_props map (intended for routing algorithms
-    //! to store extra properties.)
-    QMap<QString, QVariant> &extraProps() {return extra_props;}
+    //! Destructor, frees all blocks.
+    ~ConnectionPool();
+
+    //! Return a connection with the provided properties.
+    Connection *create(const PinPair &pin_pair, const QList<Coord> &coords,
+        int pin_set_id);
+
+    //! Return a connection with the provided properties.
+    Connection *create(const PinPair &pin_pair, const QVector<Segment> &segs,
+        int pin_set_id);
+
+    //! Return a copy of the provided connection.
+    Connection *create(const Connection &other);
+
+    //! Return a connection to the pool.
+    void release(Connection *conn);
+
+    //! Return all connections to the pool.
+    void releaseAll();
+
+    //! Return the number of blocks allocated so far.
+    int blockCount() const {return blocks.size();}
+
+    //! Return the memory allocated for connections in bytes.
+    qint64 memoryFootprint() const
+    {
+      return (qint64)blocks.size() * block_size * sizeof(Connection)
+        + (qint64)free_list.capacity() * sizeof(Connection*);
+    }
+
+    //! Return the number of connections in use.
+    int inUse() const {return blocks.size() * block_size - free_list.size();}
 
   private:
 
-    // Private variables
-    Coord coord;          //!< Coordinates of this cell.
-    CellType type;        //!< The type of this cell.
-    int pin_set_id=-1;    //!< The pin set this belongs if (if it's a pin). Not a pin if -1.
-    int working_val=-1;   //!< Misc value intended for storing routing information.
-    QMap<QString, QVariant> extra_props;  //!< A map of extra properties.
+    //! Take a free slot, allocating a new block if there are none.
+    Connection *take();
+
+    // disable copies, the pool owns its blocks
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    static const int block_size = 256;  //!< Connections per block.
+    QVector<Connection*> blocks;        //!< Allocated blocks.
+    QVector<Connection*> free_list;     //!< Slots that aren't in use.
+  };
+
+  //! Cells of a grid that changed since they were last taken, see
+  //! Grid::setChangeTracking(). If all is set, the whole grid should be
+  //! considered changed and coords is left empty.
+  struct ChangedCells
+  {
+    //! Return whether nothing changed.
+    bool isEmpty() const {return !all && coords.isEmpty();}
+
+    //! Add changes that happened after the ones in this object.
+    void merge(const ChangedCells &later);
+
+    bool all=false;         //!< Whether the whole grid changed.
+    QVector<Coord> coords;  //!< Changed cells, may contain duplicates.
   };
 
-  //! A 2D grid containing the problem
+  //! A 2D grid containing the problem. Cells are stored contiguously and
+  //! connections come from a ConnectionPool owned by the grid, so copying or
+  //! rolling back a grid of the same size reuses the existing storage.
   class Grid
   {
   public:
     //! Constructor taking the grid size, obstructions and pins. This is meant
     //! to construct a grid that has not been solved at all.
-    Grid(int dim_x, int dim_y, const QList<Coord> &obs_coords={}, 
+    Grid(int dim_x, int dim_y, const QVector<Coord> &obs_coords={}, 
         const QList<PinSet> &pin_sets={});
 
     //! Copy constructor but clones the cell grid rather than using the same
     //! pointer.
     Grid(Grid *other);
 
+    // disable value copies, use the pointer constructor or copyState
+    Grid(const Grid &) = delete;
+    Grid &operator=(const Grid &) = delete;
+
     //! Constructor for an empty grid.
     Grid() : dim_x(0), dim_y(0) {};
 
     //! Destructor.
     ~Grid();
 
-    //! Set all grid cells to become identical to the given grid.
+    //! Set all grid cells to become identical to the given grid. Storage is
+    //! reused if this grid already has the same size.
     void copyState(Grid *other);
 
     //! Set the dimensions of the grid.
     void setGridSize(int x, int y) {dim_x = x; dim_y=y;}
 
+    //! Return the dimensions of the grid as a Coord(dim_x, dim_y).
+    Coord dimensions() const {return Coord(dim_x, dim_y);}
+
     //! Set obstruction cells.
-    void setObsCells(const QList<Coord> &obs_coords, bool check_clash=false);
+    void setObsCells(const QVector<Coord> &obs_coords, bool check_clash=false);
+
+    //! Set obstruction cells from spans of cells. Spans that don't fit in the
+    //! grid are skipped.
+    void setObsSpans(const QVector<Segment> &obs_spans);
 
     //! Set pin cells with the given pin set ID.
     void setPinCells(const QList<Coord> &pin_coords, int pin_set_id,
         bool check_clash=false);
 
     //! Index operator.
-    Cell *operator()(int x, int y) {return cell_grid.value(x).value(y);}
+    Cell *operator()(int x, int y) {return cellAt(Coord(x, y));}
 
     //! Return cell at the specified coordinate.
     Cell *operator()(const Coord &coord) {return cellAt(coord);}
 
-    //! Return cell at the specified coordinate.
-    Cell *cellAt(const Coord &coord) {return cell_grid.value(coord.x).value(coord.y);}
+    //! Return cell at the specified coordinate (nullptr if out of bounds).
+    Cell *cellAt(const Coord &coord)
+    {
+      return isWithinBounds(coord) ? cells.data() + cellIndex(coord) : nullptr;
+    }
+
+    //! Set the type and pin set ID of the cell at the specified coordinate,
+    //! keeping the cell counts, wire lengths and segment count of the grid up
+    //! to date.
+    void setCellType(const Coord &coord, CellType type, int pin_set_id=-1);
 
     //! Return a list cells that are neighbors of the provided coordinate,
     //! excluding out of bound coordinates.
@@ -249,16 +447,84 @@ namespace sp {
     //! excluding out of bound coordinates.
     QList<Coord> neighborCoordsOf(const Coord &coord);
 
-    //! Return a pointer to the cell grid.
-    QVector<QVector<Cell*>> *cellGrid() {return &cell_grid;}
+    //! Return an estimate of the memory owned by this grid in bytes. Segment
+    //! data shared with copies of the same connections is not counted.
+    qint64 memoryFootprint() const;
+
+    //! Return the contiguous cell storage, indexed by x * dim_y + y.
+    const QVector<Cell> &cellStorage() const {return cells;}
 
     //! Return a MultiMap that contains the connection attributes with 
     //! coordinates as keys.
     QMultiMap<sp::Coord,Connection*> *connMap() {return &conn;}
 
-    //! Clear all working values from all cells in the grid.
+    //! Create a connection owned by this grid. It isn't added to connMap().
+    Connection *newConnection(const PinPair &pin_pair, const QList<Coord> &coords,
+        int pin_set_id) {return conn_pool.create(pin_pair, coords, pin_set_id);}
+
+    //! Create a connection owned by this grid from run-length segments. It 
+    //! isn't added to connMap().
+    Connection *newConnection(const PinPair &pin_pair, const QVector<Segment> &segs,
+        int pin_set_id) {return conn_pool.create(pin_pair, segs, pin_set_id);}
+
+    //! Return a connection created by newConnection to the pool. It must 
+    //! already have been removed from connMap().
+    void releaseConnection(Connection *connection) {conn_pool.release(connection);}
+
+    //! Return the pool that connections of this grid are allocated from.
+    const ConnectionPool &connectionPool() const {return conn_pool;}
+
+    //! Return the working value of the cell at the specified in-bound 
+    //! coordinate (intended for storing misc routing information when it's
+    //! in progress), -1 if it has none.
+    int workingValue(const Coord &coord) const
+    {
+      return working_vals.isEmpty() ? -1 : working_vals[cellIndex(coord)];
+    }
+
+    //! Set the working value of the cell at the specified in-bound coordinate.
+    void setWorkingValue(const Coord &coord, int val);
+
+    //! Return the working values indexed like cellStorage(), empty if no
+    //! working value has been set since the grid was created.
+    const QVector<int> &workingValueStorage() const {return working_vals;}
+
+    //! Return the search bookkeeping of the cell at the specified in-bound 
+    //! coordinate. Reset along with the cell's working value.
+    SearchNode &searchNode(const Coord &coord);
+
+    //! Clear all working values and search bookkeeping from all cells in the
+    //! grid.
     void clearWorkingValues();
 
+    //! Return the largest number of cells that a grid can hold.
+    static qint64 maxCells();
+
+    //! Enable or disable tracking of changed cells. When enabled, the whole
+    //! grid counts as changed until takeChangedCells() is first called.
+    //! copyState() and clearWorkingValues() report their own changes, code 
+    //! that modifies cells directly has to call markChanged().
+    void setChangeTracking(bool track);
+
+    //! Return whether changed cells are being tracked.
+    bool tracksChanges() const {return track_changes;}
+
+    //! Report that the type, pin set or working value of a cell changed.
+    //! Does nothing unless changes are tracked.
+    void markChanged(const Coord &coord)
+    {
+      if (track_changes && !changed_cells.all) {
+        changed_cells.coords.append(coord);
+        if (changed_cells.coords.size() > cells.size()) {
+          markAllChanged();
+        }
+      }
+    }
+
+    //! Return the cells changed since the last call and start over. If 
+    //! changes aren't tracked, the whole grid is reported as changed.
+    ChangedCells takeChangedCells();
+
     //! Return whether the specified coordinates are within bounds.
     bool isWithinBounds(const Coord &);
 
@@ -278,12 +544,26 @@ namespace sp {
     //! exhaustively tracing all pin combinations of each pin set.
     bool allPinsRouted();
 
-    //! Return the count of connected segments.
+    //! Return the count of connected segments, i.e. for every group of pins
+    //! joined by cells of their net, the number of pins in it minus one. The
+    //! count is kept up to date as cells join nets; once cells have left a
+    //! net, only the segments of that net are recounted on the next call.
+    //! Copies recount the whole grid once cells leave a net.
     int countSegments();
 
     //! Count cells of the specified types. If the provided list is empty, 
     //! returns a count of all cells (just width * height).
-    int countCells(const QSet<CellType> &types);
+    int countCells(const QSet<CellType> &types) const;
+
+    //! Return the number of cells of the specified type.
+    int cellCount(CellType type) const {return type_counts[type];}
+
+    //! Return the wire length of the specified net in cell pitches, i.e. the
+    //! number of pairs of adjacent cells that both belong to it.
+    qint64 wirelength(int pin_set_id) const {return net_wirelength.value(pin_set_id, 0);}
+
+    //! Return the wire length summed over all nets.
+    qint64 wirelength() const {return total_wirelength;}
 
 
   private:
@@ -291,12 +571,79 @@ namespace sp {
     //! Clear all cells
     void clearGrid();
 
+    //! Return the index of the provided in-bound coordinate in cells.
+    int cellIndex(const Coord &coord) const {return coord.x * dim_y + coord.y;}
+
+    //! Return whether the provided cell is part of a net, i.e. is a pin or a
+    //! routed cell with a pin set ID.
+    static bool isNetCell(const Cell &cell)
+    {
+      return (cell.getType() == PinCell || cell.getType() == RoutedCell)
+        && cell.pinSetId() > -1;
+    }
+
+    //! Return the number of neighbors of the provided coordinate that belong
+    //! to the specified net. Neighbor indices are added to the list if given.
+    int netNeighbors(const Coord &coord, int pin_set_id, int *indices=nullptr) const;
+
+    //! Recount the segments from scratch and rebuild the segment components.
+    void recountSegments();
+
+    //! Rebuild the segment components of the nets that cells have left and
+    //! recount their segments.
+    void recountDirtyNets();
+
+    //! Return the root of the segment component containing the cell index.
+    int segmentRoot(int i);
+
+    //! Join the segment components of the provided cell indices.
+    void joinSegments(int a, int b);
+
+    //! Report that the whole grid changed if changes are tracked.
+    void markAllChanged()
+    {
+      changed_cells.all = track_changes;
+      changed_cells.coords.clear();
+    }
+
+    //! Start a new traversal with the visit stamps. Return the stamp that 
+    //! marks cells visited by this traversal.
+    quint32 newVisitStamp();
+
     // Private variables
     int dim_x;                              //!< x size.
     int dim_y;                              //!< y size.
-    QVector<QVector<Cell*>> cell_grid;      //!< Grid of cells.
+    QVector<Cell> cells;                    //!< Cells, indexed by x * dim_y + y.
     QMap<int,PinSet> pin_sets;              //!< Keep track of pin sets.
     QMultiMap<sp::Coord,Connection*> conn;  //!< Keep track of pin pair connections.
+    ConnectionPool conn_pool;               //!< Owns the connections in conn.
+
+    // running statistics, only cells changed through setCellType are counted
+    int type_counts[BlankCell+1] = {};      //!< Number of cells per type.
+    QVector<qint64> net_wirelength;         //!< Wire length per pin set ID.
+    qint64 total_wirelength=0;              //!< Wire length of all nets.
+    int segment_count=0;                    //!< Result of countSegments().
+    QVector<int> net_segments;              //!< Segment count per pin set ID.
+    bool segments_valid=false;              //!< Whether segment_count is current.
+    bool seg_comps_valid=false;             //!< Whether seg_parent and seg_pins are current, dirty nets aside.
+    QVector<int> seg_parent;                //!< Union-find parent per cell, -1 outside nets.
+    QVector<int> seg_pins;                  //!< Pins in the component of each root.
+    QVector<bool> net_dirty;                //!< Whether a net's components must be rebuilt.
+    QVector<int> dirty_nets;                //!< Pin set IDs of dirty nets.
+    QVector<int> dirty_cells;               //!< Cells of dirty nets to rebuild from.
+
+    // working values and search bookkeeping, allocated when first used
+    QVector<int> working_vals;              //!< Working value per cell, -1 if none.
+    QVector<SearchNode> search_nodes;       //!< Search bookkeeping per cell.
+
+    bool track_changes=false;               //!< Whether changed cells are tracked.
+    ChangedCells changed_cells;             //!< Cells changed since last taken.
+
+    // traversal scratch space, not part of the grid state
+    QVector<quint32> visit_stamps;          //!< Stamp of the last visit per cell.
+    QVector<int> visit_from;                //!< Cell index each cell was reached from.
+    QVector<int> visit_stack;               //!< Cells left to visit.
+    quint32 visit_stamp=0;                  //!< Stamp of the current traversal.
   };
 
   inline uint qHash(const Coord &coord, uint seed=0)
@@ -0,0 +1,335 @@
+// @file:     pinrouter_perf_tests.cpp
+// @author:   Samuel Ng
+// @created:  2026-10-18
+// @license:  GNU LGPL v3
+//
+// @desc:     QBENCHMARK performance tests of the router's hot paths, with an
+//            optional comparison against a stored baseline.
+
+#include <QtTest/QtTest>
+#include <functional>
+#include "router/problem.h"
+#include "router/router.h"
+#include "router/route_api.h"
+#include "router/problem_generator.h"
+
+//! Benchmarks of the router's hot paths. Besides the usual QBENCHMARK output,
+//! each benchmark can be compared against a stored baseline through the
+//! following environment variables:
+//!   PINROUTER_PERF_RECORD    write the measured times to this JSON file;
+//!   PINROUTER_PERF_BASELINE  fail benchmarks slower than in this JSON file;
+//!   PINROUTER_PERF_MARGIN    fraction by which the baseline may be exceeded
+//!                            before failing (default 0.25).
+//! Baselines are only meaningful on the machine and build type they were
+//! recorded with.
+class RouterPerfTests : public QObject
+{
+  Q_OBJECT
+
+  public:
+
+    //! Measure the time per call of op and compare it against the baseline
+    //! (if any) under the name of the current benchmark. Each round calls op
+    //! often enough to take at least 20 ms and the fastest round counts,
+    //! which is much less noisy than QBENCHMARK's single measurement.
+    void checkBaseline(const std::function<void()> &op)
+    {
+      if (record_path.isEmpty() && baseline.isEmpty()) {
+        return;
+      }
+
+      // calibrate the calls per round
+      const qint64 round_ns = 20000000;
+      qint64 calls = 1;
+      QElapsedTimer timer;
+      timer.start();
+      op();
+      qint64 first_ns = qMax((qint64)1, timer.nsecsElapsed());
+      if (first_ns < round_ns) {
+        calls = qMin((qint64)100000, round_ns / first_ns);
+      }
+      double best_ns = -1;
+      for (int round=0; round<5; round++) {
+        timer.restart();
+        for (qint64 i=0; i<calls; i++) {
+          op();
+        }
+        double ns = (double)timer.nsecsElapsed() / calls;
+        if (best_ns < 0 || ns < best_ns) {
+          best_ns = ns;
+        }
+      }
+
+      QString name = QTest::currentTestFunction();
+      if (QTest::currentDataTag() != nullptr && qstrlen(QTest::currentDataTag()) > 0) {
+        name += QString(":%1").arg(QTest::currentDataTag());
+      }
+      recorded[name] = best_ns;
+      if (baseline.contains(name)) {
+        double base_ns = baseline[name].toDouble();
+        double limit_ns = base_ns * (1 + margin);
+        QVERIFY2(best_ns <= limit_ns, qPrintable(QString("%1 took %2 us per "
+                "call, baseline %3 us (limit %4 us)").arg(name)
+              .arg(best_ns / 1000, 0, 'f', 2).arg(base_ns / 1000, 0, 'f', 2)
+              .arg(limit_ns / 1000, 0, 'f', 2)));
+      } else if (!baseline.isEmpty()) {
+        qWarning() << QString("%1 has no baseline.").arg(name);
+      }
+    }
+
+  private slots:
+
+    //! Load the baseline and prepare the problems shared by the benchmarks.
+    void initTestCase()
+    {
+      using namespace rt;
+
+      record_path = QString::fromLocal8Bit(qgetenv("PINROUTER_PERF_RECORD"));
+      QString baseline_path = QString::fromLocal8Bit(qgetenv("PINROUTER_PERF_BASELINE"));
+      if (!baseline_path.isEmpty()) {
+        QFile file(baseline_path);
+        QVERIFY2(file.open(QFile::ReadOnly),
+            qPrintable(QString("Unable to read %1.").arg(baseline_path)));
+        QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+        baseline = obj["benchmarks"].toObject();
+        QVERIFY2(!baseline.isEmpty(),
+            qPrintable(QString("%1 has no benchmarks.").arg(baseline_path)));
+      }
+      if (qEnvironmentVariableIsSet("PINROUTER_PERF_MARGIN")) {
+        bool ok;
+        margin = qgetenv("PINROUTER_PERF_MARGIN").toDouble(&ok);
+        QVERIFY2(ok && margin >= 0, "PINROUTER_PERF_MARGIN must be a "
+            "non-negative fraction.");
+      }
+
+      // the sample standard cell problem, also in the binary format
+      QVERIFY(tmp_dir.isValid());
+      QCOMPARE(stdcell.readProblem(":/sample_problems/stdcell.infile"), true);
+      QCOMPARE(stdcell.writeProblem(tmp_dir.filePath("stdcell.pbin"),
+            Problem::BinaryFormat), true);
+
+      // a large text problem with a third of its cells obstructed
+      {
+        const int dim = 1000;
+        QFile file(tmp_dir.filePath("large.infile"));
+        QVERIFY(file.open(QFile::WriteOnly | QFile::Text));
+        QTextStream out(&file);
+        int obs_count = 0;
+        for (int x=0; x<dim; x++) {
+          for (int y=0; y<dim; y++) {
+            obs_count += ((x + y) % 3 == 1);
+          }
+        }
+        out << dim << " " << dim << "\n" << obs_count << "\n";
+        for (int x=0; x<dim; x++) {
+          for (int y=0; y<dim; y++) {
+            if ((x + y) % 3 == 1) {
+              out << x << " " << y << "\n";
+            }
+          }
+        }
+        out << "1\n2 0 0 " << dim-1 << " 0\n";
+      }
+
+      // a fixed grid with a single net spanning it, for the searches
+      GeneratorSettings gen_settings;
+      gen_settings.dim_x = 256;
+      gen_settings.dim_y = 256;
+      gen_settings.obs_density = 0.2;
+      gen_settings.obs_clustering = 0.5;
+      gen_settings.max_cluster_size = 16;
+      gen_settings.net_count = 1;
+      gen_settings.min_pins = 2;
+      gen_settings.max_pins = 2;
+      gen_settings.min_span = 256;
+      gen_settings.seed = 7;
+      QString error;
+      QVERIFY2(ProblemGenerator::generate(gen_settings, &search_problem, &error),
+          qPrintable(error));
+      QCOMPARE(search_problem.pinSets().size(), 1);
+
+      // a routed grid, for the grid operations
+      RouterSettings settings;
+      settings.log_level = LogNone;
+      settings.gui_update_level = VisualizeNone;
+      routed = routeProblem(stdcell, settings);
+      QVERIFY(!routed.grid.isNull());
+    }
+
+    //! Write the measured times if requested.
+    void cleanupTestCase()
+    {
+      if (record_path.isEmpty()) {
+        return;
+      }
+      QJsonObject obj;
+      obj["benchmarks"] = recorded;
+      QFile file(record_path);
+      QVERIFY2(file.open(QFile::WriteOnly | QFile::Truncate),
+          qPrintable(QString("Unable to write %1.").arg(record_path)));
+      file.write(QJsonDocument(obj).toJson());
+    }
+
+    void benchFindRoute_data()
+    {
+      QTest::addColumn<int>("alg");
+      QTest::newRow("astar") << (int)rt::AStar;
+      QTest::newRow("lee-moore") << (int)rt::LeeMoore;
+    }
+
+    //! Benchmark a single search across the fixed grid.
+    void benchFindRoute()
+    {
+      using namespace rt;
+
+      QFETCH(int, alg);
+      QScopedPointer<RoutingAlg> routing_alg;
+      if (alg == LeeMoore) {
+        routing_alg.reset(new LeeMooreAlg());
+      } else {
+        routing_alg.reset(new AStarAlg());
+      }
+      sp::Grid *grid = search_problem.cellGrid();
+      sp::PinSet pins = search_problem.pinSets().first();
+      auto op = [&]()
+      {
+        routing_alg->findRoute(pins[0], pins[1], grid, false);
+      };
+      QBENCHMARK {
+        op();
+      }
+      checkBaseline(op);
+    }
+
+    //! Benchmark copying a routed grid into a new grid.
+    void benchGridCopy()
+    {
+      sp::Grid *grid = routed.grid.data();
+      auto op = [grid]()
+      {
+        sp::Grid copy(grid);
+      };
+      QBENCHMARK {
+        op();
+      }
+      checkBaseline(op);
+    }
+
+    //! Benchmark copying the state of a routed grid onto an unrouted one,
+    //! as done when backing up and restoring grids between attempts.
+    void benchGridCopyState()
+    {
+      sp::Grid *grid = routed.grid.data();
+      sp::Grid target(stdcell.cellGrid());
+      sp::Grid *unrouted = stdcell.cellGrid();
+      bool to_routed = true;
+      auto op = [&]()
+      {
+        target.copyState(to_routed ? grid : unrouted);
+        to_routed = !to_routed;
+      };
+      QBENCHMARK {
+        op();
+      }
+      checkBaseline(op);
+    }
+
+    //! Benchmark clearing the working values that an A* search leaves
+    //! behind. The search is included, subtract benchFindRoute:astar for the
+    //! cost of clearing alone.
+    void benchGridClear()
+    {
+      sp::Grid grid(search_problem.cellGrid());
+      rt::AStarAlg alg;
+      sp::PinSet pins = search_problem.pinSets().first();
+      auto op = [&]()
+      {
+        alg.findRoute(pins[0], pins[1], &grid, false, false);
+        grid.clearWorkingValues();
+      };
+      QBENCHMARK {
+        op();
+      }
+      checkBaseline(op);
+    }
+
+    //! Benchmark checking whether the pins of every routed connection are
+    //! joined.
+    void benchRouteExists()
+    {
+      sp::Grid *grid = routed.grid.data();
+      const QList<sp::Connection> &conns = routed.connections;
+      QVERIFY(!conns.isEmpty());
+      auto op = [grid, &conns]()
+      {
+        for (const sp::Connection &conn : conns) {
+          grid->routeExistsBetweenPins(conn.pinPair().first, conn.pinPair().second);
+        }
+      };
+      QBENCHMARK {
+        op();
+      }
+      checkBaseline(op);
+    }
+
+    void benchProblemParse_data()
+    {
+      QTest::addColumn<QString>("path");
+      QTest::newRow("text") << QString(":/sample_problems/stdcell.infile");
+      QTest::newRow("binary") << tmp_dir.filePath("stdcell.pbin");
+      QTest::newRow("large-text") << tmp_dir.filePath("large.infile");
+    }
+
+    //! Benchmark reading problems, validation included. The routing grid is
+    //! only built on demand, so it isn't.
+    void benchProblemParse()
+    {
+      QFETCH(QString, path);
+      rt::Problem check;
+      QCOMPARE(check.readProblem(path), true);
+      QCOMPARE(check.isValid(), true);
+      auto op = [&path]()
+      {
+        rt::Problem problem;
+        problem.readProblem(path);
+      };
+      QBENCHMARK {
+        op();
+      }
+      checkBaseline(op);
+    }
+
+    //! Benchmark routing the whole standard cell problem.
+    void benchRouteSuite()
+    {
+      using namespace rt;
+
+      RouterSettings settings;
+      settings.log_level = LogNone;
+      settings.gui_update_level = VisualizeNone;
+      auto op = [this, &settings]()
+      {
+        Router router(stdcell, settings);
+        sp::Grid grid(stdcell.cellGrid());
+        router.routeSuite(stdcell.pinSets(), &grid, nullptr, nullptr);
+      };
+      QBENCHMARK {
+        op();
+      }
+      checkBaseline(op);
+    }
+
+  private:
+
+    QString record_path;        //!< Where measured times are written, if anywhere.
+    QJsonObject baseline;       //!< Baseline times in ns by benchmark name.
+    QJsonObject recorded;       //!< Measured times in ns by benchmark name.
+    double margin=0.25;         //!< Allowed excess over the baseline.
+    QTemporaryDir tmp_dir;      //!< Directory for converted problems.
+    rt::Problem stdcell;        //!< The sample standard cell problem.
+    rt::Problem search_problem; //!< Fixed grid with a single spanning net.
+    rt::RouteOutput routed;     //!< stdcell after routing.
+};
+
+QTEST_MAIN(RouterPerfTests)
+#include "pinrouter_perf_tests.moc"  // generated at compile time
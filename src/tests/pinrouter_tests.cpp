@@ -9,7 +9,52 @@
 #include <QtTest/QtTest>
 #include "router/problem.h"
 #include "router/router.h"
+#include "router/route_api.h"
+#include "router/solution_io.h"
+#include "router/problem_generator.h"
+#include "router/step_log.h"
 #include "gui/settings.h"
+#include "gui/prim/grid_tile.h"
+#include "cli/batch_runner.h"
+
+#ifdef __GLIBC__
+#include <atomic>
+
+// count heap allocations by wrapping glibc's allocator, only while a test
+// asks for it
+extern "C" {
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t count, size_t size);
+  void *__libc_realloc(void *ptr, size_t size);
+}
+
+static std::atomic<bool> count_allocs(false);   // whether allocations are counted
+static std::atomic<int> alloc_count(0);         // allocations counted so far
+
+extern "C" void *malloc(size_t size) __THROW
+{
+  if (count_allocs.load(std::memory_order_relaxed)) {
+    alloc_count++;
+  }
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) __THROW
+{
+  if (count_allocs.load(std::memory_order_relaxed)) {
+    alloc_count++;
+  }
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) __THROW
+{
+  if (count_allocs.load(std::memory_order_relaxed)) {
+    alloc_count++;
+  }
+  return __libc_realloc(ptr, size);
+}
+#endif
 
 class RouterTests : public QObject
 {
@@ -36,6 +81,21 @@ class RouterTests : public QObject
       return true;
     }
 
+    //! Return the number of nets whose pins are all joined in the provided
+    //! grid.
+    int routedNetCount(sp::Grid *grid, const QList<sp::PinSet> &pin_sets)
+    {
+      int count = 0;
+      for (const sp::PinSet &pin_set : pin_sets) {
+        bool routed = true;
+        for (int i=1; i<pin_set.size() && routed; i++) {
+          routed = grid->routeExistsBetweenPins(pin_set[0], pin_set[i]);
+        }
+        count += routed ? 1 : 0;
+      }
+      return count;
+    }
+
   // functions in these slots are automatically called after compilation
   private slots:
 
@@ -118,7 +178,7 @@ class RouterTests : public QObject
       settings.log_level=LogCoarseIntermediate;
       // route the problem
       Router *router = new Router(problem, settings);
-      bool soft_halt=false;
+      CancelToken soft_halt;
       SolveCollection solve_col;
       router->routeSuite(problem.pinSets(), problem.cellGrid(), &soft_halt,
           &solve_col);
@@ -174,6 +234,1271 @@ class RouterTests : public QObject
     }
 
 
+    //! Test that routing stops when the budget runs out or when cancelled, 
+    //! leaving the best partial result in the grid.
+    void testRouteBudget()
+    {
+      using namespace rt;
+
+      // a cancelled token must stop routing before anything is routed
+      Problem problem(":/sample_problems/stdcell.infile");
+      RouterSettings settings;
+      settings.log_level=LogResultsOnly;
+      CancelToken soft_halt;
+      soft_halt.cancel();
+      SolveCollection solve_col;
+      Router *router = new Router(problem, settings);
+      QCOMPARE(router->routeSuite(problem.pinSets(), problem.cellGrid(),
+            &soft_halt, &solve_col), false);
+      QCOMPARE(problem.cellGrid()->countCells({sp::RoutedCell}), 0);
+      delete router;
+
+      // route the first attempt of an unroutable problem on its own
+      problem = Problem(":/sample_problems/impossible.infile");
+      settings = RouterSettings();
+      settings.log_level = LogNone;
+      settings.max_rerun_count = 1;
+      RouteOutput first = routeProblem(problem, settings);
+      QCOMPARE(first.stats.success, false);
+      QCOMPARE(first.stats.budget_exhausted, false);
+      int first_nets = routedNetCount(first.grid.data(), problem.pinSets());
+      QVERIFY(first.stats.segments > 0);
+
+      // a budget that runs out early in the second attempt must leave the
+      // first attempt's result in the grid
+      settings.max_rerun_count = RouterSettings().max_rerun_count;
+      QVERIFY(settings.max_rerun_count > 1);
+      settings.expansion_budget = first.stats.expansions + 5;
+      RouteOutput output = routeProblem(problem, settings);
+      QCOMPARE(output.stats.budget_exhausted, true);
+      QCOMPARE(output.stats.success, false);
+      QCOMPARE(output.stats.expansions >= settings.expansion_budget, true);
+      QCOMPARE(output.stats.segments >= first.stats.segments, true);
+      QCOMPARE(routedNetCount(output.grid.data(), problem.pinSets()) >= first_nets, true);
+      QVERIFY(!output.connections.isEmpty());
+      for (const sp::Connection &conn : output.connections) {
+        QCOMPARE(output.grid->routeExistsBetweenPins(conn.pinPair().first,
+              conn.pinPair().second), true);
+      }
+    }
+
+
+    //! Test the pinrouter_core API for loading and routing problems.
+    void testRouteApi()
+    {
+      using namespace rt;
+
+      Problem problem;
+      QString error;
+      QCOMPARE(loadProblem(":/test_problems/3_rows.infile", &problem, &error), true);
+      QCOMPARE(error.isEmpty(), true);
+      RouteOutput output = routeProblem(problem, RouterSettings());
+      QCOMPARE(output.stats.success, true);
+      QCOMPARE(output.stats.segments, 2);
+      QCOMPARE(output.grid->allPinsRouted(), true);
+      QCOMPARE(output.connections.size() >= 2, true);
+      // connections must belong to the nets of the problem
+      for (const sp::Connection &conn : output.connections) {
+        QCOMPARE(conn.pinSetId() >= 0 && conn.pinSetId() < 2, true);
+      }
+      // the provided problem must be left untouched
+      QCOMPARE(problem.cellGrid()->countCells({sp::RoutedCell}), 0);
+
+      // unreadable files must be reported
+      QCOMPARE(loadProblem(":/test_problems/nonexistent.infile", &problem, &error), false);
+      QCOMPARE(error.isEmpty(), false);
+    }
+
+    //! Test that instrumentation counters are aggregated per attempt and per
+    //! net, and that routing runs fill them in only when compiled in.
+    void testRouteInstrumentation()
+    {
+      using namespace rt;
+
+      RouteInstrumentation instr;
+      instr.beginNet(0);
+      instr.count(FindRouteCalls, 2);
+      instr.beginNet(1);
+      instr.count(FindRouteCalls);
+      instr.beginAttempt();
+      instr.beginNet(0);
+      instr.count(NodesExpanded, 5);
+      instr.addTime(SearchTimer, 1000);
+      QCOMPARE(instr.attemptCount(), 2);
+      QCOMPARE(instr.attempt(0).counts[FindRouteCalls], (qint64)3);
+      QCOMPARE(instr.attempt(1).counts[NodesExpanded], (qint64)5);
+      QCOMPARE(instr.net(0).counts[FindRouteCalls], (qint64)2);
+      QCOMPARE(instr.net(0).counts[NodesExpanded], (qint64)5);
+      QCOMPARE(instr.nets(), QList<int>({0, 1}));
+      QCOMPARE(instr.total().nsecs[SearchTimer], (qint64)1000);
+      instr.reset();
+      QCOMPARE(instr.isEmpty(), true);
+      QCOMPARE(instr.attemptCount(), 1);
+
+      Problem problem(":/sample_problems/kuma.infile");
+      RouterSettings settings;
+      settings.log_level = LogCoarseIntermediate;
+      SolveCollection solve_col;
+      RouteOutput output = routeProblem(problem, settings, nullptr, &solve_col);
+      const RouteInstrumentation &run_instr = output.stats.instrumentation;
+      if (!RouteInstrumentation::enabled()) {
+        QCOMPARE(run_instr.isEmpty(), true);
+        return;
+      }
+      RouteCounters total = run_instr.total();
+      QCOMPARE(total.counts[FindRouteCalls], output.stats.searches);
+      QCOMPARE(total.counts[NodesExpanded], output.stats.expansions);
+      QCOMPARE(total.counts[QueuePops] <= total.counts[QueuePushes], true);
+      QCOMPARE(run_instr.attemptCount(), solve_col.solve_steps.size());
+      QCOMPARE(total.counts[GlobalReruns], (qint64)run_instr.attemptCount()-1);
+      // events outside of routing a net (e.g. grid backups) belong to net -1
+      for (int id : run_instr.nets()) {
+        QCOMPARE(id >= -1 && id < problem.pinSets().size(), true);
+      }
+    }
+
+    //! Test that the trace-event timeline of a routing run is a valid JSON
+    //! array with balanced events, and that the writer's buffer stays bounded.
+    void testTraceWriter()
+    {
+      using namespace rt;
+
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      Problem problem(":/sample_problems/kuma.infile");
+      RouterSettings settings;
+      settings.trace_path = tmp_dir.filePath("kuma.json");
+      RouteOutput output = routeProblem(problem, settings);
+      QCOMPARE(output.stats.success, true);
+
+      QFile file(settings.trace_path);
+      QVERIFY(file.open(QFile::ReadOnly));
+      QJsonParseError parse_error;
+      QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parse_error);
+      QCOMPARE(parse_error.error, QJsonParseError::NoError);
+      QVERIFY(doc.isArray());
+
+      // every begin is matched by an end of the same name in stack order
+      QStringList open_events;
+      QMap<QString, int> counts;
+      qint64 expansions = 0;
+      double last_ts = 0;
+      for (const QJsonValue &val : doc.array()) {
+        QJsonObject event = val.toObject();
+        QString name = event["name"].toString();
+        QString phase = event["ph"].toString();
+        if (phase == "B") {
+          open_events.append(name);
+          counts[name]++;
+        } else if (phase == "E") {
+          QVERIFY(!open_events.isEmpty());
+          QCOMPARE(open_events.takeLast(), name);
+          if (name == "findRoute") {
+            QVERIFY(event["args"].toObject().contains("alg"));
+            expansions += (qint64)event["args"].toObject()["expansions"].toDouble();
+          }
+        } else {
+          continue;
+        }
+        QVERIFY(event["ts"].toDouble() >= last_ts);
+        last_ts = event["ts"].toDouble();
+      }
+      QCOMPARE(open_events.isEmpty(), true);
+      QCOMPARE(counts["run"], 1);
+      QCOMPARE(counts["attempt"] >= 1, true);
+      QCOMPARE(counts["routePinPair"] >= problem.pinSets().size(), true);
+      QCOMPARE((qint64)counts["findRoute"], output.stats.searches);
+      QCOMPARE(expansions, output.stats.expansions);
+
+      // a small buffer is written out as soon as it fills up
+      TraceWriter writer(256);
+      QCOMPARE(writer.open(tmp_dir.filePath("small.json")), true);
+      for (int i=0; i<100; i++) {
+        TraceScope scope(&writer, "event", "test");
+        scope.arg("i", i);
+        QVERIFY(writer.bufferedBytes() < 512);
+      }
+      QVERIFY(QFileInfo(tmp_dir.filePath("small.json")).size() > 0);
+      QCOMPARE(writer.finish(), true);
+      QFile small(tmp_dir.filePath("small.json"));
+      QVERIFY(small.open(QFile::ReadOnly));
+      QCOMPARE(QJsonDocument::fromJson(small.readAll()).array().size(), 201);
+    }
+
+    //! Test that steps recorded on the background thread match the grids
+    //! that the router logged them from.
+    void testAsyncStepRecording()
+    {
+      using namespace rt;
+
+      Problem problem(":/sample_problems/kuma.infile");
+      RouterSettings settings;
+      settings.log_level = LogCoarseIntermediate;
+      settings.gui_update_level = VisualizeCoarseIntermediate;
+      settings.step_memory_budget_mb = 0;
+      settings.async_step_recording = true;
+      Router router(problem, settings);
+
+      // both verbosities match, so every emitted step is also logged
+      QList<QSharedPointer<sp::Grid>> expected;
+      connect(router.recordKeeper(), &RoutingRecords::routerStep,
+          [&expected](sp::Grid *grid)
+          {
+            expected.append(QSharedPointer<sp::Grid>(new sp::Grid(grid)));
+          });
+      CancelToken soft_halt;
+      SolveCollection solve_col;
+      router.routeSuite(problem.pinSets(), problem.cellGrid(), &soft_halt,
+          &solve_col);
+
+      QList<sp::Grid*> recorded;
+      for (const SolveSteps &steps : solve_col.solve_steps) {
+        for (int i=0; i<steps.size(); i++) {
+          recorded.append(steps[i]);
+        }
+      }
+      QCOMPARE(recorded.size(), expected.size());
+      for (int i=0; i<recorded.size(); i++) {
+        sp::Coord dims = expected[i]->dimensions();
+        for (int x=0; x<dims.x; x++) {
+          for (int y=0; y<dims.y; y++) {
+            sp::Coord coord(x, y);
+            QCOMPARE(recorded[i]->cellAt(coord)->getType(),
+                expected[i]->cellAt(coord)->getType());
+            QCOMPARE(recorded[i]->cellAt(coord)->pinSetId(),
+                expected[i]->cellAt(coord)->pinSetId());
+          }
+        }
+      }
+    }
+
+    //! Test that the running statistics of a grid match recounts from 
+    //! scratch after routing, ripping and restoring.
+    void testGridStatistics()
+    {
+      using namespace rt;
+
+      // recount by tracing every pin and scanning every cell
+      auto checkStats = [](sp::Grid *grid) -> bool
+      {
+        int segments = 0;
+        QSet<sp::Coord> visited;
+        QMap<int,int> net_cells;
+        int routed = 0;
+        qint64 wirelength = 0;
+        for (const sp::Cell &cell : grid->cellStorage()) {
+          sp::Coord coord = cell.getCoord();
+          if (cell.getType() == sp::PinCell && !visited.contains(coord)) {
+            QList<sp::Coord> cpins = grid->connectedPins(coord);
+            segments += qMax(cpins.size()-1, 0);
+            for (const sp::Coord &cpin : cpins) {
+              visited.insert(cpin);
+            }
+          }
+          routed += (cell.getType() == sp::RoutedCell) ? 1 : 0;
+          bool net_cell = (cell.getType() == sp::PinCell
+              || cell.getType() == sp::RoutedCell) && cell.pinSetId() > -1;
+          for (const sp::Coord &ncoord : {coord.right(), coord.below()}) {
+            sp::Cell *ncell = grid->cellAt(ncoord);
+            if (net_cell && ncell != nullptr && ncell->pinSetId() == cell.pinSetId()
+                && (ncell->getType() == sp::PinCell || ncell->getType() == sp::RoutedCell)) {
+              wirelength++;
+            }
+          }
+        }
+        return grid->countSegments() == segments
+          && grid->cellCount(sp::RoutedCell) == routed
+          && grid->countCells({sp::RoutedCell}) == routed
+          && grid->wirelength() == wirelength;
+      };
+
+      Problem problem(":/sample_problems/kuma.infile");
+      sp::Grid *grid = problem.cellGrid();
+      QCOMPARE(checkStats(grid), true);
+      QCOMPARE(grid->countSegments(), 0);
+      QCOMPARE(grid->cellCount(sp::BlankCell) + grid->cellCount(sp::ObsCell)
+          + grid->cellCount(sp::PinCell), grid->countCells({}));
+
+      RouterSettings settings;
+      settings.log_level = LogNone;
+      Router router(problem, settings);
+      CancelToken soft_halt;
+      router.routeSuite(problem.pinSets(), grid, &soft_halt, nullptr);
+      QCOMPARE(checkStats(grid), true);
+      QCOMPARE(grid->countSegments() > 0, true);
+
+      // clear half of the routed cells, then restore them
+      sp::Grid routed(grid);
+      QCOMPARE(checkStats(&routed), true);
+      int cleared = 0;
+      for (const sp::Cell &cell : routed.cellStorage()) {
+        if (cell.getType() == sp::RoutedCell && cleared++ % 2 == 0) {
+          grid->setCellType(cell.getCoord(), sp::BlankCell);
+        }
+      }
+      QCOMPARE(checkStats(grid), true);
+      for (const sp::Cell &cell : routed.cellStorage()) {
+        grid->setCellType(cell.getCoord(), cell.getType(), cell.pinSetId());
+      }
+      QCOMPARE(checkStats(grid), true);
+      QCOMPARE(grid->countSegments(), routed.countSegments());
+      QCOMPARE(grid->wirelength(), routed.wirelength());
+
+      // rip one net at a time, counting in between so that only that net is
+      // recounted, and hand a ripped cell to another net before counting
+      for (int pin_set_id=0; pin_set_id<problem.pinSets().size(); pin_set_id++) {
+        QList<sp::Coord> net_cells;
+        for (const sp::Cell &cell : routed.cellStorage()) {
+          if (cell.getType() == sp::RoutedCell && cell.pinSetId() == pin_set_id) {
+            net_cells.append(cell.getCoord());
+          }
+        }
+        for (int i=0; i<net_cells.size(); i++) {
+          grid->setCellType(net_cells[i], sp::BlankCell);
+          if (i % 3 == 0) {
+            QCOMPARE(checkStats(grid), true);
+          }
+        }
+        if (!net_cells.isEmpty()) {
+          int other_id = (pin_set_id + 1) % problem.pinSets().size();
+          grid->setCellType(net_cells.first(), sp::RoutedCell, other_id);
+          QCOMPARE(checkStats(grid), true);
+          grid->setCellType(net_cells.first(), sp::BlankCell);
+        }
+        for (const sp::Coord &coord : net_cells) {
+          grid->setCellType(coord, sp::RoutedCell, pin_set_id);
+        }
+        QCOMPARE(checkStats(grid), true);
+      }
+      QCOMPARE(grid->countSegments(), routed.countSegments());
+    }
+
+    //! Test that recorded steps carry the metrics of their grids, and that
+    //! steps recorded on the background thread carry the same metrics as
+    //! steps recorded synchronously even though the recorder's grid has no
+    //! connections.
+    void testStepMetrics()
+    {
+      using namespace rt;
+
+      Problem problem(":/sample_problems/kuma.infile");
+      QList<QList<StepMetrics>> recorded;
+      for (bool async : {false, true}) {
+        RouterSettings settings;
+        settings.log_level = LogCoarseIntermediate;
+        settings.async_step_recording = async;
+        Router router(problem, settings);
+        SolveCollection solve_col;
+        CancelToken soft_halt;
+        router.routeSuite(problem.pinSets(), problem.cellGrid(), &soft_halt, &solve_col);
+
+        QCOMPARE(solve_col.solve_steps.isEmpty(), false);
+        QList<StepMetrics> metrics_list;
+        for (const SolveSteps &steps : solve_col.solve_steps) {
+          for (int i=0; i<steps.size(); i++) {
+            StepMetrics metrics = steps.metrics(i);
+            QCOMPARE(metrics.segments, steps[i]->countSegments());
+            QCOMPARE(metrics.routed_cells, steps[i]->countCells({sp::RoutedCell}));
+            QCOMPARE(metrics.wirelength >= metrics.routed_cells, true);
+            QCOMPARE(metrics.routed_cells == 0 || metrics.wirelength > 0, true);
+            metrics_list.append(metrics);
+          }
+        }
+        recorded.append(metrics_list);
+      }
+
+      // the router is deterministic, so both runs record the same steps
+      QCOMPARE(recorded[1].size(), recorded[0].size());
+      for (int i=0; i<recorded[0].size(); i++) {
+        QCOMPARE(recorded[1][i].segments, recorded[0][i].segments);
+        QCOMPARE(recorded[1][i].routed_cells, recorded[0][i].routed_cells);
+        QCOMPARE(recorded[1][i].wirelength, recorded[0][i].wirelength);
+      }
+    }
+
+    //! Test that steps streamed to an on-disk step log can be read back in 
+    //! any order, also from a log that was cut short.
+    void testStepLogFile()
+    {
+      using namespace rt;
+
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      Problem problem(":/sample_problems/kuma.infile");
+      RouterSettings settings;
+      settings.log_level = LogCoarseIntermediate;
+      settings.gui_update_level = VisualizeCoarseIntermediate;
+      settings.step_log_path = tmp_dir.filePath("kuma.rlog");
+      Router router(problem, settings);
+      QList<QSharedPointer<sp::Grid>> expected;
+      connect(router.recordKeeper(), &RoutingRecords::routerStep,
+          [&expected](sp::Grid *grid)
+          {
+            expected.append(QSharedPointer<sp::Grid>(new sp::Grid(grid)));
+          });
+      CancelToken soft_halt;
+      router.routeSuite(problem.pinSets(), problem.cellGrid(), &soft_halt, nullptr);
+
+      StepLogFile log;
+      QString error;
+      QCOMPARE(log.load(settings.step_log_path, &error), true);
+      QCOMPARE(log.dimensions(), problem.dimensions());
+      QCOMPARE(log.pinSets(), problem.pinSets());
+      QList<QPair<int,int>> steps;
+      for (int attempt=0; attempt<log.attemptCount(); attempt++) {
+        for (int step=0; step<log.stepCount(attempt); step++) {
+          steps.append(qMakePair(attempt, step));
+        }
+      }
+      QCOMPARE(steps.size(), expected.size());
+
+      // scrub backwards so that every step is decoded from a keyframe
+      sp::Grid grid(problem.cellGrid());
+      auto matches = [&grid](sp::Grid *other) -> bool
+      {
+        for (int x=0; x<grid.dimensions().x; x++) {
+          for (int y=0; y<grid.dimensions().y; y++) {
+            sp::Coord coord(x, y);
+            if (grid.cellAt(coord)->getType() != other->cellAt(coord)->getType()
+                || grid.cellAt(coord)->pinSetId() != other->cellAt(coord)->pinSetId()) {
+              return false;
+            }
+          }
+        }
+        return true;
+      };
+      for (int i=steps.size()-1; i>=0; i--) {
+        QCOMPARE(log.readStep(steps[i].first, steps[i].second, &grid), true);
+        QCOMPARE(matches(expected[i].data()), true);
+      }
+      QCOMPARE(log.readStep(log.attemptCount(), 0, &grid), false);
+
+      // a log without its index (e.g. after a crash) is scanned instead
+      QFile full(settings.step_log_path);
+      QVERIFY(full.open(QFile::ReadOnly));
+      QByteArray bytes = full.readAll();
+      full.close();
+      QFile cut(tmp_dir.filePath("cut.rlog"));
+      QVERIFY(cut.open(QFile::WriteOnly));
+      cut.write(bytes.left(bytes.size() - 7));
+      cut.close();
+      StepLogFile cut_log;
+      QCOMPARE(cut_log.load(cut.fileName(), &error), true);
+      QCOMPARE(cut_log.attemptCount(), log.attemptCount());
+      QCOMPARE(cut_log.readStep(0, 0, &grid), true);
+      QCOMPARE(matches(expected[0].data()), true);
+      // tampered records with unknown cell types or pin set IDs are rejected
+      // instead of reaching the grid
+      auto writeLog = [&tmp_dir](const QString &name, quint8 type, qint32 pin_id)
+      {
+        QByteArray bytes("PSLG");
+        auto appendInt = [&bytes](qint32 val)
+        {
+          uchar le[4];
+          qToLittleEndian(val, le);
+          bytes.append((const char*)le, 4);
+        };
+        for (qint32 val : {1, 2, 1, 1, 2, 0, 0, 1, 0}) {
+          appendInt(val);   // version, 2x1 grid and one net with pins (0,0) (1,0)
+        }
+        QByteArray raw;
+        for (int i=0; i<2; i++) {
+          raw.append(i == 0 ? (char)type : (char)sp::PinCell);
+          uchar le[4];
+          qToLittleEndian(i == 0 ? pin_id : 0, le);
+          raw.append((const char*)le, 4);
+        }
+        QByteArray payload = qCompress(raw);
+        for (qint32 val : {0, 0, 0, payload.size()}) {
+          appendInt(val);   // attempt, step, keyframe kind and payload size
+        }
+        bytes.append(payload);
+        appendInt(-1);
+        QFile file(tmp_dir.filePath(name));
+        file.open(QFile::WriteOnly);
+        file.write(bytes);
+        return file.fileName();
+      };
+      sp::Grid small_grid(2, 1, {}, {{sp::Coord(0,0), sp::Coord(1,0)}});
+      for (auto tampered : QList<QPair<quint8,qint32>>({{sp::PinCell, 0},
+            {sp::BlankCell+1, -1}, {255, -1}, {sp::RoutedCell, 1},
+            {sp::RoutedCell, 0x7fffffff}, {sp::RoutedCell, -2}})) {
+        StepLogFile tampered_log;
+        QCOMPARE(tampered_log.load(writeLog("tampered.rlog", tampered.first,
+                tampered.second), &error), true);
+        QCOMPARE(tampered_log.attemptCount(), 1);
+        bool intact = tampered.first == sp::PinCell;
+        QCOMPARE(tampered_log.readStep(0, 0, &small_grid), intact);
+      }
+      QCOMPARE(small_grid.cellCount(sp::PinCell), 2);
+    }
+
+    //! Test that the step log stays within its memory budget by thinning out
+    //! older steps while keeping the most recent ones and each attempt's 
+    //! final result.
+    void testStepMemoryBudget()
+    {
+      using namespace rt;
+
+      Problem problem;
+      QCOMPARE(loadProblem(":/test_problems/3_rows.infile", &problem), true);
+      qint64 step_bytes = problem.cellGrid()->memoryFootprint();
+      SolveCollection solve_col;
+      solve_col.setMemoryBudget(10 * step_bytes);
+      solve_col.setRingSize(4);
+
+      SolveSteps *first = solve_col.newSolveSteps();
+      solve_col.appendStep(first, QSharedPointer<sp::Grid>(new sp::Grid(problem.cellGrid())));
+      QWeakPointer<sp::Grid> dropped = first->grid(0);
+      for (int i=1; i<100; i++) {
+        solve_col.appendStep(first, QSharedPointer<sp::Grid>(new sp::Grid(problem.cellGrid())));
+        if (i == 1) {
+          dropped = first->grid(1);
+        }
+        QCOMPARE(solve_col.memoryUsed() <= solve_col.memoryBudget(), true);
+      }
+      QCOMPARE(dropped.isNull(), true);   // thinned out steps are freed
+      QCOMPARE(first->loggedCount(), 100);
+      QCOMPARE(first->stepIndex(0), 0);
+      for (int i=0; i<4; i++) {
+        QCOMPARE(first->stepIndex(first->size()-1-i), 99-i);
+      }
+
+      // a later attempt takes over the budget but the earlier result remains
+      SolveSteps *second = solve_col.newSolveSteps();
+      for (int i=0; i<100; i++) {
+        solve_col.appendStep(second, QSharedPointer<sp::Grid>(new sp::Grid(problem.cellGrid())));
+      }
+      QCOMPARE(solve_col.memoryUsed() <= solve_col.memoryBudget(), true);
+      QCOMPARE(solve_col[0].isEmpty(), false);
+      QCOMPARE(solve_col[0].stepIndex(solve_col[0].size()-1), 99);
+      QCOMPARE(solve_col[1].stepIndex(solve_col[1].size()-1), 99);
+    }
+
+    //! Test that connections store straight runs as single segments and 
+    //! iterate over the same cells they were given.
+    void testConnectionSegments()
+    {
+      QList<sp::Coord> cells;
+      for (int x=0; x<100; x++) {
+        cells.append(sp::Coord(x, 0));
+      }
+      for (int y=1; y<50; y++) {
+        cells.append(sp::Coord(99, y));
+      }
+      sp::Connection conn(qMakePair(sp::Coord(0,0), sp::Coord(99,49)), cells, 2);
+      QCOMPARE(conn.segments().size(), 2);
+      QCOMPARE(conn.cellCount(), cells.size());
+      QList<sp::Coord> iterated;
+      for (const sp::Coord &coord : conn) {
+        iterated.append(coord);
+      }
+      QCOMPARE(iterated, cells);
+      QCOMPARE(conn.routedCells(), cells);
+
+      // copies share the segment data
+      sp::Connection copy(conn);
+      QCOMPARE(copy.segments().constData(), conn.segments().constData());
+
+      sp::Connection empty;
+      QCOMPARE(empty.isEmpty(), true);
+      QCOMPARE(empty.begin() == empty.end(), true);
+    }
+
+    //! Test that segment encoding is lossless and that a written solution can
+    //! be read back and applied to the unrouted problem.
+    void testSolutionRoundTrip()
+    {
+      using namespace rt;
+
+      QList<sp::Coord> path = {sp::Coord(0,0), sp::Coord(1,0), sp::Coord(2,0),
+        sp::Coord(2,1), sp::Coord(2,2), sp::Coord(1,2), sp::Coord(5,5)};
+      QVector<sp::Segment> segs = sp::Segment::encode(path);
+      QCOMPARE(segs.size(), 4);
+      QCOMPARE(sp::Segment::decode(segs), path);
+
+      Problem problem;
+      QCOMPARE(loadProblem(":/test_problems/3_rows.infile", &problem), true);
+      RouteOutput output = routeProblem(problem, RouterSettings());
+      QCOMPARE(output.stats.success, true);
+
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      QString sol_path = tmp_dir.filePath("3_rows.rsol");
+      SolutionInfo info;
+      info.dim_x = problem.dimensions().x;
+      info.dim_y = problem.dimensions().y;
+      info.pin_sets = problem.pinSets();
+      info.stats = output.stats;
+      QCOMPARE(SolutionWriter::writeGrid(sol_path, info, output.grid.data()), true);
+
+      SolutionFile sol;
+      QString error;
+      QCOMPARE(sol.load(sol_path, &error), true);
+      QCOMPARE(sol.info().pin_sets, problem.pinSets());
+      QCOMPARE(sol.info().stats.segments, output.stats.segments);
+      QCOMPARE(sol.info().stats.time_ms, output.stats.time_ms);
+      QCOMPARE(sol.connectionCount(), output.connections.size());
+
+      sp::Grid grid(problem.cellGrid());
+      QCOMPARE(sol.applyToGrid(&grid, &error), true);
+      QCOMPARE(grid.allPinsRouted(), true);
+      QCOMPARE(grid.countCells({sp::RoutedCell}), output.stats.routed_cells);
+
+      // a solution that clashes with the grid must leave it untouched, even
+      // if only its last connection clashes
+      QVERIFY(sol.connectionCount() >= 2);
+      SolutionConnection last = sol.connection(sol.connectionCount()-1);
+      sp::Connection last_conn(last.pin_pair, last.segments, last.pin_set_id);
+      sp::Grid clash_grid(problem.cellGrid());
+      for (const sp::Coord &coord : last_conn) {
+        if (clash_grid.cellAt(coord)->getType() == sp::BlankCell) {
+          clash_grid.setCellType(coord, sp::ObsCell);
+          break;
+        }
+      }
+      int obs_cells = clash_grid.countCells({sp::ObsCell});
+      QCOMPARE(obs_cells, problem.cellGrid()->countCells({sp::ObsCell}) + 1);
+      QCOMPARE(sol.applyToGrid(&clash_grid, &error), false);
+      QCOMPARE(error.isEmpty(), false);
+      QCOMPARE(clash_grid.countCells({sp::RoutedCell}), 0);
+      QCOMPARE(clash_grid.countCells({sp::ObsCell}), obs_cells);
+      QCOMPARE(clash_grid.connMap()->isEmpty(), true);
+
+      // corrupt files must be rejected
+      QFile corrupt(tmp_dir.filePath("corrupt.rsol"));
+      QVERIFY(corrupt.open(QFile::WriteOnly));
+      corrupt.write("PSOL");
+      corrupt.close();
+      QCOMPARE(sol.load(corrupt.fileName(), &error), false);
+      // hand-crafted records must name a net of the file and of the grid,
+      // and join two of its pins
+      auto writeRecord = [&tmp_dir, &info](const QString &name,
+          const QList<sp::PinSet> &pin_sets, int pin_set_id, const sp::PinPair &pin_pair)
+      {
+        SolutionInfo crafted_info = info;
+        crafted_info.pin_sets = pin_sets;
+        SolutionWriter writer;
+        writer.open(tmp_dir.filePath(name), crafted_info);
+        SolutionConnection conn;
+        conn.pin_set_id = pin_set_id;
+        conn.pin_pair = pin_pair;
+        conn.segments = sp::Segment::encode({sp::Coord(1,0)});
+        writer.writeConnection(conn);
+        writer.finish();
+        return tmp_dir.filePath(name);
+      };
+      QList<sp::PinSet> pin_sets = problem.pinSets();
+      sp::PinPair net0_pair = qMakePair(pin_sets[0][0], pin_sets[0][1]);
+      sp::PinPair net1_pair = qMakePair(pin_sets[1][0], pin_sets[1][1]);
+      QCOMPARE(sol.load(writeRecord("huge_net.rsol", pin_sets, 0x7fffffff,
+              net0_pair), &error), false);
+      QCOMPARE(sol.load(writeRecord("negative_net.rsol", pin_sets, -1,
+              net0_pair), &error), false);
+      QCOMPARE(sol.load(writeRecord("wrong_pair.rsol", pin_sets, 0,
+              net1_pair), &error), false);
+      QCOMPARE(sol.load(writeRecord("ok_record.rsol", pin_sets, 0,
+              net0_pair), &error), true);
+
+      // a file from another problem may be consistent in itself
+      QList<sp::PinSet> swapped = {pin_sets[1], pin_sets[0]};
+      QCOMPARE(sol.load(writeRecord("foreign.rsol", swapped, 0, net1_pair),
+            &error), true);
+      sp::Grid foreign_grid(problem.cellGrid());
+      QCOMPARE(sol.applyToGrid(&foreign_grid, &error), false);
+      QCOMPARE(foreign_grid.countCells({sp::RoutedCell}), 0);
+      QCOMPARE(foreign_grid.connMap()->isEmpty(), true);
+    }
+
+    //! Test that rolling grids back and forth and creating and releasing 
+    //! connections reuses the grid's cell storage and connection pool once it
+    //! has warmed up. This doesn't count heap allocations: the connection map
+    //! and segment lists still allocate, testSearchAllocations covers searches.
+    void testGridPooling()
+    {
+      using namespace rt;
+
+      Problem problem;
+      QCOMPARE(loadProblem(":/test_problems/3_rows.infile", &problem), true);
+      RouteOutput output = routeProblem(problem, RouterSettings());
+      QCOMPARE(output.stats.success, true);
+      sp::Grid *routed = output.grid.data();
+      sp::Grid blank(problem.cellGrid());
+
+      // warm up with one rollback cycle
+      sp::Grid grid(routed);
+      grid.copyState(&blank);
+      grid.copyState(routed);
+      int block_count = grid.connectionPool().blockCount();
+      qint64 pool_footprint = grid.connectionPool().memoryFootprint();
+      const sp::Cell *storage = grid.cellStorage().constData();
+      for (int i=0; i<20; i++) {
+        grid.copyState(&blank);
+        QCOMPARE(grid.connMap()->isEmpty(), true);
+        QCOMPARE(grid.connectionPool().inUse(), 0);
+        grid.copyState(routed);
+        QCOMPARE(grid.allPinsRouted(), true);
+      }
+      QCOMPARE(grid.connectionPool().blockCount(), block_count);
+      QCOMPARE(grid.connectionPool().memoryFootprint(), pool_footprint);
+      QCOMPARE(grid.cellStorage().constData(), storage);
+
+      // released connections are handed out again
+      sp::PinPair pin_pair(problem.pinSets()[0][0], problem.pinSets()[0][1]);
+      for (int i=0; i<1000; i++) {
+        sp::Connection *conn = grid.newConnection(pin_pair, {}, 0);
+        grid.releaseConnection(conn);
+      }
+      QCOMPARE(grid.connectionPool().blockCount(), block_count);
+
+      // route lookups walk the grid in place
+      QList<sp::Coord> route;
+      QCOMPARE(grid.routeExistsBetweenPins(pin_pair.first, pin_pair.second, &route), true);
+      for (const sp::Coord &coord : route) {
+        QCOMPARE(grid.cellAt(coord)->pinSetId(), 0);
+      }
+      QCOMPARE(blank.routeExistsBetweenPins(pin_pair.first, pin_pair.second), false);
+    }
+
+    //! Test that searches on a warmed up grid don't allocate on the heap
+    //! beyond the route they return.
+    void testSearchAllocations()
+    {
+#ifndef __GLIBC__
+      QSKIP("Heap allocations are only counted with glibc.");
+#else
+      using namespace rt;
+
+      // the sink is walled off by obstructions at x=4, searches fail after
+      // exploring the left side
+      QVector<sp::Coord> wall;
+      for (int y=0; y<5; y++) {
+        wall.append(sp::Coord(4, y));
+      }
+      sp::Coord source(1, 2), sink(6, 2);
+      sp::Grid walled(8, 5, wall, {{source, sink}});
+      sp::Grid open(8, 5, {}, {{source, sink}});
+
+      AStarAlg a_star;
+      LeeMooreAlg lee_moore;
+      for (RoutingAlg *alg : QList<RoutingAlg*>({&a_star, &lee_moore})) {
+        // the first searches size the grid's and the algorithm's storage
+        for (int i=0; i<2; i++) {
+          QCOMPARE(alg->findRoute(source, sink, &walled, false).route_coords.isEmpty(), true);
+        }
+        alloc_count = 0;
+        count_allocs = true;
+        RouteResult result = alg->findRoute(source, sink, &walled, false);
+        count_allocs = false;
+        QCOMPARE(result.route_coords.isEmpty(), true);
+        QCOMPARE(alloc_count.load(), 0);
+      }
+
+      // a successful A* search only allocates the returned route
+      AStarAlg open_a_star;
+      QCOMPARE(open_a_star.findRoute(source, sink, &open, false).route_coords.isEmpty(), false);
+      alloc_count = 0;
+      count_allocs = true;
+      RouteResult result = open_a_star.findRoute(source, sink, &open, false);
+      count_allocs = false;
+      QCOMPARE(result.route_coords.isEmpty(), false);
+      QVERIFY(alloc_count.load() <= 2 * result.route_coords.size());
+#endif
+    }
+
+    //! Test that incremental rerouting reuses untouched connections and only
+    //! rips connections that clash with an edit.
+    void testIncrementalReroute()
+    {
+      using namespace rt;
+
+      Problem problem;
+      QCOMPARE(loadProblem(":/test_problems/3_rows.infile", &problem), true);
+      RouteOutput prior = routeProblem(problem, RouterSettings());
+      QCOMPARE(prior.stats.success, true);
+
+      // unchanged problem: everything is reused without any searching
+      RouteOutput same = rerouteProblem(problem, prior.connections, RouterSettings());
+      QCOMPARE(same.stats.success, true);
+      QCOMPARE(same.stats.kept_connections, prior.connections.size());
+      QCOMPARE(same.stats.invalidated_connections, 0);
+      QCOMPARE(same.stats.expansions, (qint64)0);
+
+      // two nets far apart, so that an edit to one can be rerouted without
+      // touching the other
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      auto writeProblem = [&tmp_dir](const QString &name,
+          const QList<sp::Coord> &obs_coords) -> QString
+      {
+        QFile file(tmp_dir.filePath(name));
+        if (!file.open(QFile::WriteOnly | QFile::Text)) {
+          return QString();
+        }
+        QTextStream stream(&file);
+        stream << "11 5\n" << obs_coords.size() << "\n";
+        for (const sp::Coord &coord : obs_coords) {
+          stream << coord.x << " " << coord.y << "\n";
+        }
+        stream << "2\n2 0 0 10 0\n2 0 4 10 4\n";
+        return file.fileName();
+      };
+      QCOMPARE(loadProblem(writeProblem("two_nets.infile", {}), &problem), true);
+      prior = routeProblem(problem, RouterSettings());
+      QCOMPARE(prior.stats.success, true);
+
+      // put an obstacle on a routed (non-pin) cell of the first net
+      sp::Coord obs(-1, -1);
+      for (const sp::Connection &conn : prior.connections) {
+        for (const sp::Coord &coord : conn.routedCells()) {
+          if (prior.grid->cellAt(coord)->getType() == sp::RoutedCell
+              && conn.pinSetId() == 0) {
+            obs = coord;
+          }
+        }
+      }
+      QVERIFY(obs.x >= 0);
+      Problem edited_problem;
+      QCOMPARE(loadProblem(writeProblem("two_nets_edited.infile", {obs}),
+            &edited_problem), true);
+
+      RouteOutput eco = rerouteProblem(edited_problem, prior.connections,
+          RouterSettings());
+      QCOMPARE(eco.stats.success, true);
+      QCOMPARE(eco.stats.invalidated_connections >= 1, true);
+      QCOMPARE(eco.stats.kept_connections >= 1, true);
+      QCOMPARE(eco.stats.kept_connections + eco.stats.invalidated_connections,
+          prior.connections.size());
+      QCOMPARE(eco.grid->cellAt(obs)->getType(), sp::ObsCell);
+
+      // the net outside of the edit keeps its connections as they were
+      auto netCells = [](const QList<sp::Connection> &conns, int pin_set_id)
+      {
+        QSet<sp::Coord> cells;
+        for (const sp::Connection &conn : conns) {
+          if (conn.pinSetId() == pin_set_id) {
+            for (const sp::Coord &coord : conn) {
+              cells.insert(coord);
+            }
+          }
+        }
+        return cells;
+      };
+      QCOMPARE(netCells(eco.connections, 1).isEmpty(), false);
+      QCOMPARE(netCells(eco.connections, 1), netCells(prior.connections, 1));
+    }
+
+
+    //! Test that malformed problem files are rejected with the offending
+    //! line number.
+    void testProblemParseErrors()
+    {
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      auto writeFile = [&tmp_dir](const QString &name, const QByteArray &contents)
+      {
+        QFile file(tmp_dir.filePath(name));
+        file.open(QFile::WriteOnly);
+        file.write(contents);
+        return file.fileName();
+      };
+
+      rt::Problem problem;
+      QCOMPARE(problem.readProblem(writeFile("ok.infile",
+              "4 3\r\n\n1\n 2  1 \n1\n2 0 0 3 2\n")), true);
+      QCOMPARE(problem.lastError().isEmpty(), true);
+      QCOMPARE(problem.isValid(), true);
+      QCOMPARE(problem.cellGrid()->countCells({sp::ObsCell}), 1);
+
+      QCOMPARE(problem.readProblem(writeFile("bad_obs.infile",
+              "4 3\n2\n1 1\n1 x\n1\n2 0 0 3 2\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 4:"), true);
+
+      QCOMPARE(problem.readProblem(writeFile("bad_pins.infile",
+              "4 3\n0\n1\n3 0 0 3 2\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 4:"), true);
+
+      QCOMPARE(problem.readProblem(writeFile("truncated.infile",
+              "4 3\n0\n2\n2 0 0 3 2\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 5:"), true);
+
+      // integers are read up to the limits of int, out of bounds coordinates
+      // are left to validation
+      QCOMPARE(problem.readProblem(writeFile("int_limits.infile",
+              "4 3\n0\n1\n2 -2147483648 0 2147483647 2\n")), true);
+      QCOMPARE(problem.pinSets().first().first(), sp::Coord(INT_MIN, 0));
+      QCOMPARE(problem.pinSets().first().last(), sp::Coord(INT_MAX, 2));
+      QCOMPARE(problem.isValid(), false);
+      QCOMPARE(problem.readProblem(writeFile("int_underflow.infile",
+              "4 3\n0\n1\n2 -2147483649 0 3 2\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 4:"), true);
+      QCOMPARE(problem.readProblem(writeFile("int_overflow.infile",
+              "4 3\n0\n1\n2 2147483648 0 3 2\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 4:"), true);
+
+      // huge counts fail on the missing entries instead of reserving for them
+      QCOMPARE(problem.readProblem(writeFile("huge_obs.infile",
+              "4 3\n2000000000\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 3:"), true);
+      QCOMPARE(problem.readProblem(writeFile("huge_pin_sets.infile",
+              "4 3\n0\n2000000000\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 4:"), true);
+      QCOMPARE(problem.readProblem(writeFile("huge_pins.infile",
+              "4 3\n0\n1\n2000000000 0 0\n")), false);
+      QCOMPARE(problem.lastError().startsWith("Line 4:"), true);
+    }
+
+    //! Test that validation catches clashes, duplicate and shared pins and
+    //! grids too large to hold.
+    void testProblemValidation()
+    {
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      auto validate = [&tmp_dir](const QByteArray &contents, QString *error)
+      {
+        QFile file(tmp_dir.filePath("validate.infile"));
+        file.open(QFile::WriteOnly | QFile::Truncate);
+        file.write(contents);
+        file.close();
+        rt::Problem problem;
+        problem.readProblem(file.fileName());
+        *error = problem.validationError();
+        return problem.isValid();
+      };
+
+      QString error;
+      QCOMPARE(validate("4 3\n2\n1 0\n1 1\n2\n2 0 0 3 2\n2 0 1 3 1\n", &error), true);
+      QCOMPARE(error.isEmpty(), true);
+      // pin on an obstruction cell
+      QCOMPARE(validate("4 3\n2\n1 0\n1 1\n1\n2 1 1 3 2\n", &error), false);
+      QCOMPARE(error.contains("obstruction"), true);
+      // out of bounds
+      QCOMPARE(validate("4 3\n1\n4 0\n1\n2 0 0 3 2\n", &error), false);
+      QCOMPARE(error.contains("out of bounds"), true);
+      // duplicate pin within a net
+      QCOMPARE(validate("4 3\n0\n1\n3 0 0 3 2 0 0\n", &error), false);
+      QCOMPARE(error.contains("more than once"), true);
+      // pin shared across nets
+      QCOMPARE(validate("4 3\n0\n2\n2 0 0 3 2\n2 3 2 2 2\n", &error), false);
+      QCOMPARE(error.contains("shared"), true);
+      // more cells than a grid can hold
+      QCOMPARE(validate("20000 20000\n0\n1\n2 0 0 3 2\n", &error), false);
+      QCOMPARE(error.contains(QString::number(sp::Grid::maxCells())), true);
+    }
+
+    //! Test that batch mode writes a JSON line per problem and only exits
+    //! successfully if every problem could be read and is valid.
+    void testBatchMode()
+    {
+      using namespace cli;
+
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      QString invalid_path = tmp_dir.filePath("invalid.infile");
+      QFile invalid_file(invalid_path);
+      QVERIFY(invalid_file.open(QFile::WriteOnly));
+      // pin on an obstruction cell
+      invalid_file.write("4 3\n2\n1 0\n1 1\n1\n2 1 1 3 2\n");
+      invalid_file.close();
+      QStringList valid_paths = {":/test_problems/3_rows.infile",
+        ":/test_problems/3_rows_w_obs.infile", ":/test_problems/straight_line.infile",
+        ":/test_problems/straight_line_w_obs.infile"};
+      QString missing_path = tmp_dir.filePath("missing.infile");
+
+      auto runBatch = [](const QStringList &in_paths, QMap<QString,QJsonObject> *lines)
+      {
+        QString out_str;
+        QTextStream out(&out_str);
+        BatchRunner runner(rt::RouterSettings(), 2);
+        QList<BatchResult> results = runner.run(in_paths, out);
+        lines->clear();
+        for (const QString &line : out_str.split('\n', QString::SkipEmptyParts)) {
+          QJsonObject obj = QJsonDocument::fromJson(line.toUtf8()).object();
+          lines->insert(obj["in_path"].toString(), obj);
+        }
+        return BatchRunner::exitCode(results);
+      };
+
+      // valid problems only, the ones with obstructions are unroutable but
+      // that doesn't fail the batch
+      QMap<QString,QJsonObject> lines;
+      QCOMPARE(runBatch(valid_paths, &lines), 0);
+      QCOMPARE(lines.size(), valid_paths.size());
+      for (const QString &path : valid_paths) {
+        QCOMPARE(lines[path]["loaded"].toBool(), true);
+        QCOMPARE(lines[path]["valid"].toBool(), true);
+        QCOMPARE(lines[path]["success"].toBool(), !path.contains("_w_obs"));
+      }
+
+      // an invalid problem fails the batch but the others are still routed
+      QCOMPARE(runBatch(valid_paths + QStringList({invalid_path}), &lines), 1);
+      QCOMPARE(lines.size(), valid_paths.size() + 1);
+      QCOMPARE(lines[invalid_path]["loaded"].toBool(), true);
+      QCOMPARE(lines[invalid_path]["valid"].toBool(), false);
+      QCOMPARE(lines[invalid_path]["error"].toString().contains("obstruction"), true);
+      QCOMPARE(lines[valid_paths.first()]["success"].toBool(), true);
+
+      // so does an unreadable one
+      QCOMPARE(runBatch(valid_paths + QStringList({missing_path}), &lines), 1);
+      QCOMPARE(lines[missing_path]["loaded"].toBool(), false);
+      QCOMPARE(lines[missing_path]["error"].toString().isEmpty(), false);
+    }
+
+    //! Test that problem copies share the description but route on grids of
+    //! their own.
+    void testProblemCopies()
+    {
+      rt::Problem problem;
+      QCOMPARE(problem.readProblem(":/test_problems/3_rows.infile"), true);
+      sp::Coord blank(5, 0);
+      QCOMPARE(problem.cellGrid()->cellAt(blank)->getType(), sp::BlankCell);
+      problem.cellGrid()->setCellType(blank, sp::RoutedCell);
+
+      // copies start from the unrouted grid
+      rt::Problem copied(problem);
+      rt::Problem assigned;
+      assigned = problem;
+      QCOMPARE(copied.isValid(), true);
+      QCOMPARE(copied.pinSets(), problem.pinSets());
+      QCOMPARE(copied.cellGrid()->cellAt(blank)->getType(), sp::BlankCell);
+      QCOMPARE(assigned.cellGrid()->cellAt(blank)->getType(), sp::BlankCell);
+
+      // and changes to them don't leak back
+      copied.cellGrid()->setCellType(blank, sp::ObsCell);
+      QCOMPARE(problem.cellGrid()->cellAt(blank)->getType(), sp::RoutedCell);
+      QCOMPARE(assigned.cellGrid()->cellAt(blank)->getType(), sp::BlankCell);
+    }
+
+    //! Test conversion between the text and binary problem formats.
+    void testBinaryProblemFormat()
+    {
+      using namespace rt;
+
+      Problem problem;
+      QCOMPARE(problem.readProblem(":/sample_problems/stdcell.infile"), true);
+      int obs_count = problem.cellGrid()->countCells({sp::ObsCell});
+
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      QString bin_path = tmp_dir.filePath("stdcell.pbin");
+      QString text_path = tmp_dir.filePath("stdcell.infile");
+      QCOMPARE(Problem::formatForPath(bin_path), Problem::BinaryFormat);
+      QCOMPARE(problem.writeProblem(bin_path, Problem::BinaryFormat), true);
+
+      // the binary format is detected and yields the same problem
+      Problem bin_problem;
+      QCOMPARE(bin_problem.readProblem(bin_path), true);
+      QCOMPARE(bin_problem.isValid(), true);
+      QCOMPARE(bin_problem.dimensions(), problem.dimensions());
+      QCOMPARE(bin_problem.pinSets(), problem.pinSets());
+      QCOMPARE(bin_problem.cellGrid()->countCells({sp::ObsCell}), obs_count);
+
+      // and converts back to text
+      QCOMPARE(bin_problem.writeProblem(text_path, Problem::TextFormat), true);
+      Problem text_problem;
+      QCOMPARE(text_problem.readProblem(text_path), true);
+      QCOMPARE(text_problem.pinSets(), problem.pinSets());
+      QCOMPARE(text_problem.cellGrid()->countCells({sp::ObsCell}), obs_count);
+
+      // truncated binary files are rejected
+      QFile bin_file(bin_path);
+      QVERIFY(bin_file.open(QFile::ReadWrite));
+      QVERIFY(bin_file.resize(bin_file.size() - 4));
+      bin_file.close();
+      QCOMPARE(bin_problem.readProblem(bin_path), false);
+      QCOMPARE(bin_problem.lastError().isEmpty(), false);
+    }
+
+    //! Test that generated problems are valid, follow the generator settings
+    //! and are reproducible from their seed.
+    void testProblemGenerator()
+    {
+      using namespace rt;
+
+      GeneratorSettings settings;
+      settings.dim_x = 300;
+      settings.dim_y = 200;
+      settings.obs_density = 0.2;
+      settings.obs_clustering = 0.5;
+      settings.net_count = 40;
+      settings.min_pins = 2;
+      settings.max_pins = 5;
+      settings.min_span = 4;
+      settings.max_span = 32;
+      settings.span_dist = GeneratorSettings::UniformSpan;
+      settings.seed = 7;
+
+      Problem problem;
+      QCOMPARE(ProblemGenerator::generate(settings, &problem), true);
+      QCOMPARE(problem.isValid(), true);
+      QCOMPARE(problem.dimensions(), sp::Coord(300, 200));
+      QCOMPARE(problem.cellGrid()->countCells({sp::ObsCell}), (int)(0.2*300*200));
+      QCOMPARE(problem.pinSets().size() > 30, true);
+      for (const sp::PinSet &pin_set : problem.pinSets()) {
+        QCOMPARE(pin_set.size() >= 2 && pin_set.size() <= 5, true);
+        int min_x = pin_set.first().x, max_x = min_x;
+        int min_y = pin_set.first().y, max_y = min_y;
+        for (const sp::Coord &pin : pin_set) {
+          min_x = qMin(min_x, pin.x);
+          max_x = qMax(max_x, pin.x);
+          min_y = qMin(min_y, pin.y);
+          max_y = qMax(max_y, pin.y);
+        }
+        QCOMPARE(max_x - min_x < 32 && max_y - min_y < 32, true);
+      }
+
+      // the same seed yields the same problem, also after a round trip
+      // through the binary format
+      QTemporaryDir tmp_dir;
+      QVERIFY(tmp_dir.isValid());
+      QString bin_path = tmp_dir.filePath("generated.pbin");
+      QCOMPARE(ProblemGenerator::generateFile(settings, bin_path), true);
+      Problem bin_problem;
+      QCOMPARE(bin_problem.readProblem(bin_path), true);
+      QCOMPARE(bin_problem.pinSets(), problem.pinSets());
+      QCOMPARE(bin_problem.cellGrid()->countCells({sp::ObsCell}),
+          problem.cellGrid()->countCells({sp::ObsCell}));
+      settings.seed = 8;
+      Problem other;
+      QCOMPARE(ProblemGenerator::generate(settings, &other), true);
+      QCOMPARE(other.pinSets() == problem.pinSets(), false);
+
+      // out of range settings are rejected
+      settings.obs_density = 0.95;
+      QString error;
+      QCOMPARE(ProblemGenerator::generate(settings, &other, &error), false);
+      QCOMPARE(error.isEmpty(), false);
+    }
+
+    //! Test that the cells reported as changed by a routed grid are enough
+    //! to keep a replica of it up to date after every router step.
+    void testChangedCells()
+    {
+      using namespace rt;
+
+      Problem problem(":/sample_problems/kuma.infile");
+      sp::Grid *grid = problem.cellGrid();
+      QCOMPARE(grid->takeChangedCells().all, true);  // untracked
+      grid->setChangeTracking(true);
+      QCOMPARE(grid->takeChangedCells().all, true);
+      QCOMPARE(grid->takeChangedCells().isEmpty(), true);
+
+      RouterSettings settings;
+      settings.log_level = LogNone;
+      settings.gui_update_level = VisualizeAllIntermediate;
+      Router router(problem, settings);
+      sp::Grid replica(grid);
+      int partial_updates = 0;
+      bool in_sync = true;
+      connect(router.recordKeeper(), &RoutingRecords::routerStep,
+          [&](sp::Grid *step_grid)
+          {
+            sp::ChangedCells changed = step_grid->takeChangedCells();
+            if (changed.all) {
+              replica.copyState(step_grid);
+            } else {
+              partial_updates++;
+              for (const sp::Coord &coord : changed.coords) {
+                sp::Cell *cell = step_grid->cellAt(coord);
+                replica.setCellType(coord, cell->getType(), cell->pinSetId());
+                replica.setWorkingValue(coord, step_grid->workingValue(coord));
+              }
+            }
+            for (const sp::Cell &cell : step_grid->cellStorage()) {
+              sp::Cell *other = replica.cellAt(cell.getCoord());
+              in_sync &= other->getType() == cell.getType()
+                && other->pinSetId() == cell.pinSetId()
+                && replica.workingValue(cell.getCoord())
+                  == step_grid->workingValue(cell.getCoord());
+            }
+          });
+      CancelToken soft_halt;
+      router.routeSuite(problem.pinSets(), grid, &soft_halt, nullptr);
+      QCOMPARE(in_sync, true);
+      QCOMPARE(partial_updates > 0, true);
+    }
+
+    //! Test that grid tiles rasterize the covered cells and only report
+    //! changes for the cells that they cover.
+    void testGridTiles()
+    {
+      using namespace gui;
+
+      rt::Problem problem(":/sample_problems/kuma.infile");
+      GridTile::num_pin_sets = problem.pinSets().size();
+      sp::Grid grid(problem.cellGrid());
+      sp::Coord dims = grid.dimensions();
+      sp::Coord half(dims.x/2, dims.y);
+      GridTile left(sp::Coord(0, 0), half);
+      GridTile right(sp::Coord(half.x, 0), sp::Coord(dims.x-half.x, dims.y));
+      left.updateFromGrid(&grid);
+      right.updateFromGrid(&grid);
+      for (int x=0; x<dims.x; x++) {
+        for (int y=0; y<dims.y; y++) {
+          sp::Cell *cell = grid.cellAt(sp::Coord(x, y));
+          QRgb expected = GridTile::cellColor(cell->getType(), cell->pinSetId()).rgb();
+          QRgb pixel = (x < half.x) ? left.image().pixel(x, y)
+            : right.image().pixel(x-half.x, y);
+          QCOMPARE(pixel, expected);
+        }
+      }
+      QCOMPARE(left.updateFromGrid(&grid), false);
+
+      // obstruct a blank cell on the right
+      sp::Coord blank(-1, -1);
+      for (int x=dims.x-1; x>=half.x && blank.x < 0; x--) {
+        for (int y=0; y<dims.y; y++) {
+          if (grid.cellAt(sp::Coord(x, y))->getType() == sp::BlankCell) {
+            blank = sp::Coord(x, y);
+            break;
+          }
+        }
+      }
+      QVERIFY(blank.x >= 0);
+      grid.setCellType(blank, sp::ObsCell);
+      QCOMPARE(left.updateFromGrid(&grid), false);
+      QCOMPARE(right.updateFromGrid(&grid), true);
+      QCOMPARE(right.image().pixel(blank.x-half.x, blank.y),
+          GridTile::cellColor(sp::ObsCell, -1).rgb());
+      QCOMPARE(right.updateFromGrid(&grid), false);
+    }
+
+    //! Test that zoomed out tiles average blocks of cells and refresh those
+    //! averages when cells change.
+    void testTileAggregation()
+    {
+      using namespace gui;
+
+      QCOMPARE(GridTile::aggregationLevel(50), 0);
+      QCOMPARE(GridTile::aggregationLevel(1), 0);
+      QCOMPARE(GridTile::aggregationLevel(0.5), 1);
+      QCOMPARE(GridTile::aggregationLevel(0.3), 2);
+      QCOMPARE(1 << GridTile::aggregationLevel(1e-6), (int)GridTile::tile_cells);
+
+      // obstruct the left half of a 4x4 grid
+      sp::Grid grid(4, 4, {sp::Coord(0,0), sp::Coord(0,1), sp::Coord(0,2),
+          sp::Coord(0,3), sp::Coord(1,0), sp::Coord(1,1), sp::Coord(1,2),
+          sp::Coord(1,3)});
+      GridTile tile(sp::Coord(0, 0), grid.dimensions());
+      tile.updateFromGrid(&grid);
+      QRgb obs_col = GridTile::cellColor(sp::ObsCell, -1).rgb();
+      QRgb blank_col = GridTile::cellColor(sp::BlankCell, -1).rgb();
+      QImage agg = tile.aggregatedImage(1);
+      QCOMPARE(agg.size(), QSize(2, 2));
+      QCOMPARE(agg.pixel(0, 1), obs_col);
+      QCOMPARE(agg.pixel(1, 1), blank_col);
+      QCOMPARE(tile.aggregatedImage(2).size(), QSize(1, 1));
+
+      // the cached averages follow changes
+      for (int y=0; y<4; y++) {
+        grid.setCellType(sp::Coord(2, y), sp::ObsCell);
+        grid.setCellType(sp::Coord(3, y), sp::ObsCell);
+      }
+      tile.updateFromGrid(&grid);
+      QCOMPARE(tile.aggregatedImage(1).pixel(1, 1), obs_col);
+      QCOMPARE(tile.aggregatedImage(2).pixel(0, 0), obs_col);
+    }
+
     //! Test that color generator doesn't crash with the inclusion of more 
     //! colors than the default thresholds.
     void testColorGeneration()